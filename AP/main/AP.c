@@ -6,13 +6,36 @@
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
-#include "nvs_flash.h"
 #include "esp_netif.h"
 #include "lwip/err.h"
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
 #include "lwip/netdb.h"
+#include "esp_timer.h"
+#include "admission.h"
+#include "allowlist.h"
+#include "beacon_tracker.h"
+#include "chan_monitor.h"
+#include "dhcp_guard.h"
+#include "ids.h"
+#include "ids_workers.h"
+#include "ingress_filter.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "metrics_http.h"
+#include "msg_dedup.h"
+#include "payload_sketch.h"
+#include "pcap_stream.h"
+#include "profiler.h"
+#include "sta_slots.h"
+#include "sys_monitor.h"
+#include "task_layout.h"
+#include "time_base.h"
+#include "timer_wheel.h"
+#include "wifi_common.h"
+#include "wifi_sniffer.h"
 
 // Configurações do AP
 #define AP_SSID "ESP32_AP"
@@ -25,231 +48,272 @@
 #define TCP_KEEPALIVE_IDLE 5
 #define TCP_KEEPALIVE_INTERVAL 5
 #define TCP_KEEPALIVE_COUNT 3
+#define TCP_MAX_CONNECTIONS 1   // a tcp_server_task atende uma conexão por vez
+#define TCP_LISTEN_BACKLOG 4    // folga para clientes legítimos enquanto o flood é recusado
+#define TCP_RX_BUFFER_SIZE 128
+#define TCP_BATCH_RECV_TIMEOUT_S 2  // lote da fila de saída sem fechamento da escrita
+#define TCP_BATCH_DEADLINE_MS 5000  // duração máxima de um lote: o servidor atende uma conexão por vez
+#define TCP_BATCH_MAX_RECORDS 16    // registros por lote (o CLIENTS manda até OUTBOX_BATCH_SIZE = 8)
+#define TCP_BATCH_MAX_BYTES 2048    // bytes por lote (8 registros de até ~124 bytes)
 
 #define MAX_DISCONNECTIONS_PER_SECOND 5
 #define MAX_AUTH_ATTEMPTS_PER_SECOND 8
+#ifndef MAX_PACKETS_PER_CLIENT
 #define MAX_PACKETS_PER_CLIENT 30
+#endif
 #define BLACKLIST_DURATION_MS 300000
-#define MAX_BLACKLIST_ENTRIES 10
 
-typedef struct {
-    uint8_t mac[6];
-    uint32_t blocked_until;
-    uint8_t attack_type; // 1=deauth, 2=auth, 3=packet
-    bool active;
-} blacklist_entry_t;
+// Atividade TCP por cliente na janela de RATE_WINDOW_MS (ids_client_activity; 0 desliga o limite)
+#ifndef MAX_BYTES_IN_PER_CLIENT
+#define MAX_BYTES_IN_PER_CLIENT 4096            // 30 registros de lote cheios cabem
+#endif
+#ifndef MAX_BYTES_OUT_PER_CLIENT
+#define MAX_BYTES_OUT_PER_CLIENT 8192           // ecos de até 256 bytes
+#endif
+#ifndef MAX_CONNECTIONS_PER_CLIENT
+#define MAX_CONNECTIONS_PER_CLIENT 10           // inclui as recusadas por taxa na admissão (que aceita 4/s)
+#endif
+#ifndef MAX_EMPTY_CONNECTIONS_PER_CLIENT
+#define MAX_EMPTY_CONNECTIONS_PER_CLIENT 5      // fechadas sem nenhum byte recebido
+#endif
+#ifndef MAX_RECV_ERRORS_PER_CLIENT
+#define MAX_RECV_ERRORS_PER_CLIENT 5
+#endif
 
-typedef struct {
-    uint8_t mac[6];
-    uint32_t last_packet_time;
-    int packet_count;
-    int tcp_connections;
-    bool active;
-} client_monitor_t;
+// Relatório periódico no UART (o endpoint /metrics é a fonte principal de métricas)
+#define METRICS_HTTP_ENABLED 1
+#ifndef STATUS_LOG_INTERVAL_MS
+#define STATUS_LOG_INTERVAL_MS 60000
+#endif
+
+// Captura de quadros de gerenciamento em PCAPNG pela UART dedicada (ver pcap_stream.h)
+#ifndef PCAP_CAPTURE_ENABLED
+#define PCAP_CAPTURE_ENABLED 0
+#endif
+
+// Rastreador de beacons (AP falso / evil twin) no canal do AP, ver beacon_tracker.h
+#ifndef BEACON_TRACKER_ENABLED
+#define BEACON_TRACKER_ENABLED 1
+#endif
+#define AP_BEACON_INTERVAL_TU 100           // padrão do driver (wifi_ap_config_t.beacon_interval)
+#define BEACON_TRACKER_MAX_AGE_MS 120000    // BSSID sem beacon por este tempo libera a entrada
+
+// Placa sensora: STA sem conexão saltando entre canais (ver chan_monitor.h).
+// Sem softAP, servidor TCP ou HTTP; os quadros alimentam o mesmo núcleo do IDS.
+#ifndef CHANNEL_MONITOR_ENABLED
+#define CHANNEL_MONITOR_ENABLED 0
+#endif
+#ifndef CHANNEL_MONITOR_MASK
+#define CHANNEL_MONITOR_MASK CHAN_MONITOR_ALL_CHANNELS
+#endif
+#define CHANNEL_MONITOR_BASE_DWELL_MS 200
+#define CHANNEL_MONITOR_MAX_DWELL_MS 1000
+#define CHANNEL_MONITOR_BOOST_MS 20          // permanência extra por quadro suspeito recente
+#define CHANNEL_MONITOR_ALERT_THRESHOLD 10   // quadros suspeitos numa visita
+
+// Janelas e expirações do IDS (timer wheel em components/ids, tick de IDS_TICK_MS)
+#define RATE_WINDOW_MS 1000
+#define MONITOR_IDLE_TIMEOUT_MS 60000 // cliente sem pacotes por este tempo sai do monitor
+
+// Slots de associação: STA_SLOTS_RESERVED ficam para as estações confiáveis (ver sta_slots.h)
+_Static_assert(STA_SLOTS_MAX_STA == AP_MAX_STA_CONN, "STA_SLOTS_MAX_STA diferente de AP_MAX_STA_CONN");
+_Static_assert(DHCP_GUARD_POOL_SIZE == AP_MAX_STA_CONN, "DHCP_GUARD_POOL_SIZE diferente de AP_MAX_STA_CONN");
 
+// Uma entrada de monitor por estação em cada shard; a blacklist tem IDS_BLACKLIST_CAPACITY entradas por shard
+_Static_assert(IDS_MONITOR_CAPACITY >= AP_MAX_STA_CONN, "IDS_MONITOR_CAPACITY menor que AP_MAX_STA_CONN");
+
+// Contexto de uma conexão TCP aceita (vem do pool, não da pilha da task)
 typedef struct {
-    uint32_t last_auth_time;
-    int auth_attempts;
-    int connections;
-    int disconnections;
-} security_stats_t;
+    int sock;
+    struct sockaddr_in addr;
+    uint8_t mac[6];
+    bool trusted;       // IP com lease de uma estação da allowlist: sem admissão nem packet flood
+    ids_client_activity_t activity;     // bytes, erros e desfecho ainda não relatados ao IDS
+    char rx_buffer[TCP_RX_BUFFER_SIZE];
+} tcp_conn_t;
 
 static const char *TAG = "AP_MODE";
 
 static int connected_clients = 0;
-static int tcp_clients_served = 0;
 
-static security_stats_t security_stats = {0};
-static blacklist_entry_t blacklist[MAX_BLACKLIST_ENTRIES];
-static client_monitor_t client_monitors[AP_MAX_STA_CONN];
+MEM_POOL_DEFINE(conn_pool, tcp_conn_t, TCP_MAX_CONNECTIONS, "tcp_conn");
+
+// Estado do IDS: cada shard pertence a uma task worker (ids_workers.c), sem mutex global
+static tw_timer_t stats_report_timer;
+static esp_timer_handle_t ids_tick_timer;
+static TaskHandle_t ap_report_task_handle;
+static bool stats_report_due = false;
+
+static metric_t *m_connected_clients;
+static metric_t *m_tcp_messages;
+static metric_t *m_blocked_connections;
+static metric_t *m_trusted_connections;
+static metric_t *m_trusted_tcp;
+static metric_t *m_batch_limited;
+static metric_t *m_deauth_latency;
+static metric_t *m_auth_latency;
+static metric_t *m_packet_latency;
 
-static int deauth_floods_detected = 0;
-static int auth_floods_detected = 0;
-static int packet_floods_detected = 0;
+// Limites (em µs) dos histogramas de latência dos detectores
+static const uint32_t detector_latency_bounds_us[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+#define DETECTOR_LATENCY_BUCKETS (sizeof(detector_latency_bounds_us) / sizeof(detector_latency_bounds_us[0]))
 
-bool is_mac_blacklisted(uint8_t* mac)
+static void ap_metrics_init(void)
 {
     /*
-    @brief Verifica se um MAC address está na blacklist se o tempo expirou ele retira a blacklist.
-    @param mac MAC address a ser verificado
-
+    @brief Registra as métricas do AP no registro compartilhado.
+    @note Os nomes seguem o padrão usado pelas outras apps (sufixo _total para contadores).
+    @note Os contadores e gauges ids_* são registrados pelo núcleo do IDS (ids_init).
     */
-    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    
-    for (int i = 0; i < MAX_BLACKLIST_ENTRIES; i++) {
-        if (blacklist[i].active) {
-            if (current_time < blacklist[i].blocked_until) {
-                if (memcmp(blacklist[i].mac, mac, 6) == 0) {
-                    return true;
-                }
-            } else {
-                blacklist[i].active = false;
-                ESP_LOGI(TAG, "\n\n\nMAC %02x:%02x:%02x:%02x:%02x:%02x removido da blacklist (expirou)",
-                         blacklist[i].mac[0], blacklist[i].mac[1], blacklist[i].mac[2],
-                         blacklist[i].mac[3], blacklist[i].mac[4], blacklist[i].mac[5]);
-            }
-        }
-    }
-    return false;
+    m_connected_clients = metrics_gauge("ap_connected_clients", "Clientes conectados ao AP");
+    m_tcp_messages = metrics_counter("ap_tcp_messages_total", "Mensagens TCP processadas");
+    m_blocked_connections = metrics_counter("ids_blocked_connections_total", "Conexoes de MACs bloqueados recusadas");
+    m_trusted_connections = metrics_counter("ap_trusted_associations_total", "Associacoes de estacoes da allowlist");
+    m_trusted_tcp = metrics_counter("ap_trusted_tcp_connections_total", "Conexoes TCP de estacoes da allowlist");
+    m_batch_limited = metrics_counter("ap_batch_limited_total", "Lotes encerrados por prazo, registros ou bytes");
+    m_deauth_latency = metrics_histogram("ids_deauth_detect_latency_us", "Latencia da deteccao de deauth flood",
+                                         detector_latency_bounds_us, DETECTOR_LATENCY_BUCKETS);
+    m_auth_latency = metrics_histogram("ids_auth_detect_latency_us", "Latencia da deteccao de auth flood",
+                                       detector_latency_bounds_us, DETECTOR_LATENCY_BUCKETS);
+    m_packet_latency = metrics_histogram("ids_packet_detect_latency_us", "Latencia da deteccao de packet flood",
+                                         detector_latency_bounds_us, DETECTOR_LATENCY_BUCKETS);
+}
+
+static bool ids_mac_is_ip_derived(const uint8_t *mac)
+{
+    // Clientes TCP são identificados por um MAC derivado do IP (02:00:<ip>)
+    return mac[0] == 0x02 && mac[1] == 0x00;
+}
+
+static void client_mac_from_ip(uint32_t client_ip, uint8_t *mac)
+{
+    // IP de origem (s_addr) -> MAC 02:00:<ip> usado pelo IDS
+    mac[0] = 0x02;
+    mac[1] = 0x00;
+    mac[2] = (client_ip >> 24) & 0xFF;
+    mac[3] = (client_ip >> 16) & 0xFF;
+    mac[4] = (client_ip >> 8) & 0xFF;
+    mac[5] = client_ip & 0xFF;
+}
+
+static uint32_t ids_mac_to_ip(const uint8_t *mac)
+{
+    // Inverso de client_mac_from_ip (mesma ordem de bytes de s_addr)
+    return ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
 }
 
-void add_to_blacklist(uint8_t* mac, uint8_t attack_type)
+static void ids_block_cb(const uint8_t *mac, ids_attack_t attack, void *ctx)
 {
     /*
-    @brief Adiciona um MAC address à blacklist com o tipo de ataque e tempo de bloqueio.
-    @param mac MAC address a ser adicionado
-    @param attack_type Tipo de ataque (1=deauth, 2=auth, 3=packet)
-    @note O tempo de bloqueio é fixo em BLACKLIST_DURATION
+    @brief Gancho do IDS para cada nova entrada da blacklist.
+    @note Executa no worker do shard do MAC. Espelha o bloqueio no filtro do lwIP
+    (thread-safe): o tráfego IP do atacante para antes do TCP.
+    @note Estações da allowlist (ou o IP de uma delas) nunca vão para o filtro nem
+    perdem o lease, mesmo que algum detector as tenha bloqueado no IDS.
     */
-    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    
-    for (int i = 0; i < MAX_BLACKLIST_ENTRIES; i++) {
-        if (blacklist[i].active && memcmp(blacklist[i].mac, mac, 6) == 0) {
-            // Atualizar tempo e tipo de ataque
-            blacklist[i].blocked_until = current_time + BLACKLIST_DURATION_MS;
-            blacklist[i].attack_type = attack_type;
-            ESP_LOGI(TAG, "\n\n\nMAC ja bloqueado - tempo atualizado");
-            return;
-        }
+    bool ip_derived = ids_mac_is_ip_derived(mac);
+    if (allowlist_contains(mac) || (ip_derived && dhcp_guard_ip_trusted(ids_mac_to_ip(mac)))) {
+        return;
     }
-    
-    for (int i = 0; i < MAX_BLACKLIST_ENTRIES; i++) {
-        if (!blacklist[i].active) {
-            memcpy(blacklist[i].mac, mac, 6);
-            blacklist[i].blocked_until = current_time + BLACKLIST_DURATION_MS;
-            blacklist[i].attack_type = attack_type;
-            blacklist[i].active = true;
-            
-            const char* attack_names[] = {"UNKNOWN", "DEAUTH_FLOOD", "AUTH_FLOOD", "PACKET_FLOOD"};
-            
-            ESP_LOGI(TAG, "\n\n\nMAC %02x:%02x:%02x:%02x:%02x:%02x bloqueado por %s (%d seg)",
-                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
-                     attack_names[attack_type], BLACKLIST_DURATION_MS/1000);
-            
-            // Desautenticar o cliente
-            esp_wifi_deauth_sta(0);
-            break;
-        }
+
+    ingress_filter_block_mac(mac);
+    if (ip_derived) {
+        ingress_filter_block_ip(ids_mac_to_ip(mac));
     }
+    dhcp_guard_release(mac, DHCP_GUARD_RELEASE_BLACKLIST);
 }
 
-bool detect_deauth_flood(uint8_t* mac)
+static void ids_unblock_cb(const uint8_t *mac, void *ctx)
 {
     /*
-    @brief Detecta flood de desconexões (ataque deauth).
-    @param mac MAC address do cliente que está desconectando
-    @return true se flood detectado, false caso contrário
-    @note Utiliza um contador de desconexões por segundo. Se exceder o limite, considera flood.
-    @note Reseta o contador se não houver desconexões por mais de 1 segundo
+    @brief Gancho do IDS quando um bloqueio vence.
+    @note Executa no worker do shard do MAC (dentro de ids_advance_shard).
     */
-    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    static uint32_t last_disconnection_time = 0;
-    static int disconnections_count = 0;
-    
-    // Resetar contador se passou mais de 1 segundo
-    if (current_time - last_disconnection_time > 1000) {
-        disconnections_count = 0;
-        last_disconnection_time = current_time;
+    ESP_LOGI(TAG, "\n\n\nMAC %02x:%02x:%02x:%02x:%02x:%02x removido da blacklist (expirou)",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    ingress_filter_unblock_mac(mac);
+    if (ids_mac_is_ip_derived(mac)) {
+        ingress_filter_unblock_ip(ids_mac_to_ip(mac));
     }
-    
-    disconnections_count++;
-    
-    if (disconnections_count > MAX_DISCONNECTIONS_PER_SECOND) {
-        ESP_LOGI(TAG, "\n\n\nDEAUTH FLOOD DETECTADO! %d desconexoes em 1s (limite: %d)", 
-                 disconnections_count, MAX_DISCONNECTIONS_PER_SECOND);
-        deauth_floods_detected++;
-        return true;
-    }
-    
-    return false;
 }
 
-bool detect_auth_flood(void)
+static void stats_report_cb(tw_timer_t *timer, void *arg)
+{
+    // Roda no worker do shard 0; o relatório é impresso pela ap_report_task no próximo tick
+    __atomic_store_n(&stats_report_due, true, __ATOMIC_RELEASE);
+    timer_wheel_schedule(ids_timer_wheel(0), timer, IDS_MS_TO_TICKS(STATUS_LOG_INTERVAL_MS));
+}
+
+static void ap_deauth_station(const uint8_t *mac, uint16_t aid)
 {
     /*
-    @brief Detecta Auth Flood ( ataque de autenticação)
-    @note Utiliza um contador de tentativas de autenticação por segundo. Se exceder o limite, considera flood.
-    @note Reseta o contador se não houver tentativas de autenticação por mais de 1 segundo
+    @brief Desautentica só a estação dada, marcada como expulsa em sta_slots.
+    @param aid AID do evento de associação, ou 0 para procurar na tabela de slots
+    @note A desconexão resultante não conta como deauth flood. Estações da
+    allowlist nunca são desautenticadas pelo IDS.
     */
-    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    
-    if (current_time - security_stats.last_auth_time > 1000) {
-        security_stats.auth_attempts = 0;
-        security_stats.last_auth_time = current_time;
-    }
-    
-    security_stats.auth_attempts++;
-    
-    if (security_stats.auth_attempts > MAX_AUTH_ATTEMPTS_PER_SECOND) {
-        ESP_LOGI(TAG, "\n\n\nAUTH FLOOD DETECTADO! %d tentativas em 1s (limite: %d)", 
-                 security_stats.auth_attempts, MAX_AUTH_ATTEMPTS_PER_SECOND);
-        auth_floods_detected++;
-        return true;
+    if (allowlist_contains(mac) || !sta_slots_kick(mac, &aid)) {
+        return;
     }
-    
-    return false;
+    esp_wifi_deauth_sta(aid);
 }
 
-bool detect_packet_flood(uint8_t* mac)
+static void ids_report_attack(const uint8_t *mac, uint16_t aid, const ids_result_t *result)
 {
-    /* 
-    @brief Detecta packet flood (ataque de inundação de pacotes).
-    @note Utiliza um contador de pacotes por cliente por segundo. Se exceder o limite, considera flood.
-    @note Reseta o contador se não houver pacotes do cliente por mais de 1 segundo
-    @param mac MAC address do cliente a ser monitorado
+    /*
+    @brief Ações do AP para um ataque detectado pelo núcleo do IDS.
+    @param mac MAC address bloqueado
+    @param aid AID da estação, quando o evento o traz (0 = procurar em sta_slots)
+    @param result Resultado devolvido pelo núcleo (conexão, desconexão ou pacote)
+    @note Chamada por quem observou o evento, com o veredito devolvido pelo worker;
+    o tempo de bloqueio é fixo em BLACKLIST_DURATION_MS.
+    @note Com a blacklist do shard cheia o MAC não é bloqueado (contado em mempool_ids_blacklist_<shard>_exhausted_total).
     */
-    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    
-    for (int i = 0; i < AP_MAX_STA_CONN; i++) {
-        if (client_monitors[i].active && memcmp(client_monitors[i].mac, mac, 6) == 0) {
-            if (current_time - client_monitors[i].last_packet_time > 1000) {
-                client_monitors[i].packet_count = 0;
-                client_monitors[i].last_packet_time = current_time;
-            }
-            
-            client_monitors[i].packet_count++;
-            
-            if (client_monitors[i].packet_count > MAX_PACKETS_PER_CLIENT) {
-                ESP_LOGI(TAG, "\n\n\nPACKET FLOOD DETECTADO! Cliente %02x:%02x:%02x:%02x:%02x:%02x enviou %d pacotes em 1s",
-                         mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
-                         client_monitors[i].packet_count);
-                packet_floods_detected++;
-                return true;
-            }
-            return false;
-        }
+    if (result->refreshed) {
+        ESP_LOGI(TAG, "\n\n\nMAC ja bloqueado - tempo atualizado");
+        return;
     }
-    
-    for (int i = 0; i < AP_MAX_STA_CONN; i++) {
-        if (!client_monitors[i].active) {
-            memcpy(client_monitors[i].mac, mac, 6);
-            client_monitors[i].last_packet_time = current_time;
-            client_monitors[i].packet_count = 1;
-            client_monitors[i].tcp_connections = 0;
-            client_monitors[i].active = true;
-            ESP_LOGD(TAG, "\n\n\nNovo cliente adicionado ao monitor: %02x:%02x:%02x:%02x:%02x:%02x",
-                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-            break;
-        }
+    if (result->blacklist_full) {
+        ESP_LOGI(TAG, "\n\n\nBlacklist cheia - MAC nao bloqueado");
+        return;
     }
+
+    const char *attack_name = ids_attack_name(result->attack);
+
+    ESP_LOGI(TAG, "\n\n\nMAC %02x:%02x:%02x:%02x:%02x:%02x bloqueado por %s (%d seg)",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+             attack_name, BLACKLIST_DURATION_MS/1000);
     
-    return false;
+    // Alocações e CPU enquanto o ataque continua são rastreadas (se habilitado)
+    sys_monitor_heap_trace_trigger(attack_name);
+    profiler_trigger(attack_name);
+    
+    // Desautenticar só o atacante (a placa sensora não tem softAP). Clientes TCP
+    // (MAC derivado do IP) ficam só no filtro de entrada: o ID não identifica a
+    // estação, e a reconexão traria um IP novo, fora do bloqueio
+    if (!CHANNEL_MONITOR_ENABLED && !ids_mac_is_ip_derived(mac)) {
+        ap_deauth_station(mac, aid);
+    }
 }
 
-void remove_client_from_monitor(uint8_t* mac)
+static void station_slots_admit(const wifi_event_ap_staconnected_t *event, bool trusted)
 {
     /*
-    @brief Remove um cliente do monitor de clientes.
-    @param mac MAC address do cliente a ser removido
-    @note Procura o cliente no monitor e desativa sua entrada se encontrado.
+    @brief Ocupa um slot para a estação recém-associada e aplica a expulsão decidida.
+    @note A vítima é desautenticada aqui; o evento de desconexão dela chega depois
+    e é reconhecido por sta_slots_disconnect().
     */
-    for (int i = 0; i < AP_MAX_STA_CONN; i++) {
-        if (client_monitors[i].active && memcmp(client_monitors[i].mac, mac, 6) == 0) {
-            client_monitors[i].active = false;
-            ESP_LOGD(TAG, "\n\n\nCliente removido do monitor: %02x:%02x:%02x:%02x:%02x:%02x",
-                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-            break;
-        }
+    sta_slots_decision_t decision = sta_slots_connect(event->mac, event->aid, trusted, time_base_now_ms());
+    if (decision.result == STA_SLOTS_REJECT_FULL) {
+        ESP_LOGI(TAG, "\n\n\nTabela de estacoes cheia - desassociando %02x:%02x:%02x:%02x:%02x:%02x",
+                 event->mac[0], event->mac[1], event->mac[2],
+                 event->mac[3], event->mac[4], event->mac[5]);
+        esp_wifi_deauth_sta(event->aid);
+    } else if (decision.result == STA_SLOTS_ACCEPT_EVICT) {
+        const uint8_t *victim = decision.evicted_mac;
+        ESP_LOGI(TAG, "\n\n\nSlots nao confiaveis esgotados - expulsando %02x:%02x:%02x:%02x:%02x:%02x (AID %d)",
+                 victim[0], victim[1], victim[2], victim[3], victim[4], victim[5], decision.evicted_aid);
+        esp_wifi_deauth_sta(decision.evicted_aid);
     }
 }
 
@@ -269,21 +333,38 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,int32_t ev
     if (event_id == WIFI_EVENT_AP_STACONNECTED) {
         wifi_event_ap_staconnected_t* event = (wifi_event_ap_staconnected_t*) event_data;
         
-        if (is_mac_blacklisted(event->mac)) {
+        // Estação da allowlist: sem detector de auth flood (reconexões legítimas não a bloqueiam)
+        bool trusted = allowlist_contains(event->mac);
+        ids_result_t result = {0};
+        if (trusted) {
+            metric_inc(m_trusted_connections);
+        } else {
+            time_us_t detect_start = time_base_now_us();
+            result = ids_workers_call(IDS_DOT11_EVENT_CONNECT, event->mac, detect_start);
+            metric_observe(m_auth_latency, (uint32_t)(time_base_now_us() - detect_start));
+        }
+
+        if (result.verdict == IDS_VERDICT_BLOCKED) {
             ESP_LOGI(TAG, "\n\n\nTentativa de conexao de MAC bloqueado: %02x:%02x:%02x:%02x:%02x:%02x", 
                      event->mac[0], event->mac[1], event->mac[2], 
                      event->mac[3], event->mac[4], event->mac[5]);
-            esp_wifi_deauth_sta(event->aid);
+            metric_inc(m_blocked_connections);
+            ap_deauth_station(event->mac, event->aid);
             return;
         }
         
-        if (detect_auth_flood()) {
+        if (result.verdict == IDS_VERDICT_ATTACK) {
+            ESP_LOGI(TAG, "\n\n\nAUTH FLOOD DETECTADO! %d tentativas em 1s (limite: %d), intervalo %lu us", 
+                     result.count, MAX_AUTH_ATTEMPTS_PER_SECOND, (unsigned long)result.interval_us);
             ESP_LOGI(TAG, "\n\n\nAUTH FLOOD DETECTADO - Bloqueando atacante!");
-            add_to_blacklist(event->mac, 2); // 2 = AUTH_FLOOD
+            ids_report_attack(event->mac, event->aid, &result);
             return;
         }
         
+        station_slots_admit(event, trusted);
+
         connected_clients++;
+        metric_set(m_connected_clients, connected_clients);
         ESP_LOGI(TAG, "\n\n\nCliente conectado! MAC: %02x:%02x:%02x:%02x:%02x:%02x, AID: %d, Total: %d/%d", 
                  event->mac[0], event->mac[1], event->mac[2], 
                  event->mac[3], event->mac[4], event->mac[5],
@@ -292,17 +373,31 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,int32_t ev
     } else if (event_id == WIFI_EVENT_AP_STADISCONNECTED) {
         wifi_event_ap_stadisconnected_t* event = (wifi_event_ap_stadisconnected_t*) event_data;
         
+        // Expulsões nossas não contam como desconexão para o deauth flood
+        // (o monitor de pacotes da estação sai por ociosidade)
+        bool evicted = sta_slots_disconnect(event->mac);
+        dhcp_guard_release(event->mac, DHCP_GUARD_RELEASE_DISCONNECT);
+
+        // Conta a desconexão e tira o cliente do monitor de pacotes; estações da
+        // allowlist não passam pelo IDS na conexão e também não na desconexão
+        ids_result_t result = {0};
+        if (!evicted && !allowlist_contains(event->mac)) {
+            time_us_t detect_start = time_base_now_us();
+            result = ids_workers_call(IDS_DOT11_EVENT_DISCONNECT, event->mac, detect_start);
+            metric_observe(m_deauth_latency, (uint32_t)(time_base_now_us() - detect_start));
+        }
 
-        if (detect_deauth_flood(event->mac)) {
+        if (result.verdict == IDS_VERDICT_ATTACK) {
+            ESP_LOGI(TAG, "\n\n\nDEAUTH FLOOD DETECTADO! %d desconexoes em 1s (limite: %d), intervalo %lu us", 
+                     result.count, MAX_DISCONNECTIONS_PER_SECOND, (unsigned long)result.interval_us);
             ESP_LOGI(TAG, "\n\n\nDEAUTH FLOOD DETECTADO - Bloqueando atacante!");
-            add_to_blacklist(event->mac, 1); // 1 = DEAUTH_FLOOD
+            ids_report_attack(event->mac, 0, &result);
         }
         
-        remove_client_from_monitor(event->mac);
-        
         // Proteger contra contador negativo
         if (connected_clients > 0) {
             connected_clients--;
+            metric_set(m_connected_clients, connected_clients);
             ESP_LOGI(TAG, "\n\n\nCliente desconectado! MAC: %02x:%02x:%02x:%02x:%02x:%02x, AID: %d, Motivo: %d, Total: %d/%d", 
                      event->mac[0], event->mac[1], event->mac[2], 
                      event->mac[3], event->mac[4], event->mac[5],
@@ -315,6 +410,15 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,int32_t ev
     }
 }
 
+static void ip_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    /*
+    @brief Lease concedido pelo servidor DHCP do AP (também nas renovações).
+    */
+    ip_event_ap_staipassigned_t *event = (ip_event_ap_staipassigned_t *)event_data;
+    dhcp_guard_assigned(event->mac, event->ip.addr, allowlist_contains(event->mac));
+}
+
 void show_ap_status(void)
 {
     ESP_LOGI(TAG, "\n\n\n=== STATUS DO ACCESS POINT ===");
@@ -322,7 +426,7 @@ void show_ap_status(void)
     ESP_LOGI(TAG, "Canal: %d", AP_CHANNEL);
     ESP_LOGI(TAG, "Clientes conectados: %d/%d", connected_clients, AP_MAX_STA_CONN);
     ESP_LOGI(TAG, "Servidor TCP: Porta %d", TCP_SERVER_PORT);
-    ESP_LOGI(TAG, "Mensagens processadas: %d", tcp_clients_served);
+    ESP_LOGI(TAG, "Mensagens processadas: %ld", (long)metric_value(m_tcp_messages));
     ESP_LOGI(TAG, "Autenticacao: WPA2_PSK");
     ESP_LOGI(TAG, "IP do AP: 192.168.4.1");
     ESP_LOGI(TAG, "Protecao anti-flood: ATIVA");
@@ -331,72 +435,206 @@ void show_ap_status(void)
 
 void wifi_init_ap(void)
 {
-    ESP_ERROR_CHECK(esp_netif_init());
+    wifi_common_ap_config_t ap_config = {
+        .ssid = AP_SSID,
+        .password = AP_PASS,
+        .channel = AP_CHANNEL,
+        .max_connection = AP_MAX_STA_CONN,
+        .handler = &wifi_event_handler,
+    };
+    esp_netif_t *ap_netif = wifi_common_init_ap(&ap_config);
+    ingress_filter_init(ap_netif);
+    ESP_ERROR_CHECK(dhcp_guard_init(ap_netif));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_AP_STAIPASSIGNED,
+                                                        &ip_event_handler, NULL, NULL));
 
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    ESP_LOGI(TAG, "Access Point iniciado!");
+    ESP_LOGI(TAG, "SSID: %s", AP_SSID);
+    ESP_LOGI(TAG, "Canal: %d", AP_CHANNEL);
+    ESP_LOGI(TAG, "Máximo de conexões: %d (%d reservadas para %d estações confiáveis)",
+             AP_MAX_STA_CONN, STA_SLOTS_RESERVED, allowlist_size());
+    ESP_LOGI(TAG, "Autenticação: %s", (strlen(AP_PASS) == 0) ? "Aberta" : "WPA2_PSK");
+}
+
+void wifi_init_sensor(void)
+{
+    /*
+    @brief Sobe o Wi-Fi em STA sem conexão, para o monitor multicanal.
+    @note esp_wifi_set_channel só é permitido sem estações associadas a um softAP
+    da placa: por isso o modo sensor não sobe o AP.
+    */
+    wifi_common_sta_config_t sta_config = {
+        .ssid = "",
+        .password = "",
+        .start = false,
+    };
+    wifi_common_init_sta(&sta_config);
+    ESP_ERROR_CHECK(esp_wifi_start());
+
+    ESP_LOGI(TAG, "Placa sensora iniciada (STA sem conexao, canais 0x%04x)", CHANNEL_MONITOR_MASK);
+}
 
-    esp_netif_create_default_wifi_ap();
+static void ap_monitor_event_cb(const chan_monitor_event_t *event, void *ctx)
+{
+    /*
+    @brief Entrega ao núcleo do IDS os eventos observados pelo monitor multicanal.
+    @param event Estação afetada, BSSID, canal e RSSI do quadro
+    @note Roda na task do monitor, fora da task do Wi-Fi.
+    */
+    const uint8_t *mac = event->mac;
 
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+    time_us_t detect_start = time_base_now_us();
+    ids_result_t result = ids_workers_call(event->event, mac, detect_start);
+    metric_observe(event->event == IDS_DOT11_EVENT_CONNECT ? m_auth_latency : m_deauth_latency,
+                   (uint32_t)(time_base_now_us() - detect_start));
 
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
-                                                        ESP_EVENT_ANY_ID,
-                                                        &wifi_event_handler,
-                                                        NULL,
-                                                        NULL));
+    if (result.verdict != IDS_VERDICT_ATTACK) {
+        return;
+    }
 
-    wifi_config_t wifi_config = {
-        .ap = {
+    ESP_LOGI(TAG, "\n\n\n%s DETECTADO no canal %d! %d quadros em 1s, intervalo %lu us (BSSID %02x:%02x:%02x:%02x:%02x:%02x, RSSI %d)",
+             ids_attack_name(result.attack), event->channel, result.count, (unsigned long)result.interval_us,
+             event->bssid[0], event->bssid[1], event->bssid[2],
+             event->bssid[3], event->bssid[4], event->bssid[5], event->rssi);
+    ids_report_attack(mac, 0, &result);
+}
+
+static void ap_beacon_cb(const wifi_promiscuous_pkt_t *pkt, wifi_promiscuous_pkt_type_t type, void *ctx)
+{
+    // sig_len inclui o FCS (4 bytes), que não é elemento do beacon
+    if (type == WIFI_PKT_MGMT && pkt->rx_ctrl.sig_len > 4) {
+        beacon_tracker_observe(pkt->payload, pkt->rx_ctrl.sig_len - 4, pkt->rx_ctrl.channel,
+                               pkt->rx_ctrl.rssi, time_base_now_ms());
+    }
+}
+
+static void ap_beacon_alert_cb(const beacon_tracker_entry_t *entry, uint8_t new_alerts, void *ctx)
+{
+    /*
+    @brief Loga cada alerta novo do rastreador de beacons.
+    @note Chamada no tick do IDS, fora do callback do Wi-Fi. O AP não bloqueia o
+    BSSID falso (não há quadro a filtrar); o alerta serve de evidência e aciona o heap tracing.
+    */
+    for (uint8_t bit = 1; bit; bit <<= 1) {
+        if (!(new_alerts & bit)) {
+            continue;
+        }
+        ESP_LOGI(TAG, "\n\n\nAP FALSO DETECTADO (%s)! BSSID %02x:%02x:%02x:%02x:%02x:%02x, SSID \"%s\", canal %d, RSSI %d, seg 0x%06lx",
+                 beacon_tracker_alert_name(bit),
+                 entry->bssid[0], entry->bssid[1], entry->bssid[2],
+                 entry->bssid[3], entry->bssid[4], entry->bssid[5],
+                 entry->ssid, entry->channel, entry->rssi, (unsigned long)entry->security);
+    }
+    sys_monitor_heap_trace_trigger("ROGUE_AP");
+    profiler_trigger("ROGUE_AP");
+}
+
+static void ap_capture_cb(const wifi_promiscuous_pkt_t *pkt, wifi_promiscuous_pkt_type_t type, void *ctx)
+{
+    // Roda na task do Wi-Fi: pcap_stream_write só copia para o buffer ativo (ou descarta)
+    pcap_stream_write(pkt->payload, pkt->rx_ctrl.sig_len, pkt->rx_ctrl.channel,
+                      pkt->rx_ctrl.rssi, time_base_now_us());
+}
+
+static void ap_sniffer_start(void)
+{
+    /*
+    @brief Registra os consumidores do modo promíscuo e liga o sniffer.
+    @note Só quadros de gerenciamento; sem consumidores o rádio não entra em modo promíscuo.
+    */
+    bool enabled = false;
+
+    if (PCAP_CAPTURE_ENABLED) {
+        ESP_ERROR_CHECK(pcap_stream_start(PCAP_WRITER_CORE, PCAP_WRITER_PRIORITY, PCAP_WRITER_STACK_SIZE));
+        ESP_ERROR_CHECK(wifi_sniffer_register(ap_capture_cb, NULL));
+        enabled = true;
+    }
+
+    if (BEACON_TRACKER_ENABLED && !CHANNEL_MONITOR_ENABLED) {
+        // Referência: o próprio AP (WPA2-PSK com CCMP, ou rede aberta)
+        beacon_tracker_config_t tracker_config = {
             .ssid = AP_SSID,
-            .ssid_len = strlen(AP_SSID),
-            .channel = AP_CHANNEL,
-            .password = AP_PASS,
-            .max_connection = AP_MAX_STA_CONN,
-            .authmode = WIFI_AUTH_WPA2_PSK,
-            .pmf_cfg = {
-                .required = false,
-            },
-        },
-    };
+            .beacon_interval = AP_BEACON_INTERVAL_TU,
+            .security = strlen(AP_PASS) == 0 ? 0 :
+                        BEACON_SEC_PRIVACY | BEACON_SEC_RSN | BEACON_SEC_CIPHER(4) | BEACON_SEC_AKM(2),
+            .max_age_ms = BEACON_TRACKER_MAX_AGE_MS,
+        };
+        ESP_ERROR_CHECK(esp_wifi_get_mac(WIFI_IF_AP, tracker_config.bssid));
+        beacon_tracker_init(&tracker_config);
+        ESP_ERROR_CHECK(wifi_sniffer_register(ap_beacon_cb, NULL));
+        enabled = true;
+    }
 
-    if (strlen(AP_PASS) == 0) {
-        wifi_config.ap.authmode = WIFI_AUTH_OPEN;
+    if (CHANNEL_MONITOR_ENABLED) {
+        const chan_monitor_config_t monitor_config = {
+            .channel_mask = CHANNEL_MONITOR_MASK,
+            .base_dwell_ms = CHANNEL_MONITOR_BASE_DWELL_MS,
+            .max_dwell_ms = CHANNEL_MONITOR_MAX_DWELL_MS,
+            .boost_ms = CHANNEL_MONITOR_BOOST_MS,
+            .alert_threshold = CHANNEL_MONITOR_ALERT_THRESHOLD,
+            .on_event = ap_monitor_event_cb,
+        };
+        ESP_ERROR_CHECK(chan_monitor_init(&monitor_config));
+        enabled = true;
     }
 
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP));
-    
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &wifi_config));
-    
-    ESP_ERROR_CHECK(esp_wifi_start());
+    if (enabled) {
+        ESP_ERROR_CHECK(wifi_sniffer_start(WIFI_PROMIS_FILTER_MASK_MGMT));
+    }
 
-    ESP_LOGI(TAG, "Access Point iniciado!");
-    ESP_LOGI(TAG, "SSID: %s", AP_SSID);
-    ESP_LOGI(TAG, "Canal: %d", AP_CHANNEL);
-    ESP_LOGI(TAG, "Máximo de conexões: %d", AP_MAX_STA_CONN);
-    ESP_LOGI(TAG, "Autenticação: %s", (strlen(AP_PASS) == 0) ? "Aberta" : "WPA2_PSK");
+    if (CHANNEL_MONITOR_ENABLED) {
+        ESP_ERROR_CHECK(chan_monitor_start(CHAN_MONITOR_CORE, CHAN_MONITOR_PRIORITY, CHAN_MONITOR_STACK_SIZE));
+    }
 }
 
-void process_client_message(int sock, char* rx_buffer, int len, uint8_t* client_mac)
+static bool client_packet_allowed(tcp_conn_t *conn, const char *payload, int len)
 {
-    tcp_clients_served++;
-    
-    if (detect_packet_flood(client_mac)) {
+    /*
+    @brief Conta uma mensagem do cliente no IDS (packet flood), com o peso do conteúdo.
+    @param payload Conteúdo da mensagem, pontuado por payload_sketch (repetição, entropia)
+    @return false se o cliente foi bloqueado agora (a resposta de bloqueio já foi enviada)
+    */
+    uint8_t *client_mac = conn->mac;
+    time_us_t detect_start = time_base_now_us();
+    uint8_t suspicion = payload_sketch_score(ids_mac_to_ip(client_mac), payload, len, time_base_now_ms());
+    ids_result_t result = ids_workers_call_packet(client_mac, suspicion, detect_start);
+    metric_observe(m_packet_latency, (uint32_t)(time_base_now_us() - detect_start));
+
+    if (result.verdict == IDS_VERDICT_ATTACK) {
+        ESP_LOGI(TAG, "\n\n\nPACKET FLOOD DETECTADO! Cliente %02x:%02x:%02x:%02x:%02x:%02x enviou %d pacotes em 1s (+%d por conteudo suspeito), intervalo %lu us",
+                 client_mac[0], client_mac[1], client_mac[2], client_mac[3], client_mac[4], client_mac[5],
+                 result.count, result.suspicion, (unsigned long)result.interval_us);
         ESP_LOGI(TAG, "\n\n\nPACKET FLOOD DETECTADO - Bloqueando cliente!");
-        add_to_blacklist(client_mac, 3); // 3 = PACKET_FLOOD
+        ids_report_attack(client_mac, 0, &result);
         
         char block_response[] = "Connection blocked due to flood detection";
-        send(sock, block_response, strlen(block_response), 0);
+        int written = send(conn->sock, block_response, strlen(block_response), 0);
+        if (written > 0) {
+            conn->activity.bytes_out += written;
+        }
+        return false;
+    }
+    return true;
+}
+
+void process_client_message(tcp_conn_t *conn, int len)
+{
+    int sock = conn->sock;
+    char *rx_buffer = conn->rx_buffer;
+
+    metric_inc(m_tcp_messages);
+    
+    if (!conn->trusted && !client_packet_allowed(conn, rx_buffer, len)) {
         return;
     }
     
     ESP_LOGI(TAG, "\n\n\nMensagem recebida (%d bytes): %s", len, rx_buffer);
-    ESP_LOGI(TAG, "Total de mensagens processadas: %d", tcp_clients_served);
+    ESP_LOGI(TAG, "Total de mensagens processadas: %ld", (long)metric_value(m_tcp_messages));
     
     char response[256];
     snprintf(response, sizeof(response), 
              "Echo from AP: %s | Messages: %d | Clients: %d | Security: ACTIVE",
-             rx_buffer, tcp_clients_served, connected_clients);
+             rx_buffer, (int)metric_value(m_tcp_messages), connected_clients);
     
     int to_write = strlen(response);
     while (to_write > 0) {
@@ -405,15 +643,183 @@ void process_client_message(int sock, char* rx_buffer, int len, uint8_t* client_
             ESP_LOGE(TAG, "Erro ao enviar resposta: errno %d", errno);
             break;
         }
+        conn->activity.bytes_out += written;
         to_write -= written;
     }
     
     ESP_LOGI(TAG, "\n\n\nResposta enviada: %s", response);
 }
 
+static bool client_activity_report(const uint8_t *client_mac, const ids_client_activity_t *activity)
+{
+    /*
+    @brief Entrega ao IDS a atividade de uma conexão (delta desde o último relato).
+    @return true se o cliente acabou de ser bloqueado
+    @note Um pedido por relato: bytes, conexões vazias e erros de recv somam na
+    janela do cliente e podem bloqueá-lo por volume ou por connection flood.
+    */
+    ids_result_t result = ids_workers_call_activity(client_mac, activity, time_base_now_us());
+    if (result.verdict != IDS_VERDICT_ATTACK) {
+        return false;
+    }
+
+    ESP_LOGI(TAG, "\n\n\n%s DETECTADO! Cliente %02x:%02x:%02x:%02x:%02x:%02x em 1s: %u conexoes (%u sem dados, %u erros de recv), %lu bytes recebidos, %lu enviados",
+             ids_attack_name(result.attack),
+             client_mac[0], client_mac[1], client_mac[2], client_mac[3], client_mac[4], client_mac[5],
+             result.activity.connections, result.activity.empty_connections, result.activity.recv_errors,
+             (unsigned long)result.activity.bytes_in, (unsigned long)result.activity.bytes_out);
+    ids_report_attack(client_mac, 0, &result);
+    return true;
+}
+
+static bool client_activity_flush(tcp_conn_t *conn)
+{
+    /*
+    @brief Relata ao IDS a atividade acumulada na conexão e zera o delta.
+    @return true se o cliente foi bloqueado (a conexão deve ser encerrada)
+    @note Delta vazio não gera pedido ao worker.
+    */
+    const ids_client_activity_t *activity = &conn->activity;
+    if (activity->connections == 0 && activity->bytes_in == 0 && activity->bytes_out == 0 &&
+        activity->empty_connections == 0 && activity->recv_errors == 0) {
+        return false;
+    }
+
+    bool blocked = client_activity_report(conn->mac, activity);
+    memset(&conn->activity, 0, sizeof(conn->activity));
+    return blocked;
+}
+
+static void process_client_batch(tcp_conn_t *conn, int len)
+{
+    /*
+    @brief Lote da fila de saída dos CLIENTS: registros "#<boot id>:<seq> <texto>\n".
+    @param conn Conexão com o primeiro trecho já em rx_buffer
+    @param len Bytes já recebidos
+    @note Lê até o cliente fechar a escrita, até TCP_BATCH_DEADLINE_MS ou até
+    TCP_BATCH_MAX_RECORDS / TCP_BATCH_MAX_BYTES: o servidor é serial, e um cliente
+    que manda um byte a cada poucos segundos não pode prender a conexão. Cada
+    registro conta no IDS (reenvios também); os já processados são descartados
+    por msg_dedup. A resposta "ACK <boot id>:<seq>" confirma a maior sequência
+    vista, inclusive reenvios.
+    @note A atividade é relatada ao IDS a cada trecho recebido, não só no
+    fechamento: os limites por cliente valem durante o lote.
+    */
+    char *buf = conn->rx_buffer;
+    int used = len;
+    int batch_bytes = len;
+    int records = 0;
+    uint32_t deadline_ms = time_base_now_ms() + TCP_BATCH_DEADLINE_MS;
+    const char *limit = NULL;
+    unsigned long boot_id = 0;
+    unsigned long acked = 0;
+    int fresh = 0;
+    int duplicates = 0;
+
+    while (1) {
+        if (!conn->trusted && client_activity_flush(conn)) {
+            return;
+        }
+
+        char *line_end;
+        while ((line_end = memchr(buf, '\n', used)) != NULL) {
+            if (records >= TCP_BATCH_MAX_RECORDS) {
+                limit = "registros";
+                break;
+            }
+            records++;
+            *line_end = '\0';
+            unsigned long record_boot = 0;
+            unsigned long seq = 0;
+            int text_pos = 0;
+            if (sscanf(buf, "#%lx:%lu %n", &record_boot, &seq, &text_pos) == 2 && text_pos > 0) {
+                if (!conn->trusted && !client_packet_allowed(conn, buf + text_pos, line_end - buf - text_pos)) {
+                    return;
+                }
+                if (msg_dedup_accept(conn->addr.sin_addr.s_addr, record_boot, seq, time_base_now_ms())) {
+                    metric_inc(m_tcp_messages);
+                    fresh++;
+                    ESP_LOGI(TAG, "\n\n\nMensagem %lu recebida (lote): %s", seq, buf + text_pos);
+                } else {
+                    duplicates++;
+                }
+                boot_id = record_boot;
+                acked = seq > acked ? seq : acked;
+            }
+            used -= line_end + 1 - buf;
+            memmove(buf, line_end + 1, used);
+        }
+        if (limit != NULL) {
+            break;
+        }
+        if (batch_bytes >= TCP_BATCH_MAX_BYTES) {
+            limit = "bytes";
+            break;
+        }
+        int32_t remaining_ms = (int32_t)(deadline_ms - time_base_now_ms());
+        if (remaining_ms <= 0) {
+            limit = "prazo";
+            break;
+        }
+        // Cada recv espera até TCP_BATCH_RECV_TIMEOUT_S, sem passar do prazo do lote
+        if (remaining_ms > TCP_BATCH_RECV_TIMEOUT_S * 1000) {
+            remaining_ms = TCP_BATCH_RECV_TIMEOUT_S * 1000;
+        }
+        struct timeval timeout = {
+            .tv_sec = remaining_ms / 1000,
+            .tv_usec = (remaining_ms % 1000) * 1000,
+        };
+        setsockopt(conn->sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        if (used >= (int)sizeof(conn->rx_buffer) - 1) {
+            used = 0; // Registro maior que o buffer: descartado
+        }
+        int n = recv(conn->sock, buf + used, sizeof(conn->rx_buffer) - 1 - used, 0);
+        if (n <= 0) {
+            // Timeout do lote (SO_RCVTIMEO) não é erro do cliente
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                conn->activity.recv_errors++;
+            }
+            break;
+        }
+        conn->activity.bytes_in += n;
+        batch_bytes += n;
+        used += n;
+    }
+
+    if (limit != NULL) {
+        ESP_LOGW(TAG, "Lote encerrado pelo limite de %s (%d registros, %d bytes)", limit, records, batch_bytes);
+        metric_inc(m_batch_limited);
+    }
+
+    if (acked > 0) {
+        char ack[32];
+        int ack_len = snprintf(ack, sizeof(ack), "ACK %08lx:%lu\n", boot_id, acked);
+        int written = send(conn->sock, ack, ack_len, 0);
+        if (written > 0) {
+            conn->activity.bytes_out += written;
+        }
+    }
+    ESP_LOGI(TAG, "Lote do boot %08lx: %d novas, %d repetidas, ACK %lu", boot_id, fresh, duplicates, acked);
+}
+
+static void tcp_reject(int sock)
+{
+    /*
+    @brief Encerra uma conexão recusada com RST.
+    @note SO_LINGER com tempo zero faz o close() abortar a conexão: o lwIP envia
+    RST e libera o PCB na hora, sem FIN/TIME_WAIT nem recv/keep-alive.
+    */
+    struct linger so_linger = {
+        .l_onoff = 1,
+        .l_linger = 0,
+    };
+    setsockopt(sock, SOL_SOCKET, SO_LINGER, &so_linger, sizeof(so_linger));
+    close(sock);
+}
+
 static void tcp_server_task(void *pvParameters)
 {
-    char addr_str[128];
+    char addr_str[INET_ADDRSTRLEN];
     int addr_family = AF_INET;
     int ip_protocol = 0;
     int keepAlive = 1;
@@ -447,7 +853,7 @@ static void tcp_server_task(void *pvParameters)
         goto CLEAN_UP;
     }
 
-    err = listen(listen_sock, 1);
+    err = listen(listen_sock, TCP_LISTEN_BACKLOG);
     if (err != 0) {
         ESP_LOGE(TAG, "Erro no listen: errno %d", errno);
         goto CLEAN_UP;
@@ -465,41 +871,76 @@ static void tcp_server_task(void *pvParameters)
             break;
         }
 
+        // Controle de admissão antes de qualquer outro trabalho na conexão;
+        // estações da allowlist (identificadas pelo lease DHCP do IP) passam direto.
+        // Recusas por taxa contam no IDS só como conexão (não como conexão vazia):
+        // o cliente precisa insistir até MAX_CONNECTIONS_PER_CLIENT para ser bloqueado.
+        // Tabela de origens cheia não é culpa do cliente e não conta.
+        uint32_t source_ip = ((struct sockaddr_in *)&source_addr)->sin_addr.s_addr;
+        const ids_client_activity_t refused = {
+            .connections = 1,
+        };
+        uint8_t source_mac[6];
+        client_mac_from_ip(source_ip, source_mac);
+        bool trusted = dhcp_guard_ip_trusted(source_ip);
+        if (trusted) {
+            metric_inc(m_trusted_tcp);
+        } else {
+            admission_result_t admission = admission_check(source_ip, time_base_now_ms());
+            if (admission != ADMISSION_ACCEPT) {
+                ESP_LOGD(TAG, "Conexao recusada (%s)", admission_result_name(admission));
+                tcp_reject(sock);
+                if (admission == ADMISSION_REJECT_RATE) {
+                    client_activity_report(source_mac, &refused);
+                }
+                continue;
+            }
+        }
+
+        // Uma conexão por vez: o contexto anterior já voltou ao pool
+        tcp_conn_t *conn = mem_pool_alloc(&conn_pool);
+        conn->sock = sock;
+        conn->trusted = trusted;
+        memcpy(&conn->addr, &source_addr, sizeof(conn->addr));
+        memcpy(conn->mac, source_mac, sizeof(conn->mac));
+        memset(&conn->activity, 0, sizeof(conn->activity));
+        conn->activity.connections = 1;
+
         // Configurar keep-alive
         setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(int));
         setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle, sizeof(int));
         setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval, sizeof(int));
         setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(int));
 
-        inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr, addr_str, sizeof(addr_str) - 1);
+        inet_ntoa_r(conn->addr.sin_addr, addr_str, sizeof(addr_str) - 1);
         ESP_LOGI(TAG, "\n\n\nNova conexao TCP de %s", addr_str);
 
-        char rx_buffer[128];
-        int len = recv(sock, rx_buffer, sizeof(rx_buffer) - 1, 0);
+        int len = recv(sock, conn->rx_buffer, sizeof(conn->rx_buffer) - 1, 0);
         
         if (len < 0) {
             ESP_LOGE(TAG, "Erro ao receber dados: errno %d", errno);
+            conn->activity.recv_errors++;
+            conn->activity.empty_connections++;
         } else if (len == 0) {
             ESP_LOGI(TAG, "Conexão fechada pelo cliente");
+            conn->activity.empty_connections++;
         } else {
-            rx_buffer[len] = 0; // Null-terminate
-            
-
-            uint8_t client_mac[6];
-            uint32_t client_ip = ((struct sockaddr_in *)&source_addr)->sin_addr.s_addr;
-            
-            client_mac[0] = 0x02; 
-            client_mac[1] = 0x00;
-            client_mac[2] = (client_ip >> 24) & 0xFF;
-            client_mac[3] = (client_ip >> 16) & 0xFF;  
-            client_mac[4] = (client_ip >> 8) & 0xFF;
-            client_mac[5] = client_ip & 0xFF;
-            
-            process_client_message(sock, rx_buffer, len, client_mac);
+            conn->rx_buffer[len] = 0; // Null-terminate
+            conn->activity.bytes_in += len;
+
+            if (conn->rx_buffer[0] == '#') {
+                process_client_batch(conn, len);
+            } else {
+                process_client_message(conn, len);
+            }
         }
 
         shutdown(sock, 0);
         close(sock);
+        if (!trusted) {
+            client_activity_flush(conn);
+        }
+        mem_pool_free(&conn_pool, conn);
         ESP_LOGI(TAG, "\n\n\nConexao TCP encerrada");
     }
 
@@ -512,34 +953,31 @@ void show_advanced_security_stats(void)
 {
     ESP_LOGI(TAG, "\n\n\n=== RELATORIO DE SEGURANCA AVANCADO ===");
     ESP_LOGI(TAG, "ATAQUES DETECTADOS:");
+    ids_stats_t stats;
+    ids_get_stats(&stats);
+    int deauth_floods_detected = stats.deauth_floods;
+    int auth_floods_detected = stats.auth_floods;
+    int packet_floods_detected = stats.packet_floods;
+    int connection_floods_detected = stats.connection_floods;
     ESP_LOGI(TAG, "  Deauth Floods: %d", deauth_floods_detected);
     ESP_LOGI(TAG, "  Auth Floods: %d", auth_floods_detected);
     ESP_LOGI(TAG, "  Packet Floods: %d", packet_floods_detected);
+    ESP_LOGI(TAG, "  Connection Floods: %d", connection_floods_detected);
     
-    int total_attacks = deauth_floods_detected + auth_floods_detected + packet_floods_detected;
+    int total_attacks = deauth_floods_detected + auth_floods_detected + packet_floods_detected +
+                        connection_floods_detected;
     ESP_LOGI(TAG, "TOTAL DE ATAQUES: %d", total_attacks);
     
-    int active_blacklist = 0;
-    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    
-    for (int i = 0; i < MAX_BLACKLIST_ENTRIES; i++) {
-        if (blacklist[i].active && current_time < blacklist[i].blocked_until) {
-            active_blacklist++;
-        }
-    }
-    
-    ESP_LOGI(TAG, "MACs bloqueados: %d/%d", active_blacklist, MAX_BLACKLIST_ENTRIES);
-    
-    int active_monitors = 0;
-    for (int i = 0; i < AP_MAX_STA_CONN; i++) {
-        if (client_monitors[i].active) {
-            active_monitors++;
-        }
-    }
-    
-    ESP_LOGI(TAG, "Clientes monitorados: %d/%d", active_monitors, AP_MAX_STA_CONN);
+    // Gauges mantidos incrementalmente (a expiração é imediata via timer wheel)
+    ESP_LOGI(TAG, "MACs bloqueados: %d/%d", stats.blacklist_active, IDS_BLACKLIST_CAPACITY * IDS_SHARDS);
+    ESP_LOGI(TAG, "Clientes monitorados: %d/%d", stats.monitored_clients, AP_MAX_STA_CONN);
     ESP_LOGI(TAG, "Clientes conectados: %d/%d", connected_clients, AP_MAX_STA_CONN);
-    ESP_LOGI(TAG, "Mensagens TCP processadas: %d", tcp_clients_served);
+    sta_slots_log(TAG, time_base_now_ms());
+    dhcp_guard_log(TAG);
+    ESP_LOGI(TAG, "Mensagens TCP processadas: %ld", (long)metric_value(m_tcp_messages));
+    payload_sketch_log(TAG);
+    ids_workers_log(TAG);
+    sys_monitor_log_memory(TAG);
     
     if (total_attacks == 0) {
         ESP_LOGI(TAG, "\n\n\nSTATUS: REDE SEGURA - Nenhum ataque detectado");
@@ -551,33 +989,170 @@ void show_advanced_security_stats(void)
         ESP_LOGI(TAG, "\n\n\nSTATUS: REDE SOB ATAQUES INTENSOS!");
     }
     
+    if (!METRICS_HTTP_ENABLED) {
+        metrics_log_all(TAG);
+    }
+    
     ESP_LOGI(TAG, "================================================");
 }
 
+static void show_resource_usage(void)
+{
+    /*
+    @brief Linha única com heap e vazão desde o relatório anterior.
+    @note O formato "BENCH chave=valor" é lido por tools/bench/tcp_load.py para
+    comparar os perfis de buffers (profiles/sdkconfig.*).
+    */
+    static time_us_t last_report_us = 0;
+    static uint32_t last_messages = 0;
+
+    time_us_t now_us = time_base_now_us();
+    uint32_t messages = (uint32_t)metric_value(m_tcp_messages);
+    uint32_t elapsed_ms = (uint32_t)((now_us - last_report_us) / 1000);
+    uint32_t rate_x10 = elapsed_ms ? (uint32_t)(((uint64_t)(messages - last_messages) * 10000) / elapsed_ms) : 0;
+
+    ESP_LOGI(TAG, "BENCH heap_free=%u heap_min=%u largest_block=%u msgs_per_s=%lu.%lu",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+             (unsigned long)(rate_x10 / 10), (unsigned long)(rate_x10 % 10));
+
+    last_report_us = now_us;
+    last_messages = messages;
+}
+
+static void ids_tick_cb(void *arg)
+{
+    /*
+    @brief Tick periódico (esp_timer, IDS_TICK_MS) das tarefas do AP fora do IDS.
+    @note Roda na task do esp_timer (prioridade 22), que também despacha os
+    callbacks de ets_timer do Wi-Fi: aqui só se acorda a ap_report_task.
+    */
+    xTaskNotifyGive(ap_report_task_handle);
+}
+
+static void ap_report_task(void *pvParameters)
+{
+    /*
+    @brief Monitor de memória, alertas de beacon e relatório periódico, um passo por tick.
+    @note Prioridade baixa (REPORT_PRIORITY): a impressão do relatório, o dump do
+    heap tracing e as varreduras de tasks nunca atrasam o servidor nem os timers.
+    Ticks acumulados enquanto a task espera CPU viram um único passo.
+    */
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        bool report = __atomic_exchange_n(&stats_report_due, false, __ATOMIC_ACQUIRE);
+
+        sys_monitor_poll(); // Heap, pilhas e janelas de heap tracing
+
+        if (BEACON_TRACKER_ENABLED && !CHANNEL_MONITOR_ENABLED) {
+            beacon_tracker_poll(ap_beacon_alert_cb, NULL); // O(1) sem alertas pendentes
+        }
+
+        if (report) {
+            if (CHANNEL_MONITOR_ENABLED) {
+                chan_monitor_log(TAG);      // Permanência, quadros e perdas por canal
+            } else {
+                ESP_LOGI(TAG, "\n\n\nAccess Point ativo - aguardando conexoes...");
+                show_ap_status();
+                if (BEACON_TRACKER_ENABLED) {
+                    beacon_tracker_log(TAG, time_base_now_ms());  // BSSIDs vivos e suspeitos
+                }
+            }
+            show_advanced_security_stats(); // Mostrar relatório de segurança
+            sys_monitor_log_tasks();        // Núcleo, prioridade, pilha e CPU por task
+            mem_pool_log_all(TAG);          // Ocupação dos pools estáticos
+            show_resource_usage();          // Heap e mensagens/s (perfis de buffers)
+        }
+    }
+}
+
+static void ids_timers_init(void)
+{
+    /*
+    @brief Inicializa o núcleo do IDS (shards e timer wheels), os workers dos shards e o pool do servidor.
+    @note Deve ser chamada antes do Wi-Fi subir (os handlers enviam eventos aos workers).
+    @note O relatório periódico é agendado no wheel do shard 0, antes do worker existir.
+    */
+    const ids_config_t ids_config = {
+        .max_disconnections = MAX_DISCONNECTIONS_PER_SECOND,
+        .max_auth_attempts = MAX_AUTH_ATTEMPTS_PER_SECOND,
+        .max_packets_per_client = MAX_PACKETS_PER_CLIENT,
+        .rate_window_ms = RATE_WINDOW_MS,
+        .blacklist_duration_ms = BLACKLIST_DURATION_MS,
+        .monitor_idle_timeout_ms = MONITOR_IDLE_TIMEOUT_MS,
+        .max_bytes_in_per_client = MAX_BYTES_IN_PER_CLIENT,
+        .max_bytes_out_per_client = MAX_BYTES_OUT_PER_CLIENT,
+        .max_connections_per_client = MAX_CONNECTIONS_PER_CLIENT,
+        .max_empty_connections_per_client = MAX_EMPTY_CONNECTIONS_PER_CLIENT,
+        .max_recv_errors_per_client = MAX_RECV_ERRORS_PER_CLIENT,
+        .on_block = ids_block_cb,
+        .on_unblock = ids_unblock_cb,
+    };
+    ids_init(&ids_config, time_base_now_us());
+
+    tw_timer_init(&stats_report_timer, stats_report_cb, NULL);
+    timer_wheel_schedule(ids_timer_wheel(0), &stats_report_timer, IDS_MS_TO_TICKS(STATUS_LOG_INTERVAL_MS));
+    ESP_ERROR_CHECK(ids_workers_start());
+
+    mem_pool_init(&conn_pool);
+    admission_init();
+    msg_dedup_init();
+    payload_sketch_init();
+    sta_slots_init();
+}
+
+static void ids_timers_start(void)
+{
+    xTaskCreatePinnedToCore(ap_report_task, "ap_report", REPORT_STACK_SIZE, NULL,
+                            REPORT_PRIORITY, &ap_report_task_handle, REPORT_CORE);
+
+    const esp_timer_create_args_t tick_args = {
+        .callback = ids_tick_cb,
+        .name = "ids_tick",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&tick_args, &ids_tick_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(ids_tick_timer, IDS_TICK_MS * 1000));
+}
+
 void app_main(void)
 {
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-      ESP_ERROR_CHECK(nvs_flash_erase());
-      ret = nvs_flash_init();
+    wifi_common_nvs_init();
+    ap_metrics_init();
+    sys_monitor_init();
+    ESP_ERROR_CHECK(profiler_init());
+    ids_timers_init();
+
+    if (CHANNEL_MONITOR_ENABLED) {
+        // Placa sensora: só o monitor multicanal e o IDS
+        ESP_LOGI(TAG, "Inicializando ESP32 como sensor multicanal...");
+        wifi_init_sensor();
+        ap_sniffer_start();
+        ids_timers_start();
+        return;
     }
-    ESP_ERROR_CHECK(ret);
 
     ESP_LOGI(TAG, "Inicializando ESP32 como Access Point...");
     
     wifi_init_ap();
+    ap_sniffer_start();
     
     show_ap_status();
     
     vTaskDelay(pdMS_TO_TICKS(2000));
     
-    xTaskCreate(tcp_server_task, "tcp_server_task", 4096, NULL, 5, NULL);
-    ESP_LOGI(TAG, "\n\n\nServidor TCP iniciado!");
-    
-    while(1) {
-        ESP_LOGI(TAG, "\n\n\nAccess Point ativo - aguardando conexoes...");
-        show_ap_status();
-        show_advanced_security_stats(); // Mostrar relatório de segurança 
-        vTaskDelay(pdMS_TO_TICKS(15000)); // Log a cada 15 segundos para monitorar ataques
+    // Fixado no núcleo da aplicação, longe do Wi-Fi/lwIP (ver task_layout.h)
+    xTaskCreatePinnedToCore(tcp_server_task, "tcp_server_task", TCP_SERVER_STACK_SIZE, NULL,
+                            TCP_SERVER_PRIORITY, NULL, TCP_SERVER_CORE);
+    ESP_LOGI(TAG, "\n\n\nServidor TCP iniciado! (core %d, prioridade %d)",
+             TCP_SERVER_CORE, TCP_SERVER_PRIORITY);
+
+    if (METRICS_HTTP_ENABLED) {
+        metrics_http_start();
     }
+    
+    // Memória, alertas de beacon e relatório (expirações e janelas andam nos workers do IDS)
+    ids_timers_start();
+    ESP_LOGI(TAG, "\n\n\nAccess Point ativo - aguardando conexoes...");
 }
@@ -0,0 +1,125 @@
+#include <stdbool.h>
+#include <string.h>
+#include "metrics.h"
+#include "admission.h"
+
+typedef struct {
+    uint32_t ip;            // 0 = slot livre
+    uint32_t window_start;
+    uint32_t last_seen;
+    uint16_t window_count;
+} admission_entry_t;
+
+static admission_entry_t admission_table[ADMISSION_TABLE_SIZE];
+
+static metric_t *m_admitted;
+static metric_t *m_rejected_rate;
+static metric_t *m_rejected_table_full;
+static metric_t *m_tracked_sources;
+
+void admission_init(void)
+{
+    /*
+    @brief Zera a tabela de origens e registra os contadores de admissão.
+    @note A tabela é usada apenas pela tcp_server_task, por isso não há lock.
+    */
+    memset(admission_table, 0, sizeof(admission_table));
+
+    m_admitted = metrics_counter("tcp_admission_admitted_total", "Conexoes TCP admitidas");
+    m_rejected_rate = metrics_counter("tcp_admission_rejected_rate_total",
+                                      "Conexoes recusadas por taxa excessiva do IP de origem");
+    m_rejected_table_full = metrics_counter("tcp_admission_rejected_table_full_total",
+                                            "Conexoes recusadas por tabela de origens cheia");
+    m_tracked_sources = metrics_gauge("tcp_admission_tracked_sources", "IPs de origem na tabela de admissao");
+}
+
+static uint32_t admission_hash(uint32_t ip)
+{
+    // Hash multiplicativo de Fibonacci: espalha IPs sequenciais (DHCP) pela tabela
+    return (ip * 2654435761u) >> (32 - __builtin_ctz(ADMISSION_TABLE_SIZE));
+}
+
+static admission_entry_t *admission_lookup(uint32_t ip, uint32_t now_ms, bool create)
+{
+    /*
+    @brief Procura (ou cria) a entrada de um IP com sondagem linear limitada.
+    @param create Se true, reaproveita um slot livre ou ocioso na sequência de sondagem
+    @return Entrada do IP, ou NULL se não existir (ou não houver slot reaproveitável)
+    @note Uma entrada é ociosa quando não recebe conexões há ADMISSION_IDLE_MS;
+    isso limita o estrago de um flood com IPs de origem forjados a ADMISSION_MAX_PROBE slots.
+    */
+    uint32_t start = admission_hash(ip);
+    admission_entry_t *reusable = NULL;
+
+    for (uint32_t i = 0; i < ADMISSION_MAX_PROBE; i++) {
+        admission_entry_t *entry = &admission_table[(start + i) & (ADMISSION_TABLE_SIZE - 1)];
+
+        if (entry->ip == ip) {
+            return entry;
+        }
+        if (reusable == NULL &&
+            (entry->ip == 0 || now_ms - entry->last_seen > ADMISSION_IDLE_MS)) {
+            reusable = entry;
+        }
+    }
+
+    if (!create || reusable == NULL) {
+        return NULL;
+    }
+
+    if (reusable->ip == 0) {
+        metric_gauge_add(m_tracked_sources, 1);
+    }
+    memset(reusable, 0, sizeof(*reusable));
+    reusable->ip = ip;
+    reusable->window_start = now_ms;
+    return reusable;
+}
+
+admission_result_t admission_check(uint32_t ip, uint32_t now_ms)
+{
+    /*
+    @brief Decide se uma conexão recém-aceita pode seguir para o servidor.
+    @param ip Endereço IPv4 de origem (ordem de rede)
+    @param now_ms Tempo atual em ms
+    @note Janela fixa de ADMISSION_WINDOW_MS por IP para a taxa de conexões.
+    Custo O(ADMISSION_MAX_PROBE), sem alocação.
+    */
+    admission_entry_t *entry = admission_lookup(ip, now_ms, true);
+    if (entry == NULL) {
+        metric_inc(m_rejected_table_full);
+        return ADMISSION_REJECT_TABLE_FULL;
+    }
+
+    entry->last_seen = now_ms;
+
+    if (now_ms - entry->window_start >= ADMISSION_WINDOW_MS) {
+        entry->window_start = now_ms;
+        entry->window_count = 0;
+    }
+
+    // Tentativas recusadas também contam: quem insiste continua bloqueado
+    if (entry->window_count < UINT16_MAX) {
+        entry->window_count++;
+    }
+    if (entry->window_count > ADMISSION_MAX_CONN_PER_WINDOW) {
+        metric_inc(m_rejected_rate);
+        return ADMISSION_REJECT_RATE;
+    }
+
+    metric_inc(m_admitted);
+    return ADMISSION_ACCEPT;
+}
+
+const char *admission_result_name(admission_result_t result)
+{
+    switch (result) {
+    case ADMISSION_ACCEPT:
+        return "ACEITA";
+    case ADMISSION_REJECT_RATE:
+        return "TAXA";
+    case ADMISSION_REJECT_TABLE_FULL:
+        return "TABELA_CHEIA";
+    }
+    return "?";
+}
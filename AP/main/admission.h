@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+// Tabela hash de origens (potência de 2) e limites por IP de origem
+#define ADMISSION_TABLE_SIZE 32
+#define ADMISSION_MAX_PROBE 8
+#ifndef ADMISSION_MAX_CONN_PER_WINDOW
+#define ADMISSION_MAX_CONN_PER_WINDOW 4   // conexões aceitas por IP em ADMISSION_WINDOW_MS
+#endif
+#define ADMISSION_WINDOW_MS 1000
+#define ADMISSION_IDLE_MS 10000           // entrada sem conexões recentes pode ser reaproveitada
+
+typedef enum {
+    ADMISSION_ACCEPT = 0,
+    ADMISSION_REJECT_RATE,
+    ADMISSION_REJECT_TABLE_FULL,
+} admission_result_t;
+
+void admission_init(void);
+
+// Avalia uma conexão recém-aceita. Não há limite de conexões simultâneas: a
+// tcp_server_task atende uma conexão por vez e as demais esperam no backlog
+admission_result_t admission_check(uint32_t ip, uint32_t now_ms);
+
+const char *admission_result_name(admission_result_t result);
@@ -0,0 +1,23 @@
+#include "allowlist.h"
+#include "trusted_stations_table.h"     // gerado no build a partir de AP/trusted_stations.txt
+
+_Static_assert((TRUSTED_TABLE_SIZE & (TRUSTED_TABLE_SIZE - 1)) == 0, "TRUSTED_TABLE_SIZE deve ser potência de 2");
+
+bool allowlist_contains(const uint8_t *mac)
+{
+    /*
+    @brief Consulta a tabela de hash perfeito das estações confiáveis.
+    @note Sem colisões por construção: cada MAC da lista tem seu próprio slot,
+    e qualquer outro MAC cai num slot vazio (0) ou de outra chave.
+    */
+    uint64_t key = 1ULL << 48;
+    for (int i = 0; i < 6; i++) {
+        key |= (uint64_t)mac[i] << (40 - 8 * i);
+    }
+    return trusted_table[(key * TRUSTED_HASH_MULT) >> TRUSTED_HASH_SHIFT] == key;
+}
+
+int allowlist_size(void)
+{
+    return TRUSTED_COUNT;
+}
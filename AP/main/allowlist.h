@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Allowlist das estações confiáveis (frota CLIENTS), fixa no build.
+ *
+ * AP/trusted_stations.txt vira, no build, uma tabela de hash perfeito
+ * (tools/allowlist/gen_allowlist.py): a consulta é uma multiplicação e uma
+ * comparação com a chave de 64 bits do MAC, sem sondagem nem lock. Só o MAC
+ * exato é confiável; um MAC parecido (mesmo OUI, um bit trocado) não é.
+ *
+ * Estações confiáveis ocupam os slots reservados (sta_slots) e pulam o
+ * detector de auth flood na associação e o controle de admissão e o detector
+ * de packet flood no servidor TCP (identificadas pelo lease DHCP, dhcp_guard).
+ */
+
+// MAC exato na allowlist
+bool allowlist_contains(const uint8_t *mac);
+
+// Número de MACs na allowlist gerada
+int allowlist_size(void);
@@ -0,0 +1,218 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "metrics.h"
+#include "dhcp_guard.h"
+
+// O servidor precisa de um lease por estação associada, senão descarta o de um cliente ativo
+#ifdef CONFIG_LWIP_DHCPS_MAX_STATION_NUM
+_Static_assert(CONFIG_LWIP_DHCPS_MAX_STATION_NUM >= DHCP_GUARD_POOL_SIZE,
+               "CONFIG_LWIP_DHCPS_MAX_STATION_NUM menor que DHCP_GUARD_POOL_SIZE");
+#endif
+
+// Leases ativos mais os liberados que o servidor ainda pode guardar
+#define DHCP_GUARD_ENTRIES (DHCP_GUARD_POOL_SIZE * 2)
+
+typedef enum {
+    LEASE_FREE = 0,
+    LEASE_BOUND,        // estação associada com IP
+    LEASE_RELEASED,     // estação saiu; o servidor guarda o IP até o lease vencer
+} lease_state_t;
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t state;
+    bool trusted;
+    uint32_t ip;
+} lease_entry_t;
+
+static lease_entry_t leases[DHCP_GUARD_ENTRIES];
+static int bound_count = 0;
+static int bound_trusted_count = 0;
+static esp_netif_t *guard_netif = NULL;
+static portMUX_TYPE leases_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static metric_t *m_bound;
+static metric_t *m_lingering;
+static metric_t *m_assigned;
+static metric_t *m_released_disconnect;
+static metric_t *m_released_blacklist;
+
+static int lease_find(const uint8_t *mac)
+{
+    for (int i = 0; i < DHCP_GUARD_ENTRIES; i++) {
+        if (leases[i].state != LEASE_FREE && memcmp(leases[i].mac, mac, 6) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int lease_slot(void)
+{
+    // Entrada livre; sem ela, a de um lease já liberado (só serve ao relatório)
+    int released = -1;
+    for (int i = 0; i < DHCP_GUARD_ENTRIES; i++) {
+        if (leases[i].state == LEASE_FREE) {
+            return i;
+        }
+        if (released < 0 && leases[i].state == LEASE_RELEASED) {
+            released = i;
+        }
+    }
+    return released;
+}
+
+esp_err_t dhcp_guard_init(esp_netif_t *ap_netif)
+{
+    /*
+    @brief Reduz o lease oferecido pelo servidor DHCP do AP e registra as métricas.
+    @param ap_netif netif do softAP (servidor DHCP padrão do esp_netif)
+    @note O prazo só pode ser trocado com o servidor parado; chamado logo depois
+    de subir o AP, antes de qualquer cliente pedir IP.
+    */
+    m_bound = metrics_gauge("dhcp_leases_bound", "Leases de estacoes associadas");
+    m_lingering = metrics_gauge("dhcp_leases_lingering", "Leases liberados ainda guardados pelo servidor");
+    m_assigned = metrics_counter("dhcp_leases_assigned_total", "Leases concedidos ou renovados");
+    m_released_disconnect = metrics_counter("dhcp_leases_released_disconnect_total", "Leases tirados da tabela do guard na desconexao (o servidor os guarda ate vencer)");
+    m_released_blacklist = metrics_counter("dhcp_leases_released_blacklist_total", "Leases tirados da tabela do guard por bloqueio do IDS (o servidor os guarda ate vencer)");
+
+    esp_err_t err = esp_netif_dhcps_stop(ap_netif);
+    if (err != ESP_OK && err != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED) {
+        return err;
+    }
+    uint32_t lease_units = DHCP_GUARD_LEASE_UNITS;
+    err = esp_netif_dhcps_option(ap_netif, ESP_NETIF_OP_SET, ESP_NETIF_IP_ADDRESS_LEASE_TIME,
+                                 &lease_units, sizeof(lease_units));
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = esp_netif_dhcps_start(ap_netif);
+    if (err != ESP_OK && err != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STARTED) {
+        return err;
+    }
+
+    guard_netif = ap_netif;
+    return ESP_OK;
+}
+
+void dhcp_guard_assigned(const uint8_t *mac, uint32_t ip, bool trusted)
+{
+    /*
+    @brief Registra o lease concedido (ou renovado) a uma estação.
+    @note Executa no event loop; a renovação só atualiza o IP.
+    */
+    portENTER_CRITICAL(&leases_lock);
+    int i = lease_find(mac);
+    if (i < 0) {
+        i = lease_slot();
+    }
+    if (i >= 0) {
+        if (leases[i].state != LEASE_BOUND) {
+            bound_count++;
+            bound_trusted_count += trusted;
+        } else if (leases[i].trusted != trusted) {
+            bound_trusted_count += trusted ? 1 : -1;
+        }
+        memcpy(leases[i].mac, mac, 6);
+        leases[i].state = LEASE_BOUND;
+        leases[i].trusted = trusted;
+        leases[i].ip = ip;
+    }
+    int bound_now = bound_count;
+    portEXIT_CRITICAL(&leases_lock);
+
+    metric_inc(m_assigned);
+    metric_set(m_bound, bound_now);
+}
+
+bool dhcp_guard_ip_trusted(uint32_t ip)
+{
+    /*
+    @brief Diz se o IP está com uma estação confiável associada agora.
+    @note Só leases ativos contam: o IP de uma estação que saiu volta a ser
+    tratado como desconhecido, mesmo que o servidor ainda o guarde.
+    */
+    bool trusted = false;
+
+    portENTER_CRITICAL(&leases_lock);
+    for (int i = 0; i < DHCP_GUARD_ENTRIES; i++) {
+        if (leases[i].state == LEASE_BOUND && leases[i].ip == ip) {
+            trusted = leases[i].trusted;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&leases_lock);
+    return trusted;
+}
+
+void dhcp_guard_release(const uint8_t *mac, dhcp_guard_release_t reason)
+{
+    /*
+    @brief Marca como liberado, na tabela do guard, o lease de uma estação que saiu ou foi bloqueada.
+    @note O servidor DHCP não tem API para apagar um lease: ele continua lá até
+    vencer (conferido em dhcp_guard_log). Chamado do event loop (desconexão) e do worker do IDS (bloqueio); o
+    bloqueio costuma vir antes da desconexão, que então não conta de novo.
+    */
+    bool released = false;
+
+    portENTER_CRITICAL(&leases_lock);
+    int i = lease_find(mac);
+    if (i >= 0 && leases[i].state == LEASE_BOUND) {
+        leases[i].state = LEASE_RELEASED;
+        bound_count--;
+        bound_trusted_count -= leases[i].trusted;
+        released = true;
+    }
+    int bound_now = bound_count;
+    portEXIT_CRITICAL(&leases_lock);
+
+    if (released) {
+        metric_inc(reason == DHCP_GUARD_RELEASE_BLACKLIST ? m_released_blacklist : m_released_disconnect);
+        metric_set(m_bound, bound_now);
+    }
+}
+
+void dhcp_guard_log(const char *tag)
+{
+    /*
+    @brief Ocupação dos leases e quantos liberados ainda estão no servidor.
+    @note Os liberados são conferidos no próprio servidor: os que ele já
+    esqueceu (lease vencido) saem da tabela aqui.
+    */
+    esp_netif_pair_mac_ip_t released[DHCP_GUARD_ENTRIES];
+    int n_released = 0;
+
+    portENTER_CRITICAL(&leases_lock);
+    int bound_now = bound_count;
+    int trusted_now = bound_trusted_count;
+    for (int i = 0; i < DHCP_GUARD_ENTRIES; i++) {
+        if (leases[i].state == LEASE_RELEASED) {
+            memcpy(released[n_released].mac, leases[i].mac, 6);
+            released[n_released].ip.addr = 0;
+            n_released++;
+        }
+    }
+    portEXIT_CRITICAL(&leases_lock);
+
+    int lingering = 0;
+    if (guard_netif != NULL && n_released > 0 &&
+        esp_netif_dhcps_get_clients_by_mac(guard_netif, n_released, released) == ESP_OK) {
+        portENTER_CRITICAL(&leases_lock);
+        for (int r = 0; r < n_released; r++) {
+            int i = lease_find(released[r].mac);
+            if (released[r].ip.addr != 0) {
+                lingering++;
+            } else if (i >= 0 && leases[i].state == LEASE_RELEASED) {
+                leases[i].state = LEASE_FREE;
+            }
+        }
+        portEXIT_CRITICAL(&leases_lock);
+    }
+    metric_set(m_lingering, lingering);
+
+    ESP_LOGI(tag, "Leases DHCP: %d/%d ativos (%d confiaveis), %d liberados ainda no servidor, prazo %d unidades",
+             bound_now, DHCP_GUARD_POOL_SIZE, trusted_now, lingering, DHCP_GUARD_LEASE_UNITS);
+    ESP_LOGI(tag, "  Liberados da tabela do guard: %ld na desconexao, %ld por bloqueio",
+             (long)metric_value(m_released_disconnect), (long)metric_value(m_released_blacklist));
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_netif.h"
+
+/*
+ * Proteção do pool de leases do servidor DHCP do AP.
+ *
+ * O servidor do ESP-IDF guarda até CONFIG_LWIP_DHCPS_MAX_STATION_NUM leases e,
+ * acima disso, descarta o de menor tempo restante, mesmo que seja de um
+ * cliente ainda associado. Com estações de vida curta (flood de associações)
+ * os leases de quem já saiu ocupam o pool pelo prazo inteiro do lease.
+ *
+ *   - o lease oferecido cai para DHCP_GUARD_LEASE_UNITS: o de quem sai expira
+ *     em minutos, e os clientes legítimos só renovam com mais frequência;
+ *   - o pool do servidor é dimensionado para DHCP_GUARD_POOL_SIZE (sdkconfig);
+ *   - MACs bloqueados não recebem lease: o filtro de entrada do lwIP descarta o
+ *     DISCOVER/REQUEST antes do servidor (ingress_dhcp_refused_total);
+ *   - desconexão e bloqueio liberam o lease na tabela daqui na hora, e o
+ *     relatório mostra quantos ainda estão presos no servidor até expirar.
+ */
+
+#ifndef DHCP_GUARD_POOL_SIZE
+#define DHCP_GUARD_POOL_SIZE 20         // = AP_MAX_STA_CONN
+#endif
+#ifndef DHCP_GUARD_LEASE_UNITS
+#define DHCP_GUARD_LEASE_UNITS 2        // em CONFIG_LWIP_DHCPS_LEASE_UNIT (60 s): 2 min; o padrão do IDF é 120
+#endif
+
+typedef enum {
+    DHCP_GUARD_RELEASE_DISCONNECT = 0,
+    DHCP_GUARD_RELEASE_BLACKLIST,
+} dhcp_guard_release_t;
+
+// Aplica o prazo de lease ao servidor da netif do AP (reinicia o servidor) e registra as métricas
+esp_err_t dhcp_guard_init(esp_netif_t *ap_netif);
+
+// Lease concedido ou renovado (IP_EVENT_AP_STAIPASSIGNED). trusted: MAC da allowlist
+void dhcp_guard_assigned(const uint8_t *mac, uint32_t ip, bool trusted);
+
+// IP com lease ativo de uma estação confiável (servidor TCP identifica clientes pelo IP)
+bool dhcp_guard_ip_trusted(uint32_t ip);
+
+// Estação saiu ou foi bloqueada: o lease deixa de contar como ocupado
+void dhcp_guard_release(const uint8_t *mac, dhcp_guard_release_t reason);
+
+// Ocupação da tabela e leases liberados que o servidor ainda guarda
+void dhcp_guard_log(const char *tag);
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "ids_workers.h"
+#include "metrics.h"
+#include "time_base.h"
+#include "task_layout.h"
+
+static const char *TAG = "IDS_WORKERS";
+
+/*
+ * Cada shard do IDS tem um único dono: a sua task worker. Quem observa um
+ * evento não toca no estado do IDS; manda um pedido pela fila do shard e
+ * recebe o veredito de volta por notificação. Eventos de MACs em shards
+ * diferentes são processados em paralelo nos dois núcleos, sem mutex global.
+ */
+typedef enum {
+    IDS_REQ_CONNECT = 0,
+    IDS_REQ_DISCONNECT,
+    IDS_REQ_PACKET,
+    IDS_REQ_ACTIVITY,
+} ids_req_kind_t;
+
+typedef struct {
+    ids_req_kind_t kind;
+    const uint8_t *mac;
+    time_us_t now_us;
+    uint8_t suspicion;          // só IDS_REQ_PACKET
+    const ids_client_activity_t *activity;  // só IDS_REQ_ACTIVITY
+    TaskHandle_t reply_to;
+    ids_result_t result;
+} ids_work_t;
+
+static QueueHandle_t s_queues[IDS_SHARDS];
+static metric_t *m_requests[IDS_SHARDS];
+static metric_t *m_event_cycles;
+
+// Ciclos de CPU por evento no núcleo do IDS (240 MHz: 2400 ciclos = 10 µs)
+static const uint32_t event_cycle_bounds[] = {250, 500, 1000, 2000, 4000, 8000, 16000, 32000};
+#define EVENT_CYCLE_BUCKETS (sizeof(event_cycle_bounds) / sizeof(event_cycle_bounds[0]))
+
+// Nomes literais: o registro de métricas guarda só o ponteiro
+static const char *const request_metric_names[] = {
+    "ids_shard0_requests_total", "ids_shard1_requests_total",
+    "ids_shard2_requests_total", "ids_shard3_requests_total",
+};
+
+static void ids_worker_task(void *arg)
+{
+    /*
+    @brief Dono de um shard: atende pedidos e avança o timer wheel do shard.
+    @note A espera na fila tem o tick do IDS como limite, então expirações e
+    janelas andam mesmo sem eventos; durante um flood o wheel avança a cada
+    pedido (O(1) quando o tick não mudou).
+    @note A task é fixada num núcleo, então o contador de ciclos (CCOUNT) lido
+    antes e depois do evento é do mesmo núcleo; interrupções no meio contam.
+    */
+    uint8_t shard = (uint8_t)(uintptr_t)arg;
+    ids_work_t *work;
+
+    while (1) {
+        bool got = xQueueReceive(s_queues[shard], &work, pdMS_TO_TICKS(IDS_TICK_MS)) == pdTRUE;
+        ids_advance_shard(shard, time_base_now_us());
+        if (!got) {
+            continue;
+        }
+
+        uint32_t start = esp_cpu_get_cycle_count();
+        switch (work->kind) {
+        case IDS_REQ_CONNECT:
+            work->result = ids_station_connected(work->mac, work->now_us);
+            break;
+        case IDS_REQ_DISCONNECT:
+            work->result = ids_station_disconnected(work->mac, work->now_us);
+            break;
+        case IDS_REQ_PACKET:
+            work->result = ids_client_packet(work->mac, work->suspicion, work->now_us);
+            break;
+        case IDS_REQ_ACTIVITY:
+            work->result = ids_client_activity(work->mac, work->activity, work->now_us);
+            break;
+        }
+        metric_observe(m_event_cycles, esp_cpu_get_cycle_count() - start);
+        metric_inc(m_requests[shard]);
+        xTaskNotifyGive(work->reply_to);
+    }
+}
+
+esp_err_t ids_workers_start(void)
+{
+    m_event_cycles = metrics_histogram("ids_event_cycles", "Ciclos de CPU por evento no nucleo do IDS",
+                                       event_cycle_bounds, EVENT_CYCLE_BUCKETS);
+    for (uint8_t i = 0; i < IDS_SHARDS; i++) {
+        m_requests[i] = metrics_counter(request_metric_names[i], "Eventos atendidos pelo worker do shard");
+        s_queues[i] = xQueueCreate(IDS_WORKER_QUEUE_LEN, sizeof(ids_work_t *));
+        if (s_queues[i] == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "ids_shard%u", i);
+        if (xTaskCreatePinnedToCore(ids_worker_task, name, IDS_WORKER_STACK_SIZE, (void *)(uintptr_t)i,
+                                    IDS_WORKER_PRIORITY, NULL, i % portNUM_PROCESSORS) != pdPASS) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    ESP_LOGI(TAG, "%d workers do IDS (prioridade %d)", IDS_SHARDS, IDS_WORKER_PRIORITY);
+    return ESP_OK;
+}
+
+static ids_result_t ids_workers_submit(ids_work_t *work)
+{
+    /*
+    @brief Pedido síncrono ao worker do shard do MAC.
+    @note O pedido fica na pilha de quem chama, que espera a notificação
+    (índice 0) antes de retornar; nada é copiado além do ponteiro.
+    */
+    work->reply_to = xTaskGetCurrentTaskHandle();
+    xQueueSend(s_queues[ids_shard_of(work->mac)], &work, portMAX_DELAY);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return work->result;
+}
+
+ids_result_t ids_workers_call(ids_dot11_event_t event, const uint8_t *mac, time_us_t now_us)
+{
+    // Eventos do monitor que não são conexão nem desconexão contam como pacote sem pontuação
+    ids_work_t work = {
+        .kind = event == IDS_DOT11_EVENT_CONNECT      ? IDS_REQ_CONNECT
+                : event == IDS_DOT11_EVENT_DISCONNECT ? IDS_REQ_DISCONNECT
+                                                      : IDS_REQ_PACKET,
+        .mac = mac,
+        .now_us = now_us,
+    };
+    return ids_workers_submit(&work);
+}
+
+ids_result_t ids_workers_call_packet(const uint8_t *mac, uint8_t suspicion, time_us_t now_us)
+{
+    ids_work_t work = {
+        .kind = IDS_REQ_PACKET,
+        .mac = mac,
+        .now_us = now_us,
+        .suspicion = suspicion,
+    };
+    return ids_workers_submit(&work);
+}
+
+ids_result_t ids_workers_call_activity(const uint8_t *mac, const ids_client_activity_t *activity, time_us_t now_us)
+{
+    ids_work_t work = {
+        .kind = IDS_REQ_ACTIVITY,
+        .mac = mac,
+        .now_us = now_us,
+        .activity = activity,
+    };
+    return ids_workers_submit(&work);
+}
+
+void ids_workers_log(const char *tag)
+{
+    // Média desde o boot (sum de 32 bits: em Prometheus use rate(sum)/rate(count))
+    uint32_t events = m_event_cycles ? m_event_cycles->count : 0;
+    if (events > 0) {
+        ESP_LOGI(tag, "  Custo por evento: media %lu ciclos", (unsigned long)(m_event_cycles->sum / events));
+    }
+    for (uint8_t i = 0; i < IDS_SHARDS; i++) {
+        ESP_LOGI(tag, "  Shard %u: %ld eventos, %u na fila", i, (long)metric_value(m_requests[i]),
+                 (unsigned)uxQueueMessagesWaiting(s_queues[i]));
+    }
+}
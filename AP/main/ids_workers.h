@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "ids.h"
+#include "ids_dot11.h"
+
+// Pedidos pendentes por worker (cada pedido é um ponteiro para a pilha de quem espera)
+#define IDS_WORKER_QUEUE_LEN 16
+
+// Uma task por shard do IDS (ids_shard_of), fixada no núcleo shard % portNUM_PROCESSORS.
+// Chamar depois de ids_init() e antes do Wi-Fi subir.
+esp_err_t ids_workers_start(void);
+
+// Envia o evento ao dono do shard do MAC e espera o veredito. Só de tasks
+// (event loop, servidor TCP, monitor multicanal); nunca de ISR ou do callback do Wi-Fi.
+ids_result_t ids_workers_call(ids_dot11_event_t event, const uint8_t *mac, time_us_t now_us);
+
+// Pacote de cliente com a pontuação de conteúdo (payload_sketch) somada à contagem do IDS
+ids_result_t ids_workers_call_packet(const uint8_t *mac, uint8_t suspicion, time_us_t now_us);
+
+// Atividade TCP do cliente (bytes, conexões, erros) somada na janela do monitor do IDS
+ids_result_t ids_workers_call_activity(const uint8_t *mac, const ids_client_activity_t *activity, time_us_t now_us);
+
+// Pedidos atendidos por shard desde o boot (relatório)
+void ids_workers_log(const char *tag);
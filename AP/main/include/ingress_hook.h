@@ -0,0 +1,13 @@
+#pragma once
+
+/*
+ * Hook de entrada IPv4 do lwIP, incluído pelo próprio lwIP através de
+ * ESP_IDF_LWIP_HOOK_FILENAME (ver main/CMakeLists.txt). Mantido mínimo:
+ * só declarações, sem dependências de headers da aplicação.
+ */
+struct pbuf;
+struct netif;
+
+int ingress_filter_ip4_input(struct pbuf *p, struct netif *inp);
+
+#define LWIP_HOOK_IP4_INPUT ingress_filter_ip4_input
@@ -0,0 +1,250 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_netif_net_stack.h"
+#include "lwip/pbuf.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/prot/iana.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/udp.h"
+#include "metrics.h"
+#include "sta_slots.h"
+#include "time_base.h"
+#include "ingress_hook.h"
+#include "ingress_filter.h"
+
+static const char *TAG = "INGRESS";
+
+// Chaves: tipo nos 16 bits altos, MAC (48 bits) ou IPv4 (32 bits) nos baixos
+#define KEY_EMPTY     0ULL
+#define KEY_TYPE_MAC  (1ULL << 48)
+#define KEY_TYPE_IP   (2ULL << 48)
+#define SLOT_MASK     (INGRESS_FILTER_SLOTS - 1)
+
+static uint64_t filter_keys[INGRESS_FILTER_SLOTS];
+static portMUX_TYPE filter_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct netif *filter_netif = NULL;
+
+// Última atividade relatada a sta_slots por estação (mapeamento direto pelo hash do MAC).
+// Só a task tiT usa: sem lock
+#define TOUCH_CACHE_SIZE 16
+static uint64_t touch_keys[TOUCH_CACHE_SIZE];
+static uint32_t touch_ms[TOUCH_CACHE_SIZE];
+
+static metric_t *m_dropped_mac;
+static metric_t *m_dropped_ip;
+static metric_t *m_dhcp_refused;
+static metric_t *m_blocked_entries;
+
+static inline uint64_t mac_key(const uint8_t *mac)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) {
+        key = (key << 8) | mac[i];
+    }
+    return KEY_TYPE_MAC | key;
+}
+
+static inline uint32_t key_slot(uint64_t key)
+{
+    // Mistura de 64 bits (finalizador do splitmix64) reduzida aos bits da tabela
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (uint32_t)key & SLOT_MASK;
+}
+
+static IRAM_ATTR bool filter_contains(uint64_t key)
+{
+    // Chamado com filter_lock adquirido; para no primeiro slot vazio
+    uint32_t slot = key_slot(key);
+    for (int i = 0; i < INGRESS_FILTER_SLOTS; i++) {
+        uint64_t current = filter_keys[(slot + i) & SLOT_MASK];
+        if (current == key) {
+            return true;
+        }
+        if (current == KEY_EMPTY) {
+            return false;
+        }
+    }
+    return false;
+}
+
+static IRAM_ATTR void filter_touch_station(const uint8_t *mac, uint64_t key)
+{
+    // Relata a atividade só no primeiro pacote da estação a cada STA_SLOTS_TOUCH_INTERVAL_MS
+    uint32_t now_ms = time_base_now_ms();
+    uint32_t entry = key_slot(key) & (TOUCH_CACHE_SIZE - 1);
+    if (touch_keys[entry] == key && now_ms - touch_ms[entry] < STA_SLOTS_TOUCH_INTERVAL_MS) {
+        return;
+    }
+    touch_keys[entry] = key;
+    touch_ms[entry] = now_ms;
+    sta_slots_touch(mac, now_ms);
+}
+
+static IRAM_ATTR bool is_dhcp_request(const struct pbuf *p)
+{
+    // DISCOVER/REQUEST para o servidor: UDP com destino na porta 67
+    const struct ip_hdr *iphdr = (const struct ip_hdr *)p->payload;
+    uint16_t hlen = IPH_HL_BYTES(iphdr);
+    if (IPH_PROTO(iphdr) != IP_PROTO_UDP || p->len < hlen + UDP_HLEN) {
+        return false;
+    }
+    const struct udp_hdr *udphdr = (const struct udp_hdr *)((const uint8_t *)p->payload + hlen);
+    return udphdr->dest == PP_HTONS(LWIP_IANA_PORT_DHCP_SERVER);
+}
+
+static void filter_insert(uint64_t key)
+{
+    int free_slot = -1;
+    uint32_t slot = key_slot(key);
+
+    portENTER_CRITICAL(&filter_lock);
+    for (int i = 0; i < INGRESS_FILTER_SLOTS; i++) {
+        uint32_t index = (slot + i) & SLOT_MASK;
+        uint64_t current = filter_keys[index];
+        if (current == key) {
+            break;
+        }
+        if (current == KEY_EMPTY) {
+            free_slot = index;
+            break;
+        }
+    }
+    if (free_slot >= 0) {
+        filter_keys[free_slot] = key;
+        metric_gauge_add(m_blocked_entries, 1);
+    }
+    portEXIT_CRITICAL(&filter_lock);
+}
+
+static void filter_shift_back(uint32_t hole)
+{
+    /*
+    @brief Fecha o buraco deixado por uma remoção (backward-shift deletion).
+    @param hole Slot recém-liberado
+    @note Chamado com filter_lock adquirido. Cada chave seguinte da cadeia que
+    ainda seria encontrada a partir do próprio slot inicial passando pelo buraco
+    é puxada para ele; a cadeia termina no primeiro slot vazio. Sem tombstones,
+    uma busca sem sucesso sempre para no fim do próprio cluster.
+    */
+    uint32_t index = hole;
+    for (int i = 0; i < INGRESS_FILTER_SLOTS - 1; i++) {
+        index = (index + 1) & SLOT_MASK;
+        uint64_t current = filter_keys[index];
+        if (current == KEY_EMPTY) {
+            break;
+        }
+        // Pode mover se o slot inicial não fica entre o buraco (exclusive) e a posição atual
+        uint32_t home = key_slot(current);
+        if (((index - home) & SLOT_MASK) >= ((index - hole) & SLOT_MASK)) {
+            filter_keys[hole] = current;
+            hole = index;
+        }
+    }
+    filter_keys[hole] = KEY_EMPTY;
+}
+
+static void filter_remove(uint64_t key)
+{
+    uint32_t slot = key_slot(key);
+
+    portENTER_CRITICAL(&filter_lock);
+    for (int i = 0; i < INGRESS_FILTER_SLOTS; i++) {
+        uint32_t index = (slot + i) & SLOT_MASK;
+        if (filter_keys[index] == key) {
+            filter_shift_back(index);
+            metric_gauge_add(m_blocked_entries, -1);
+            break;
+        }
+        if (filter_keys[index] == KEY_EMPTY) {
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&filter_lock);
+}
+
+void ingress_filter_init(esp_netif_t *ap_netif)
+{
+    /*
+    @brief Registra as métricas e associa o filtro à netif do AP.
+    @note O hook é compilado no lwIP (ESP_IDF_LWIP_HOOK_FILENAME) e está sempre ativo;
+    tráfego de outras netifs (loopback, STA) nunca é filtrado.
+    */
+    m_dropped_mac = metrics_counter("ingress_dropped_mac_total", "Pacotes IPv4 descartados por MAC bloqueado");
+    m_dropped_ip = metrics_counter("ingress_dropped_ip_total", "Pacotes IPv4 descartados por IP bloqueado");
+    m_dhcp_refused = metrics_counter("ingress_dhcp_refused_total", "Pedidos DHCP de MACs bloqueados descartados");
+    m_blocked_entries = metrics_gauge("ingress_blocked_entries", "MACs e IPs na tabela do filtro de entrada");
+
+    filter_netif = esp_netif_get_netif_impl(ap_netif);
+    ESP_LOGI(TAG, "Filtro de entrada ativo na netif do AP (%d slots)", INGRESS_FILTER_SLOTS);
+}
+
+void ingress_filter_block_mac(const uint8_t *mac)
+{
+    filter_insert(mac_key(mac));
+}
+
+void ingress_filter_unblock_mac(const uint8_t *mac)
+{
+    filter_remove(mac_key(mac));
+}
+
+void ingress_filter_block_ip(uint32_t ip)
+{
+    filter_insert(KEY_TYPE_IP | ip);
+}
+
+void ingress_filter_unblock_ip(uint32_t ip)
+{
+    filter_remove(KEY_TYPE_IP | ip);
+}
+
+IRAM_ATTR int ingress_filter_ip4_input(struct pbuf *p, struct netif *inp)
+{
+    /*
+    @brief Hook LWIP_HOOK_IP4_INPUT: descarta pacotes de estações bloqueadas.
+    @return 1 se o pacote foi consumido (liberado aqui), 0 para seguir no ip4_input
+    @note Roda na task tiT para cada pacote IPv4, antes do TCP/UDP: o custo para
+    um atacante já identificado é uma seção crítica curta e dois lookups de hash.
+    @note Na IRAM, como os lookups: roda para todo pacote do flood sem passar
+    pelo cache da flash.
+    @note O cabeçalho Ethernet já foi removido por ethernet_input, mas continua no
+    buffer; pbuf_header_force o expõe temporariamente para ler o MAC de origem.
+    */
+    if (filter_netif == NULL || inp != filter_netif || p->len < IP_HLEN) {
+        return 0;
+    }
+
+    uint64_t ip_key = KEY_TYPE_IP | ((struct ip_hdr *)p->payload)->src.addr;
+    uint64_t src_mac_key = KEY_EMPTY;
+    uint8_t src_mac[6];
+    if (pbuf_header_force(p, SIZEOF_ETH_HDR) == 0) {
+        memcpy(src_mac, ((struct eth_hdr *)p->payload)->src.addr, 6);
+        src_mac_key = mac_key(src_mac);
+        pbuf_remove_header(p, SIZEOF_ETH_HDR);
+    }
+
+    portENTER_CRITICAL(&filter_lock);
+    bool mac_blocked = src_mac_key != KEY_EMPTY && filter_contains(src_mac_key);
+    bool ip_blocked = !mac_blocked && filter_contains(ip_key);
+    portEXIT_CRITICAL(&filter_lock);
+
+    if (!mac_blocked && !ip_blocked) {
+        // Tráfego de uma estação liberada: atividade para a política de slots
+        if (src_mac_key != KEY_EMPTY) {
+            filter_touch_station(src_mac, src_mac_key);
+        }
+        return 0;
+    }
+
+    metric_inc(mac_blocked ? m_dropped_mac : m_dropped_ip);
+    if (mac_blocked && is_dhcp_request(p)) {
+        // Sem lease para MAC bloqueado: o pedido nunca chega ao servidor DHCP
+        metric_inc(m_dhcp_refused);
+    }
+    pbuf_free(p);
+    return 1;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_netif.h"
+
+// Slots da tabela de bloqueio (potência de 2, ao menos 2x as entradas bloqueadas)
+#define INGRESS_FILTER_SLOTS 64
+
+// Liga o filtro à netif do AP; antes disso todo tráfego passa
+void ingress_filter_init(esp_netif_t *ap_netif);
+
+// Mantidos pelo IDS junto com a blacklist (O(1) esperado, seguros a partir de qualquer task)
+void ingress_filter_block_mac(const uint8_t *mac);
+void ingress_filter_unblock_mac(const uint8_t *mac);
+void ingress_filter_block_ip(uint32_t ip);
+void ingress_filter_unblock_ip(uint32_t ip);
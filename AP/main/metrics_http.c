@@ -0,0 +1,103 @@
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_http_server.h"
+#include "metrics.h"
+#include "metrics_http.h"
+#include "profiler.h"
+#include "task_layout.h"
+
+static const char *TAG = "METRICS_HTTP";
+
+static httpd_handle_t s_server = NULL;
+static metric_t *m_scrapes;
+
+static int httpd_chunk_writer(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len) == ESP_OK ? 0 : -1;
+}
+
+static esp_err_t metrics_get_handler(httpd_req_t *req)
+{
+    /*
+    @brief Responde GET /metrics com o registro completo no formato do Prometheus.
+    @note A resposta é enviada em chunks diretamente do snapshot de cada métrica,
+    então o custo de memória não cresce com o número de métricas.
+    */
+    metric_inc(m_scrapes);
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    if (metrics_export_prometheus(httpd_chunk_writer, req) != 0) {
+        ESP_LOGW(TAG, "Scrape interrompido pelo cliente");
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static esp_err_t profile_get_handler(httpd_req_t *req)
+{
+    /*
+    @brief GET /profile esvazia as amostras do profiler; GET /profile?start=<ms> abre uma janela.
+    @note O texto é simbolizado no host por tools/profiler/fold_stacks.py.
+    */
+    char query[32];
+    char value[12];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "start", value, sizeof(value)) == ESP_OK) {
+        profiler_start((uint32_t)strtoul(value, NULL, 10), "HTTP");
+    }
+
+    httpd_resp_set_type(req, "text/plain");
+    if (profiler_export(httpd_chunk_writer, req) != 0) {
+        ESP_LOGW(TAG, "Download do profile interrompido pelo cliente");
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t metrics_http_start(void)
+{
+    /*
+    @brief Inicia o servidor HTTP leve que exporta as métricas do AP.
+    @note Configuração enxuta: poucos sockets e LRU purge, para que scrapes
+    nunca disputem recursos com o servidor TCP da porta 3333 durante um flood.
+    */
+    if (s_server) {
+        return ESP_OK;
+    }
+
+    m_scrapes = metrics_counter("ap_metrics_scrapes_total", "Requisicoes GET /metrics atendidas");
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = METRICS_HTTP_PORT;
+    config.max_open_sockets = 2;
+    config.max_uri_handlers = 2;
+    config.lru_purge_enable = true;
+    config.stack_size = HTTPD_STACK_SIZE;
+    config.core_id = HTTPD_CORE;
+    config.task_priority = HTTPD_PRIORITY; // abaixo do tcp_server_task
+
+    esp_err_t err = httpd_start(&s_server, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Erro ao iniciar servidor HTTP: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    httpd_uri_t metrics_uri = {
+        .uri = METRICS_HTTP_URI,
+        .method = HTTP_GET,
+        .handler = metrics_get_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(s_server, &metrics_uri);
+
+    httpd_uri_t profile_uri = {
+        .uri = PROFILER_HTTP_URI,
+        .method = HTTP_GET,
+        .handler = profile_get_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(s_server, &profile_uri);
+
+    ESP_LOGI(TAG, "Metricas disponiveis em http://<ip-do-ap>:%d%s", METRICS_HTTP_PORT, METRICS_HTTP_URI);
+    return ESP_OK;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "esp_err.h"
+
+// Porta e caminho do endpoint de métricas (formato de texto do Prometheus)
+#define METRICS_HTTP_PORT 80
+#define METRICS_HTTP_URI "/metrics"
+#define PROFILER_HTTP_URI "/profile"     // amostras do profiler (ver profiler.h)
+
+esp_err_t metrics_http_start(void);
@@ -0,0 +1,77 @@
+#include <string.h>
+#include "metrics.h"
+#include "msg_dedup.h"
+
+typedef struct {
+    uint32_t source_ip;     // 0 = entrada livre
+    uint32_t boot_id;
+    uint32_t last_seq;
+    uint32_t last_seen;
+} dedup_entry_t;
+
+static dedup_entry_t dedup_table[MSG_DEDUP_ENTRIES];
+
+static metric_t *m_duplicates;
+static metric_t *m_gaps;
+
+void msg_dedup_init(void)
+{
+    /*
+    @brief Zera a tabela e registra os contadores.
+    @note Usada apenas pela tcp_server_task, por isso não há lock.
+    */
+    memset(dedup_table, 0, sizeof(dedup_table));
+
+    m_duplicates = metrics_counter("ap_messages_duplicate_total", "Registros reenviados ja processados (descartados)");
+    m_gaps = metrics_counter("ap_messages_gap_total", "Registros que faltaram na sequencia de um cliente");
+}
+
+bool msg_dedup_accept(uint32_t source_ip, uint32_t boot_id, uint32_t seq, uint32_t now_ms)
+{
+    /*
+    @brief Supressão de duplicatas por cliente (IP de origem) e boot id.
+    @param source_ip IP de origem da conexão (ordem de rede)
+    @note O cliente envia em ordem e só remove o que recebeu ACK; um registro com
+    seq <= última vista é um reenvio (ACK perdido). A tabela é pequena e varrida
+    por inteiro; sem espaço, a entrada ociosa há mais tempo (now_ms - last_seen,
+    seguro na volta do contador) é substituída.
+    @note Um boot id diferente no mesmo IP é um reboot do cliente: a entrada do IP
+    recomeça. O boot id de outro cliente, vindo de outro IP, nunca casa.
+    */
+    dedup_entry_t *entry = NULL;
+    dedup_entry_t *oldest = &dedup_table[0];
+
+    for (int i = 0; i < MSG_DEDUP_ENTRIES; i++) {
+        if (dedup_table[i].source_ip == source_ip) {
+            entry = &dedup_table[i];
+            break;
+        }
+        if (oldest->source_ip != 0 &&
+            (dedup_table[i].source_ip == 0 ||
+             now_ms - dedup_table[i].last_seen > now_ms - oldest->last_seen)) {
+            oldest = &dedup_table[i];
+        }
+    }
+
+    if (entry == NULL) {
+        entry = oldest;
+        entry->source_ip = source_ip;
+        entry->boot_id = boot_id;
+        entry->last_seq = 0;
+    } else if (entry->boot_id != boot_id) {
+        entry->boot_id = boot_id;
+        entry->last_seq = 0;
+    }
+    entry->last_seen = now_ms;
+
+    if (seq <= entry->last_seq) {
+        metric_inc(m_duplicates);
+        return false;
+    }
+    if (entry->last_seq != 0 && seq > entry->last_seq + 1) {
+        // Descartados na fila do cliente (cheia durante a queda)
+        metric_add(m_gaps, seq - entry->last_seq - 1);
+    }
+    entry->last_seq = seq;
+    return true;
+}
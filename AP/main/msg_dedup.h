@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Última sequência confirmada por cliente (IP de origem) e boot (fila de saída dos CLIENTS).
+// Cada IP ocupa uma entrada: um boot novo do mesmo IP substitui o anterior, então
+// uma estação não mexe nas sequências das outras nem esvazia a tabela sozinha
+#define MSG_DEDUP_ENTRIES 16
+
+void msg_dedup_init(void);
+
+// true se (source_ip, boot_id, seq) ainda não foi processado; registra a sequência como vista
+bool msg_dedup_accept(uint32_t source_ip, uint32_t boot_id, uint32_t seq, uint32_t now_ms);
@@ -0,0 +1,202 @@
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include "esp_log.h"
+#include "metrics.h"
+#include "payload_sketch.h"
+
+_Static_assert((PAYLOAD_SKETCH_CLIENTS & (PAYLOAD_SKETCH_CLIENTS - 1)) == 0,
+               "PAYLOAD_SKETCH_CLIENTS deve ser potência de 2");
+_Static_assert(PAYLOAD_SKETCH_MAX_BYTES <= 255, "histograma de bytes com contadores de 8 bits");
+
+typedef struct {
+    uint32_t ip;            // 0 = entrada livre
+    uint32_t last_seen;
+    uint16_t entropy_q8;    // média móvel da entropia (bits/byte, Q8)
+    bool has_signature;
+    uint16_t signature[PAYLOAD_SKETCH_HASHES];  // 16 bits altos de cada mínimo da última mensagem
+} sketch_client_t;
+
+static sketch_client_t sketch_clients[PAYLOAD_SKETCH_CLIENTS];
+
+// Multiplicadores ímpares: cada um define uma permutação dos 4-gramas (x * a, depois xor-shift)
+static const uint32_t sketch_mult[PAYLOAD_SKETCH_HASHES] = {
+    0x9e3779b1, 0x85ebca77, 0xc2b2ae3d, 0x27d4eb2f, 0x165667b1, 0xd3a2646d, 0xfd7046c5, 0xb55a4f09,
+    0x7feb352d, 0x846ca68b, 0x2c1b3c6d, 0x297a2d39, 0xa136aaad, 0x9e485565, 0xe6546b65, 0x5bd1e995,
+};
+
+// c * log2(c) em Q8, para a entropia sem log por mensagem
+static uint32_t clog2c_q8[PAYLOAD_SKETCH_MAX_BYTES + 1];
+static uint8_t byte_hist[256];
+
+static metric_t *m_analyzed;
+static metric_t *m_bytes;
+static metric_t *m_repeated;
+static metric_t *m_low_entropy;
+static metric_t *m_tracked;
+
+void payload_sketch_init(void)
+{
+    /*
+    @brief Zera a tabela de clientes, monta a tabela de c*log2(c) e registra as métricas.
+    */
+    memset(sketch_clients, 0, sizeof(sketch_clients));
+    for (int c = 1; c <= PAYLOAD_SKETCH_MAX_BYTES; c++) {
+        clog2c_q8[c] = (uint32_t)lroundf(c * log2f((float)c) * 256.0f);
+    }
+
+    m_analyzed = metrics_counter("payload_messages_analyzed_total", "Mensagens TCP com conteudo analisado");
+    m_bytes = metrics_counter("payload_bytes_analyzed_total", "Bytes de conteudo analisados");
+    m_repeated = metrics_counter("payload_repeated_total", "Mensagens parecidas com a anterior do mesmo cliente");
+    m_low_entropy = metrics_counter("payload_low_entropy_total", "Mensagens de clientes com entropia baixa");
+    m_tracked = metrics_gauge("payload_tracked_clients", "Clientes na tabela de assinaturas de conteudo");
+}
+
+static uint32_t sketch_hash(uint32_t ip)
+{
+    // Hash multiplicativo de Fibonacci, como na tabela de admissão
+    return (ip * 2654435761u) >> (32 - __builtin_ctz(PAYLOAD_SKETCH_CLIENTS));
+}
+
+static sketch_client_t *sketch_lookup(uint32_t ip, uint32_t now_ms)
+{
+    /*
+    @brief Entrada do IP, criada num slot livre ou ocioso da sequência de sondagem.
+    @return NULL se a sequência inteira estiver ocupada por clientes ativos
+    */
+    uint32_t start = sketch_hash(ip);
+    sketch_client_t *reusable = NULL;
+
+    for (uint32_t i = 0; i < PAYLOAD_SKETCH_MAX_PROBE; i++) {
+        sketch_client_t *entry = &sketch_clients[(start + i) & (PAYLOAD_SKETCH_CLIENTS - 1)];
+
+        if (entry->ip == ip) {
+            return entry;
+        }
+        if (reusable == NULL && (entry->ip == 0 || now_ms - entry->last_seen > PAYLOAD_SKETCH_IDLE_MS)) {
+            reusable = entry;
+        }
+    }
+
+    if (reusable == NULL) {
+        return NULL;
+    }
+    if (reusable->ip == 0) {
+        metric_gauge_add(m_tracked, 1);
+    }
+    memset(reusable, 0, sizeof(*reusable));
+    reusable->ip = ip;
+    return reusable;
+}
+
+static uint16_t sketch_message(const uint8_t *data, int len, uint32_t *mins)
+{
+    /*
+    @brief Assinatura MinHash dos 4-gramas e entropia da mensagem.
+    @return Entropia da mensagem em bits/byte (Q8)
+    @note Primeira passada (escalar): o 4-grama é a janela deslizante de 32 bits
+    (rolling hash exato), misturada uma vez; a soma de c*log2(c) é atualizada a
+    cada byte, sem varrer o histograma. Depois, para cada permutação, um mínimo
+    sobre o array de 4-gramas: multiplicação, xor-shift e min, sem dependência
+    entre posições, que o compilador vetoriza onde houver SIMD.
+    */
+    uint32_t shingles[PAYLOAD_SKETCH_MAX_BYTES];
+    uint32_t window = 0;
+    uint32_t sum_clogc = 0;
+    int n_shingles = 0;
+
+    for (int i = 0; i < len; i++) {
+        uint8_t b = data[i];
+        sum_clogc += clog2c_q8[byte_hist[b] + 1] - clog2c_q8[byte_hist[b]];
+        byte_hist[b]++;
+
+        window = (window << 8) | b;
+        if (i >= 3) {
+            uint32_t x = window;
+            x ^= x >> 16;
+            x *= 0x85ebca6b;
+            x ^= x >> 13;
+            shingles[n_shingles++] = x;
+        }
+    }
+    for (int i = 0; i < len; i++) {
+        byte_hist[data[i]] = 0;
+    }
+
+    for (int k = 0; k < PAYLOAD_SKETCH_HASHES; k++) {
+        uint32_t mult = sketch_mult[k];
+        uint32_t lane_min = UINT32_MAX;
+        for (int i = 0; i < n_shingles; i++) {
+            uint32_t h = shingles[i] * mult;
+            h ^= h >> 15;
+            lane_min = h < lane_min ? h : lane_min;
+        }
+        mins[k] = lane_min;
+    }
+
+    // H = log2(n) - (1/n) * soma(c * log2(c))
+    return (uint16_t)((clog2c_q8[len] - sum_clogc) / (uint32_t)len);
+}
+
+uint8_t payload_sketch_score(uint32_t ip, const char *data, int len, uint32_t now_ms)
+{
+    /*
+    @brief Pontua uma mensagem pelo conteúdo: repetição e entropia baixa.
+    @param ip IP de origem (chave do cliente)
+    @param data Conteúdo recebido; só os primeiros PAYLOAD_SKETCH_MAX_BYTES contam
+    @param len Bytes em data
+    @note A assinatura da mensagem substitui a anterior do cliente; a comparação
+    é sempre com a última mensagem (os CLIENTS alternam modelos de texto).
+    */
+    if (len < PAYLOAD_SKETCH_MIN_BYTES) {
+        return 0;
+    }
+    if (len > PAYLOAD_SKETCH_MAX_BYTES) {
+        len = PAYLOAD_SKETCH_MAX_BYTES;
+    }
+
+    uint32_t mins[PAYLOAD_SKETCH_HASHES];
+    uint16_t entropy_q8 = sketch_message((const uint8_t *)data, len, mins);
+    metric_inc(m_analyzed);
+    metric_add(m_bytes, len);
+
+    sketch_client_t *client = sketch_lookup(ip, now_ms);
+    if (client == NULL) {
+        return 0;
+    }
+
+    int matches = 0;
+    for (int k = 0; k < PAYLOAD_SKETCH_HASHES; k++) {
+        uint16_t top = (uint16_t)(mins[k] >> 16);
+        matches += client->signature[k] == top;
+        client->signature[k] = top;
+    }
+
+    uint8_t score = 0;
+    if (client->has_signature && matches >= PAYLOAD_SIMILAR_MIN) {
+        metric_inc(m_repeated);
+        score += PAYLOAD_REPEAT_SCORE;
+    }
+
+    // Média móvel com peso 1/4 para a mensagem nova; a primeira define a média
+    if (client->has_signature) {
+        client->entropy_q8 += ((int32_t)entropy_q8 - (int32_t)client->entropy_q8) / 4;
+    } else {
+        client->entropy_q8 = entropy_q8;
+    }
+    if (client->entropy_q8 < PAYLOAD_LOW_ENTROPY_Q8) {
+        metric_inc(m_low_entropy);
+        score += PAYLOAD_LOW_ENTROPY_SCORE;
+    }
+
+    client->has_signature = true;
+    client->last_seen = now_ms;
+    return score;
+}
+
+void payload_sketch_log(const char *tag)
+{
+    ESP_LOGI(tag, "Conteudo TCP: %ld mensagens analisadas (%ld bytes), %ld repetidas, %ld com entropia baixa",
+             (long)metric_value(m_analyzed), (long)metric_value(m_bytes),
+             (long)metric_value(m_repeated), (long)metric_value(m_low_entropy));
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Análise do conteúdo das mensagens TCP dos clientes, no caminho do servidor.
+ *
+ * O packet flood (PacketFlood) manda mensagens quase iguais; o IDS só as conta.
+ * Cada mensagem recebe aqui uma pontuação de suspeita que o IDS soma à contagem
+ * da janela do cliente (ids_client_packet), então conteúdo repetido chega ao
+ * limite de packet flood com bem menos mensagens:
+ *
+ *   - assinatura MinHash dos 4-gramas de bytes (janela deslizante de 32 bits)
+ *     com PAYLOAD_SKETCH_HASHES permutações; mensagem parecida com a anterior
+ *     do mesmo cliente (>= PAYLOAD_SIMILAR_MIN hashes iguais) soma
+ *     PAYLOAD_REPEAT_SCORE;
+ *   - entropia dos bytes da mensagem (bits/byte), em média móvel por cliente;
+ *     abaixo de PAYLOAD_LOW_ENTROPY_Q8 soma PAYLOAD_LOW_ENTROPY_SCORE.
+ *
+ * Custo limitado: no máximo PAYLOAD_SKETCH_MAX_BYTES por mensagem, uma passada,
+ * sem alocação. O laço das permutações é de tamanho fixo (vetorizável no host).
+ * Usado só pela tcp_server_task: sem lock.
+ */
+
+#define PAYLOAD_SKETCH_HASHES 16            // permutações do MinHash (16 bits guardados de cada)
+#define PAYLOAD_SKETCH_MAX_BYTES 128        // bytes analisados por mensagem (= TCP_RX_BUFFER_SIZE)
+#define PAYLOAD_SKETCH_MIN_BYTES 32         // mensagens menores não são pontuadas
+#define PAYLOAD_SKETCH_CLIENTS 32           // tabela de clientes por IP (potência de 2)
+#define PAYLOAD_SKETCH_MAX_PROBE 8
+#define PAYLOAD_SKETCH_IDLE_MS 10000        // cliente sem mensagens pode ceder a entrada
+
+#ifndef PAYLOAD_SIMILAR_MIN
+#define PAYLOAD_SIMILAR_MIN 10              // de PAYLOAD_SKETCH_HASHES: similaridade de Jaccard ~0,6
+#endif
+#ifndef PAYLOAD_LOW_ENTROPY_Q8
+#define PAYLOAD_LOW_ENTROPY_Q8 (3 * 256)    // 3 bits/byte (texto comum fica acima de 4)
+#endif
+#ifndef PAYLOAD_REPEAT_SCORE
+#define PAYLOAD_REPEAT_SCORE 2
+#endif
+#ifndef PAYLOAD_LOW_ENTROPY_SCORE
+#define PAYLOAD_LOW_ENTROPY_SCORE 2
+#endif
+
+void payload_sketch_init(void);
+
+// Analisa uma mensagem do cliente (IP de origem, ordem de rede) e devolve a
+// pontuação de suspeita a somar no IDS (0 = conteúdo normal)
+uint8_t payload_sketch_score(uint32_t ip, const char *data, int len, uint32_t now_ms);
+
+// Mensagens analisadas e pontuadas desde o boot
+void payload_sketch_log(const char *tag);
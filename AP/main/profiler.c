@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include "profiler.h"
+#include "sys_monitor.h"
+
+#if PROFILER_ENABLED
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gptimer.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_debug_helpers.h"
+#include "esp_ipc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "xtensa/xtensa_context.h"
+
+static const char *TAG = "PROFILER";
+
+typedef struct {
+    uint32_t task;                  // handle da task interrompida
+    uint32_t pc[PROFILER_DEPTH];    // [0] = PC interrompido; 0 = fim da pilha
+} profiler_sample_t;
+
+typedef struct {
+    profiler_sample_t samples[PROFILER_RING_SAMPLES];
+    volatile uint32_t head;         // escrito só pela ISR do núcleo
+    volatile uint32_t tail;         // escrito só por profiler_export()
+    volatile uint32_t dropped;      // ring cheio
+    volatile uint32_t nested;       // a ISR interrompeu outra ISR (sem frame de task)
+    gptimer_handle_t timer;
+} profiler_ring_t;
+
+static profiler_ring_t s_rings[portNUM_PROCESSORS];
+static esp_timer_handle_t s_stop_timer;
+static bool s_active = false;
+
+static metric_t *m_windows;
+static metric_t *m_samples;
+
+// Tasks vivas no momento da exportação (handle -> nome)
+static TaskStatus_t s_tasks[SYS_MONITOR_MAX_TASKS];
+
+static bool IRAM_ATTR profiler_timer_isr(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *arg)
+{
+    /*
+    @brief Uma amostra do núcleo: PC e endereços de retorno da task interrompida.
+    @note Na entrada da interrupção de nível 1 o port do FreeRTOS salva o
+    contexto (XtExcFrame, com as janelas de registradores já despejadas na
+    pilha) e guarda o ponteiro em pxTopOfStack, o primeiro campo do TCB. O
+    backtrace a partir desse frame é o mesmo do panic handler.
+    @note A interrupção é de nível 1: ISRs do mesmo nível (Wi-Fi, por exemplo)
+    e seções críticas atrasam a amostra até o fim delas, então o tempo gasto
+    nelas não aparece. Se uma ISR aninhada for interrompida, não há frame de
+    task e a amostra só é contada em nested.
+    */
+    profiler_ring_t *ring = (profiler_ring_t *)arg;
+
+    if (xPortInterruptedFromISRContext()) {
+        ring->nested++;
+        return false;
+    }
+    uint32_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= PROFILER_RING_SAMPLES) {
+        ring->dropped++;
+        return false;
+    }
+
+    TaskHandle_t task = xTaskGetCurrentTaskHandleForCore(esp_cpu_get_core_id());
+    XtExcFrame *frame = *(XtExcFrame **)task;
+    profiler_sample_t *sample = &ring->samples[head % PROFILER_RING_SAMPLES];
+
+    sample->task = (uint32_t)(uintptr_t)task;
+    esp_backtrace_frame_t bt = {
+        .pc = frame->pc,
+        .sp = frame->a1,
+        .next_pc = frame->a0,
+        .exc_frame = frame,
+    };
+    sample->pc[0] = esp_cpu_process_stack_pc(bt.pc);
+    int depth = 1;
+    while (depth < PROFILER_DEPTH && bt.next_pc != 0) {
+        bool sane = esp_backtrace_get_next_frame(&bt);
+        sample->pc[depth++] = esp_cpu_process_stack_pc(bt.pc);
+        if (!sane) {
+            break;
+        }
+    }
+    for (; depth < PROFILER_DEPTH; depth++) {
+        sample->pc[depth] = 0;
+    }
+
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return false;
+}
+
+static void profiler_setup_core(void *arg)
+{
+    /*
+    @brief Cria o gptimer de um núcleo (executada nele via esp_ipc).
+    @note A interrupção do gptimer é alocada no núcleo que registra o callback.
+    */
+    profiler_ring_t *ring = (profiler_ring_t *)arg;
+
+    gptimer_config_t config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,
+    };
+    ESP_ERROR_CHECK(gptimer_new_timer(&config, &ring->timer));
+
+    gptimer_alarm_config_t alarm = {
+        .alarm_count = 1000000 / PROFILER_HZ,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    ESP_ERROR_CHECK(gptimer_set_alarm_action(ring->timer, &alarm));
+
+    gptimer_event_callbacks_t callbacks = {
+        .on_alarm = profiler_timer_isr,
+    };
+    ESP_ERROR_CHECK(gptimer_register_event_callbacks(ring->timer, &callbacks, ring));
+    ESP_ERROR_CHECK(gptimer_enable(ring->timer));
+}
+
+static void profiler_stop_cb(void *arg)
+{
+    // Fim da janela (task do esp_timer)
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        gptimer_stop(s_rings[core].timer);
+    }
+    __atomic_store_n(&s_active, false, __ATOMIC_RELEASE);
+}
+
+esp_err_t profiler_init(void)
+{
+    m_windows = metrics_counter("ap_profiler_windows_total", "Janelas de amostragem do profiler");
+    m_samples = metrics_counter("ap_profiler_samples_total", "Amostras exportadas pelo profiler");
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        esp_err_t err = esp_ipc_call_blocking(core, profiler_setup_core, &s_rings[core]);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    const esp_timer_create_args_t stop_args = {
+        .callback = profiler_stop_cb,
+        .name = "profiler_stop",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&stop_args, &s_stop_timer));
+
+    ESP_LOGI(TAG, "Profiler pronto: %d Hz por nucleo, %d amostras por ring, profundidade %d",
+             PROFILER_HZ, PROFILER_RING_SAMPLES, PROFILER_DEPTH);
+    return ESP_OK;
+}
+
+void profiler_start(uint32_t duration_ms, const char *reason)
+{
+    bool idle = false;
+    if (s_stop_timer == NULL ||
+        !__atomic_compare_exchange_n(&s_active, &idle, true, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        gptimer_start(s_rings[core].timer);
+    }
+    esp_timer_start_once(s_stop_timer, (uint64_t)duration_ms * 1000);
+    metric_inc(m_windows);
+    ESP_LOGI(TAG, "Amostrando por %lu ms (%s) - baixe com GET /profile",
+             (unsigned long)duration_ms, reason);
+}
+
+void profiler_trigger(const char *reason)
+{
+    profiler_start(PROFILER_WINDOW_MS, reason);
+}
+
+static const char *profiler_task_name(uint32_t handle, UBaseType_t n_tasks)
+{
+    // Só nomes de tasks ainda vivas: o handle de uma task apagada não é desreferenciado
+    for (UBaseType_t i = 0; i < n_tasks; i++) {
+        if ((uint32_t)(uintptr_t)s_tasks[i].xHandle == handle) {
+            return s_tasks[i].pcTaskName;
+        }
+    }
+    return "?";
+}
+
+int profiler_export(metrics_writer_t writer, void *ctx)
+{
+    /*
+    @brief Esvazia os rings: uma linha "<núcleo> <task> <pc0> <pc1> ..." por amostra.
+    @note Chamado só pelo httpd (um exportador por vez). A ISR continua
+    escrevendo enquanto o ring é lido; só o tail avança aqui.
+    */
+    char line[128];
+    UBaseType_t n_tasks = uxTaskGetSystemState(s_tasks, sizeof(s_tasks) / sizeof(s_tasks[0]), NULL);
+
+    int len = snprintf(line, sizeof(line), "# profiler hz=%d depth=%d active=%d\n",
+                       PROFILER_HZ, PROFILER_DEPTH, __atomic_load_n(&s_active, __ATOMIC_ACQUIRE));
+    int err = writer(ctx, line, len);
+
+    for (int core = 0; core < portNUM_PROCESSORS && err == 0; core++) {
+        profiler_ring_t *ring = &s_rings[core];
+        len = snprintf(line, sizeof(line), "# core=%d dropped=%lu nested=%lu\n", core,
+                       (unsigned long)ring->dropped, (unsigned long)ring->nested);
+        err = writer(ctx, line, len);
+
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint32_t tail = ring->tail;
+        for (; tail != head && err == 0; tail++) {
+            const profiler_sample_t *sample = &ring->samples[tail % PROFILER_RING_SAMPLES];
+            len = snprintf(line, sizeof(line), "%d %s", core, profiler_task_name(sample->task, n_tasks));
+            for (int i = 0; i < PROFILER_DEPTH && sample->pc[i] != 0; i++) {
+                len += snprintf(line + len, sizeof(line) - len, " 0x%08lx", (unsigned long)sample->pc[i]);
+            }
+            line[len++] = '\n';
+            err = writer(ctx, line, len);
+            metric_inc(m_samples);
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+    return err;
+}
+
+#else
+
+esp_err_t profiler_init(void)
+{
+    return ESP_OK;
+}
+
+void profiler_start(uint32_t duration_ms, const char *reason)
+{
+}
+
+void profiler_trigger(const char *reason)
+{
+}
+
+int profiler_export(metrics_writer_t writer, void *ctx)
+{
+    static const char disabled[] = "# profiler desabilitado (PROFILER_ENABLED=0)\n";
+    return writer(ctx, disabled, sizeof(disabled) - 1);
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "metrics.h"
+
+/*
+ * Profiler por amostragem: um gptimer por núcleo interrompe PROFILER_HZ vezes
+ * por segundo e a ISR guarda o PC interrompido, alguns endereços de retorno e
+ * a task corrente num ring por núcleo (sem lock: a ISR só escreve o head, o
+ * exportador só escreve o tail). As amostras saem em GET /profile (metrics_http)
+ * e tools/profiler/fold_stacks.py as simboliza contra o ELF em pilhas dobradas
+ * para flame graphs.
+ *
+ * Desligado por padrão (nenhuma memória nem timer); para habilitar:
+ *   idf.py -DAP_EXTRA_DEFINES="PROFILER_ENABLED=1" build
+ */
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 0
+#endif
+#ifndef PROFILER_HZ
+#define PROFILER_HZ 1000                // amostras por segundo, por núcleo
+#endif
+#define PROFILER_DEPTH 4                // PC interrompido + 3 endereços de retorno
+#ifndef PROFILER_RING_SAMPLES
+#define PROFILER_RING_SAMPLES 1024      // por núcleo (20 B cada)
+#endif
+#ifndef PROFILER_WINDOW_MS
+#define PROFILER_WINDOW_MS 1000         // janela disparada por uma detecção
+#endif
+
+// Cria os timers (um por núcleo, parados fora das janelas); sem efeito se desabilitado
+esp_err_t profiler_init(void);
+
+// Inicia uma janela de duration_ms em todos os núcleos (ignorado se já houver uma)
+void profiler_start(uint32_t duration_ms, const char *reason);
+
+// Janela padrão disparada por um detector (seguro de qualquer task)
+void profiler_trigger(const char *reason);
+
+// Esvazia os rings no writer em texto (cabeçalho '#' e uma amostra por linha)
+int profiler_export(metrics_writer_t writer, void *ctx);
@@ -0,0 +1,371 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "metrics.h"
+#include "sta_slots.h"
+
+typedef enum {
+    SLOT_FREE = 0,
+    SLOT_TRUSTED,
+    SLOT_PROBATION,     // associada, sem tráfego IP ainda
+    SLOT_ACTIVE,        // já trafegou; ordenada por atividade
+    SLOT_EVICTING,      // expulsa, aguardando o evento de desconexão
+} slot_state_t;
+
+// Listas circulares por índice; as duas sentinelas ficam depois das estações
+#define LIST_PROBATION STA_SLOTS_CAPACITY
+#define LIST_ACTIVE    (STA_SLOTS_CAPACITY + 1)
+#define INDEX_MASK     (STA_SLOTS_INDEX_SIZE - 1)
+
+static uint64_t slot_keys[STA_SLOTS_CAPACITY];         // MAC em 64 bits, 0 = livre
+static uint8_t slot_index[STA_SLOTS_INDEX_SIZE];       // slot + 1 de cada chave ocupada, 0 = vazio
+static uint8_t slot_state[STA_SLOTS_CAPACITY];
+static uint16_t slot_aid[STA_SLOTS_CAPACITY];
+static uint32_t slot_last_active_ms[STA_SLOTS_CAPACITY];
+static uint8_t link_next[STA_SLOTS_CAPACITY + 2];
+static uint8_t link_prev[STA_SLOTS_CAPACITY + 2];
+
+static int trusted_count = 0;
+static int untrusted_count = 0;     // probation + active
+static int probation_count = 0;
+static portMUX_TYPE slots_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static metric_t *m_trusted;
+static metric_t *m_untrusted;
+static metric_t *m_evictions;
+static metric_t *m_rejected;
+
+static IRAM_ATTR uint64_t mac_key(const uint8_t *mac)
+{
+    uint64_t key = 1ULL << 48;
+    for (int i = 0; i < 6; i++) {
+        key |= (uint64_t)mac[i] << (40 - 8 * i);
+    }
+    return key;
+}
+
+static void key_mac(uint64_t key, uint8_t *mac)
+{
+    for (int i = 0; i < 6; i++) {
+        mac[i] = (uint8_t)(key >> (40 - 8 * i));
+    }
+}
+
+static IRAM_ATTR uint32_t index_home(uint64_t key)
+{
+    // Mesma mistura do filtro de entrada (finalizador do splitmix64)
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (uint32_t)key & INDEX_MASK;
+}
+
+static IRAM_ATTR int slot_find(uint64_t key)
+{
+    // Chamado com slots_lock adquirido; para na primeira posição vazia do índice
+    uint32_t pos = index_home(key);
+    for (int n = 0; n < STA_SLOTS_INDEX_SIZE; n++) {
+        uint8_t entry = slot_index[(pos + n) & INDEX_MASK];
+        if (entry == 0) {
+            return -1;
+        }
+        if (slot_keys[entry - 1] == key) {
+            return entry - 1;
+        }
+    }
+    return -1;
+}
+
+static int slot_claim(uint64_t key)
+{
+    // Slot livre para a chave, já no índice; -1 com a tabela cheia
+    for (int i = 0; i < STA_SLOTS_CAPACITY; i++) {
+        if (slot_keys[i] == 0) {
+            uint32_t pos = index_home(key);
+            while (slot_index[pos] != 0) {
+                pos = (pos + 1) & INDEX_MASK;
+            }
+            slot_index[pos] = i + 1;
+            slot_keys[i] = key;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void slot_free(int i)
+{
+    // Tira a chave do índice (backward-shift, sem tombstones) e libera o slot
+    uint32_t hole = index_home(slot_keys[i]);
+    while (slot_index[hole] != i + 1) {
+        hole = (hole + 1) & INDEX_MASK;
+    }
+    uint32_t pos = hole;
+    for (int n = 0; n < STA_SLOTS_INDEX_SIZE - 1; n++) {
+        pos = (pos + 1) & INDEX_MASK;
+        uint8_t entry = slot_index[pos];
+        if (entry == 0) {
+            break;
+        }
+        uint32_t home = index_home(slot_keys[entry - 1]);
+        if (((pos - home) & INDEX_MASK) >= ((pos - hole) & INDEX_MASK)) {
+            slot_index[hole] = entry;
+            hole = pos;
+        }
+    }
+    slot_index[hole] = 0;
+    slot_keys[i] = 0;
+}
+
+static void list_init(uint8_t head)
+{
+    link_next[head] = head;
+    link_prev[head] = head;
+}
+
+static IRAM_ATTR void list_push_front(uint8_t head, uint8_t i)
+{
+    link_next[i] = link_next[head];
+    link_prev[i] = head;
+    link_prev[link_next[head]] = i;
+    link_next[head] = i;
+}
+
+static IRAM_ATTR void list_unlink(uint8_t i)
+{
+    link_next[link_prev[i]] = link_next[i];
+    link_prev[link_next[i]] = link_prev[i];
+}
+
+static void slot_release(int i)
+{
+    // Tira a estação da sua classe (listas e contadores); o slot continua com a chave
+    switch (slot_state[i]) {
+    case SLOT_TRUSTED:
+        trusted_count--;
+        break;
+    case SLOT_PROBATION:
+        probation_count--;
+        untrusted_count--;
+        list_unlink(i);
+        break;
+    case SLOT_ACTIVE:
+        untrusted_count--;
+        list_unlink(i);
+        break;
+    default:
+        break;
+    }
+    slot_state[i] = SLOT_FREE;
+}
+
+static int slot_victim(int newcomer)
+{
+    // Mais antiga da probation; sem ela, a menos recentemente ativa; a recém-chegada por último
+    uint8_t oldest = link_prev[LIST_PROBATION];
+    if (oldest != LIST_PROBATION && oldest != newcomer) {
+        return oldest;
+    }
+    oldest = link_prev[LIST_ACTIVE];
+    return oldest != LIST_ACTIVE ? oldest : newcomer;
+}
+
+void sta_slots_init(void)
+{
+    /*
+    @brief Zera a tabela de estações e registra as métricas de ocupação.
+    */
+    memset(slot_keys, 0, sizeof(slot_keys));
+    memset(slot_index, 0, sizeof(slot_index));
+    memset(slot_state, SLOT_FREE, sizeof(slot_state));
+    list_init(LIST_PROBATION);
+    list_init(LIST_ACTIVE);
+
+    m_trusted = metrics_gauge("sta_slots_trusted", "Estacoes confiaveis associadas");
+    m_untrusted = metrics_gauge("sta_slots_untrusted", "Estacoes nao confiaveis associadas");
+    m_evictions = metrics_counter("sta_slots_evictions_total", "Estacoes nao confiaveis expulsas para liberar slots");
+    m_rejected = metrics_counter("sta_slots_rejected_total", "Associacoes desfeitas com a tabela de estacoes cheia");
+}
+
+sta_slots_decision_t sta_slots_connect(const uint8_t *mac, uint16_t aid, bool trusted, uint32_t now_ms)
+{
+    /*
+    @brief Registra uma associação e escolhe uma vítima se os slots não confiáveis estourarem.
+    @param trusted MAC da allowlist: ocupa os slots reservados e nunca é expulso
+    @note Expulsa no máximo uma estação por associação: com uma associação por
+    evento, os limites nunca são ultrapassados por mais de uma.
+    @note Também expulsa quando a ocupação total chega ao limite do driver, para
+    que uma estação confiável sempre encontre um slot livre.
+    */
+    sta_slots_decision_t decision = {.result = STA_SLOTS_ACCEPT};
+    uint64_t key = mac_key(mac);
+
+    portENTER_CRITICAL(&slots_lock);
+    int i = slot_find(key);
+    if (i >= 0) {
+        slot_release(i);        // reassociação: reaproveita a entrada
+    } else {
+        i = slot_claim(key);
+    }
+    if (i < 0) {
+        portEXIT_CRITICAL(&slots_lock);
+        metric_inc(m_rejected);
+        decision.result = STA_SLOTS_REJECT_FULL;
+        return decision;
+    }
+
+    slot_aid[i] = aid;
+    slot_last_active_ms[i] = now_ms;
+    if (trusted) {
+        slot_state[i] = SLOT_TRUSTED;
+        trusted_count++;
+    } else {
+        slot_state[i] = SLOT_PROBATION;
+        list_push_front(LIST_PROBATION, i);
+        probation_count++;
+        untrusted_count++;
+    }
+
+    if (untrusted_count > 0 && (untrusted_count > STA_SLOTS_UNTRUSTED_MAX ||
+                                trusted_count + untrusted_count >= STA_SLOTS_MAX_STA)) {
+        int victim = slot_victim(i);
+        slot_release(victim);
+        slot_state[victim] = SLOT_EVICTING;
+        decision.result = STA_SLOTS_ACCEPT_EVICT;
+        decision.evicted_aid = slot_aid[victim];
+        key_mac(slot_keys[victim], decision.evicted_mac);
+    }
+    int trusted_now = trusted_count;
+    int untrusted_now = untrusted_count;
+    portEXIT_CRITICAL(&slots_lock);
+
+    metric_set(m_trusted, trusted_now);
+    metric_set(m_untrusted, untrusted_now);
+    if (decision.result == STA_SLOTS_ACCEPT_EVICT) {
+        metric_inc(m_evictions);
+    }
+    return decision;
+}
+
+bool sta_slots_disconnect(const uint8_t *mac)
+{
+    bool evicted = false;
+
+    portENTER_CRITICAL(&slots_lock);
+    int i = slot_find(mac_key(mac));
+    if (i >= 0) {
+        evicted = slot_state[i] == SLOT_EVICTING;
+        slot_release(i);
+        slot_free(i);
+    }
+    int trusted_now = trusted_count;
+    int untrusted_now = untrusted_count;
+    portEXIT_CRITICAL(&slots_lock);
+
+    metric_set(m_trusted, trusted_now);
+    metric_set(m_untrusted, untrusted_now);
+    return evicted;
+}
+
+bool sta_slots_kick(const uint8_t *mac, uint16_t *aid)
+{
+    /*
+    @brief Marca como expulsa uma estação que o AP vai desautenticar.
+    @param aid Entrada: AID do evento de associação (0 = desconhecido); saída: AID a desautenticar
+    @return false se a estação é confiável ou não há AID para desautenticar
+    @note Sem slot livre para uma estação nova, o AID do evento ainda é devolvido:
+    a desconexão dela contará como uma desconexão comum.
+    */
+    uint64_t key = mac_key(mac);
+    bool kick = true;
+
+    portENTER_CRITICAL(&slots_lock);
+    int i = slot_find(key);
+    if (i >= 0) {
+        if (slot_state[i] == SLOT_TRUSTED) {
+            kick = false;
+        } else {
+            slot_release(i);
+            slot_state[i] = SLOT_EVICTING;
+            *aid = slot_aid[i];
+        }
+    } else if (*aid == 0) {
+        kick = false;
+    } else if ((i = slot_claim(key)) >= 0) {
+        slot_aid[i] = *aid;
+        slot_state[i] = SLOT_EVICTING;
+    }
+    int untrusted_now = untrusted_count;
+    portEXIT_CRITICAL(&slots_lock);
+
+    metric_set(m_untrusted, untrusted_now);
+    return kick;
+}
+
+IRAM_ATTR void sta_slots_touch(const uint8_t *mac, uint32_t now_ms)
+{
+    /*
+    @brief Tráfego IP de uma estação: a primeira vez a tira da probation.
+    @note Chamado pelo hook do lwIP (na IRAM, como ele), no máximo uma vez por
+    estação a cada STA_SLOTS_TOUCH_INTERVAL_MS; a estação que já está no topo da
+    lista ativa só tem o instante atualizado.
+    */
+    uint64_t key = mac_key(mac);
+
+    portENTER_CRITICAL(&slots_lock);
+    int i = slot_find(key);
+    if (i >= 0) {
+        slot_last_active_ms[i] = now_ms;
+        if (slot_state[i] == SLOT_PROBATION) {
+            list_unlink(i);
+            probation_count--;
+            slot_state[i] = SLOT_ACTIVE;
+            list_push_front(LIST_ACTIVE, i);
+        } else if (slot_state[i] == SLOT_ACTIVE && link_next[LIST_ACTIVE] != i) {
+            list_unlink(i);
+            list_push_front(LIST_ACTIVE, i);
+        }
+    }
+    portEXIT_CRITICAL(&slots_lock);
+}
+
+void sta_slots_log(const char *tag, uint32_t now_ms)
+{
+    // Cópia sob o lock; o log sai fora dele
+    uint8_t victim_mac[6] = {0};
+    uint32_t victim_idle_ms = 0;
+
+    portENTER_CRITICAL(&slots_lock);
+    int trusted_now = trusted_count;
+    int untrusted_now = untrusted_count;
+    int probation_now = probation_count;
+    int victim = untrusted_count > 0 ? slot_victim(-1) : -1;
+    if (victim >= 0) {
+        key_mac(slot_keys[victim], victim_mac);
+        victim_idle_ms = now_ms - slot_last_active_ms[victim];
+    }
+    portEXIT_CRITICAL(&slots_lock);
+
+    ESP_LOGI(tag, "Slots: %d confiaveis (%d reservados), %d/%d nao confiaveis (%d sem trafego), expulsas %ld",
+             trusted_now, STA_SLOTS_RESERVED, untrusted_now, STA_SLOTS_UNTRUSTED_MAX, probation_now,
+             (long)metric_value(m_evictions));
+    if (victim >= 0) {
+        ESP_LOGI(tag, "  Proxima vitima: %02x:%02x:%02x:%02x:%02x:%02x (%s, ociosa ha %lu ms)",
+                 victim_mac[0], victim_mac[1], victim_mac[2], victim_mac[3], victim_mac[4], victim_mac[5],
+                 probation_now > 0 ? "sem trafego" : "menos ativa", (unsigned long)victim_idle_ms);
+    }
+}
+
+const char *sta_slots_result_name(sta_slots_result_t result)
+{
+    switch (result) {
+    case STA_SLOTS_ACCEPT:
+        return "ACEITA";
+    case STA_SLOTS_ACCEPT_EVICT:
+        return "EXPULSAO";
+    case STA_SLOTS_REJECT_FULL:
+        return "TABELA_CHEIA";
+    }
+    return "?";
+}
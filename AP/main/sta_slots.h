@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Defesa contra esgotamento dos slots de associação (AP_MAX_STA_CONN).
+ *
+ * Um auth flood com MACs aleatórios associa estações que nunca trafegam e
+ * ocupa todos os slots do driver. Estações confiáveis (allowlist) têm
+ * STA_SLOTS_RESERVED slots só para elas: as demais nunca passam de
+ * STA_SLOTS_UNTRUSTED_MAX, e cada associação que ultrapassa esse limite
+ * expulsa uma estação não confiável.
+ *
+ * As não confiáveis ficam em duas listas ordenadas por atividade:
+ *   - probation: associadas que ainda não enviaram tráfego IP (o flood fica aqui);
+ *   - active: já enviaram tráfego, da mais recente para a menos recente.
+ * A vítima é a mais antiga da probation, ou, com a probation vazia, a menos
+ * recentemente ativa. Associar, trafegar e escolher a vítima são O(1) nas
+ * listas; a busca pelo MAC usa um índice hash (sondagem linear) de
+ * STA_SLOTS_INDEX_SIZE posições.
+ *
+ * Atualizado pelo event loop (associações) e pela task do lwIP (atividade,
+ * no hook do filtro de entrada), sob um spinlock curto. O hook só relata a
+ * atividade de uma estação uma vez a cada STA_SLOTS_TOUCH_INTERVAL_MS.
+ */
+
+#ifndef STA_SLOTS_MAX_STA
+#define STA_SLOTS_MAX_STA 20            // = AP_MAX_STA_CONN
+#endif
+#ifndef STA_SLOTS_RESERVED
+#define STA_SLOTS_RESERVED 4            // slots só para estações confiáveis
+#endif
+#define STA_SLOTS_UNTRUSTED_MAX (STA_SLOTS_MAX_STA - STA_SLOTS_RESERVED)
+#define STA_SLOTS_CAPACITY (STA_SLOTS_MAX_STA + 4)   // folga para expulsas ainda sem evento de desconexão
+#define STA_SLOTS_INDEX_SIZE 32                       // índice MAC -> slot (potência de 2, > STA_SLOTS_CAPACITY)
+#ifndef STA_SLOTS_TOUCH_INTERVAL_MS
+#define STA_SLOTS_TOUCH_INTERVAL_MS 1000              // atividade relatada pelo hook, no máximo uma vez por estação
+#endif
+
+_Static_assert(STA_SLOTS_RESERVED < STA_SLOTS_MAX_STA, "STA_SLOTS_RESERVED deve deixar slots para os demais");
+_Static_assert(STA_SLOTS_CAPACITY < 254, "índices das listas são uint8_t");
+_Static_assert((STA_SLOTS_INDEX_SIZE & (STA_SLOTS_INDEX_SIZE - 1)) == 0 && STA_SLOTS_INDEX_SIZE > STA_SLOTS_CAPACITY,
+               "STA_SLOTS_INDEX_SIZE deve ser potência de 2 maior que STA_SLOTS_CAPACITY");
+
+typedef enum {
+    STA_SLOTS_ACCEPT = 0,
+    STA_SLOTS_ACCEPT_EVICT,     // aceita; desautenticar a vítima em evicted_aid
+    STA_SLOTS_REJECT_FULL,      // tabela cheia: desautenticar a estação nova
+} sta_slots_result_t;
+
+typedef struct {
+    sta_slots_result_t result;
+    uint16_t evicted_aid;
+    uint8_t evicted_mac[6];
+} sta_slots_decision_t;
+
+void sta_slots_init(void);
+
+// Estação associada (event loop). trusted: MAC da allowlist
+sta_slots_decision_t sta_slots_connect(const uint8_t *mac, uint16_t aid, bool trusted, uint32_t now_ms);
+
+// Estação saiu; true se a saída foi causada por uma expulsão nossa (não é sinal de deauth flood)
+bool sta_slots_disconnect(const uint8_t *mac);
+
+// Desautenticação decidida pelo AP (bloqueio pelo IDS): marca a estação como expulsa
+// e devolve o AID em *aid. Uma estação ainda fora da tabela (recusada na associação)
+// é registrada com o AID recebido em *aid. false para estação confiável ou AID desconhecido
+bool sta_slots_kick(const uint8_t *mac, uint16_t *aid);
+
+// Tráfego IP da estação (hook do lwIP, na IRAM): promove da probation e move para o topo da lista ativa
+void sta_slots_touch(const uint8_t *mac, uint32_t now_ms);
+
+// Ocupação por classe e a próxima vítima (relatório periódico)
+void sta_slots_log(const char *tag, uint32_t now_ms);
+
+const char *sta_slots_result_name(sta_slots_result_t result);
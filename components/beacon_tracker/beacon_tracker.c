@@ -0,0 +1,355 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "beacon_tracker.h"
+#include "ids_dot11.h"
+#include "metrics.h"
+
+#define SLOT_MASK (BEACON_TRACKER_SLOTS - 1)
+
+// Bits estáveis do Capability Info (ESS, IBSS, Privacy); os demais mudam com as estações associadas
+#define CAPABILITY_MASK 0x0013
+#define CAPABILITY_PRIVACY 0x0010
+
+// Beacon/probe response: timestamp (8), intervalo (2) e capacidades (2) antes dos elementos
+#define FIXED_FIELDS_LEN 12
+
+#define IE_SSID 0
+#define IE_DS_PARAMS 3
+#define IE_RSN 48
+#define IE_VENDOR 221
+
+_Static_assert((BEACON_TRACKER_SLOTS & SLOT_MASK) == 0, "BEACON_TRACKER_SLOTS deve ser potência de 2");
+
+typedef struct {
+    beacon_tracker_entry_t info;
+    int16_t rssi_x16;           // média em ponto fixo (x16)
+    uint8_t reported;           // alertas já entregues por beacon_tracker_poll
+    bool used;
+} beacon_slot_t;
+
+// Campos extraídos do quadro antes de tocar na tabela (fora do lock)
+typedef struct {
+    const uint8_t *bssid;
+    const uint8_t *ssid;
+    uint8_t ssid_len;
+    uint8_t channel;
+    uint16_t beacon_interval;
+    uint16_t capability;
+    uint32_t security;
+} beacon_fields_t;
+
+static beacon_tracker_config_t s_config;
+static uint8_t s_ssid_len;
+static beacon_slot_t s_slots[BEACON_TRACKER_SLOTS];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t s_pending = 0;
+
+static metric_t *m_frames;
+static metric_t *m_evictions;
+static metric_t *m_alerts;
+
+static uint32_t bssid_slot(const uint8_t *bssid)
+{
+    // Mesmo finalizador (splitmix64) do filtro de entrada
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) {
+        key = (key << 8) | bssid[i];
+    }
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (uint32_t)key & SLOT_MASK;
+}
+
+static uint32_t parse_suites(const uint8_t *ie, uint32_t len)
+{
+    /*
+    @brief Cifras pareadas e AKMs de um elemento RSN (ou do corpo do WPA após OUI e tipo).
+    @note Layout: versão (2), cifra de grupo (4), N + N suítes pareadas, M + M AKMs.
+    Listas truncadas são lidas até onde couberem.
+    */
+    uint32_t security = 0;
+    uint32_t pos = 6;
+
+    for (int list = 0; list < 2; list++) {
+        if (pos + 2 > len) {
+            break;
+        }
+        uint32_t count = ie[pos] | (ie[pos + 1] << 8);
+        pos += 2;
+        for (uint32_t i = 0; i < count && pos + 4 <= len; i++, pos += 4) {
+            uint8_t type = ie[pos + 3];
+            security |= list == 0 ? BEACON_SEC_CIPHER(type) : BEACON_SEC_AKM(type);
+        }
+    }
+    return security;
+}
+
+static bool parse_beacon(const ids_dot11_hdr_t *hdr, uint8_t rx_channel, beacon_fields_t *out)
+{
+    /*
+    @brief Extrai SSID, canal e impressão digital de segurança dos elementos.
+    @note Um passo sobre os elementos (limitado pelo tamanho do quadro), sem cópia.
+    */
+    if (hdr->body_len < FIXED_FIELDS_LEN) {
+        return false;
+    }
+
+    const uint8_t *body = hdr->body;
+    out->bssid = hdr->addr3;
+    out->ssid = NULL;
+    out->ssid_len = 0;
+    out->channel = rx_channel;
+    out->beacon_interval = body[8] | (body[9] << 8);
+    out->capability = body[10] | (body[11] << 8);
+    out->security = (out->capability & CAPABILITY_PRIVACY) ? BEACON_SEC_PRIVACY : 0;
+
+    bool ssid_seen = false;
+    uint32_t pos = FIXED_FIELDS_LEN;
+    while (pos + 2 <= hdr->body_len) {
+        uint8_t id = body[pos];
+        uint8_t ie_len = body[pos + 1];
+        const uint8_t *ie = body + pos + 2;
+        if (pos + 2 + ie_len > hdr->body_len) {
+            break;
+        }
+
+        if (id == IE_SSID && !ssid_seen && ie_len <= BEACON_TRACKER_SSID_MAX) {
+            out->ssid = ie;
+            out->ssid_len = ie_len;
+            ssid_seen = true;
+        } else if (id == IE_DS_PARAMS && ie_len >= 1) {
+            out->channel = ie[0];
+        } else if (id == IE_RSN && ie_len >= 2) {
+            out->security |= BEACON_SEC_RSN | parse_suites(ie, ie_len);
+        } else if (id == IE_VENDOR && ie_len >= 6 &&
+                   ie[0] == 0x00 && ie[1] == 0x50 && ie[2] == 0xF2 && ie[3] == 0x01) {
+            out->security |= BEACON_SEC_WPA | parse_suites(ie + 4, ie_len - 4);
+        }
+        pos += 2 + ie_len;
+    }
+    return true;
+}
+
+static uint8_t beacon_alerts(const beacon_fields_t *fields)
+{
+    // Comparação com a rede protegida; ssid vazio (rede oculta) só é comparado pelo BSSID
+    uint8_t alerts = 0;
+    bool own_bssid = ids_dot11_mac_equal(fields->bssid, s_config.bssid);
+    bool own_ssid = fields->ssid_len == s_ssid_len && s_ssid_len > 0 &&
+                    memcmp(fields->ssid, s_config.ssid, s_ssid_len) == 0;
+
+    if (own_bssid) {
+        alerts |= BEACON_ALERT_BSSID_SPOOF;
+    } else if (own_ssid) {
+        alerts |= BEACON_ALERT_SSID_CLONE;
+    }
+
+    if (own_ssid || own_bssid) {
+        // Classe (aberta, WPA, RSN) exata; cifras e AKMs esperados precisam estar presentes
+        const uint32_t class_mask = BEACON_SEC_PRIVACY | BEACON_SEC_RSN | BEACON_SEC_WPA;
+        bool class_differs = (fields->security & class_mask) != (s_config.security & class_mask);
+        bool suites_missing = (fields->security & s_config.security & ~class_mask) !=
+                              (s_config.security & ~class_mask);
+        bool interval_differs = s_config.beacon_interval && fields->beacon_interval != s_config.beacon_interval;
+        if (class_differs || suites_missing || interval_differs) {
+            alerts |= BEACON_ALERT_SECURITY;
+        }
+    }
+    return alerts;
+}
+
+static void slot_fill(beacon_slot_t *slot, const beacon_fields_t *fields, int8_t rssi, uint32_t now_ms)
+{
+    memset(slot, 0, sizeof(*slot));
+    memcpy(slot->info.bssid, fields->bssid, 6);
+    slot->info.channel = fields->channel;
+    slot->info.beacon_interval = fields->beacon_interval;
+    slot->info.capability = fields->capability;
+    slot->info.security = fields->security;
+    slot->info.first_seen_ms = now_ms;
+    slot->rssi_x16 = rssi * 16;
+    slot->used = true;
+}
+
+void beacon_tracker_init(const beacon_tracker_config_t *config)
+{
+    s_config = *config;
+    s_ssid_len = (uint8_t)strnlen(config->ssid, BEACON_TRACKER_SSID_MAX);
+    memset(s_slots, 0, sizeof(s_slots));
+
+    m_frames = metrics_counter("beacon_tracker_frames_total", "Beacons e probe responses analisados");
+    m_evictions = metrics_counter("beacon_tracker_evictions_total", "BSSIDs vivos substituidos com a janela cheia");
+    m_alerts = metrics_counter("beacon_tracker_alerts_total", "Alertas de AP falso (novos bits por BSSID)");
+}
+
+void beacon_tracker_observe(const uint8_t *frame, uint32_t len, uint8_t rx_channel, int8_t rssi, uint32_t now_ms)
+{
+    /*
+    @brief Atualiza a entrada do BSSID e marca alertas.
+    @note Roda na task do Wi-Fi: no máximo BEACON_TRACKER_MAX_PROBE slots
+    comparados dentro do lock, sem alocação e sem log.
+    @note Entradas só são substituídas, nunca removidas: a cadeia de sondagem
+    continua válida e não há tombstones.
+    */
+    ids_dot11_hdr_t hdr;
+    beacon_fields_t fields;
+
+    if (!ids_dot11_parse(frame, len, &hdr) || hdr.type != IDS_DOT11_TYPE_MGMT ||
+        (hdr.subtype != IDS_DOT11_MGMT_BEACON && hdr.subtype != IDS_DOT11_MGMT_PROBE_RESP) ||
+        !parse_beacon(&hdr, rx_channel, &fields)) {
+        return;
+    }
+    metric_inc(m_frames);
+
+    uint8_t alerts = beacon_alerts(&fields);
+    uint32_t start = bssid_slot(fields.bssid);
+    beacon_slot_t *found = NULL;
+    beacon_slot_t *reusable = NULL;     // vazio ou expirado
+    beacon_slot_t *oldest = NULL;
+
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < BEACON_TRACKER_MAX_PROBE; i++) {
+        beacon_slot_t *slot = &s_slots[(start + i) & SLOT_MASK];
+        if (!slot->used) {
+            if (reusable == NULL) {
+                reusable = slot;
+            }
+            break;
+        }
+        if (ids_dot11_mac_equal(slot->info.bssid, fields.bssid)) {
+            found = slot;
+            break;
+        }
+        if (reusable == NULL && now_ms - slot->info.last_seen_ms > s_config.max_age_ms) {
+            reusable = slot;
+        }
+        if (oldest == NULL || slot->info.last_seen_ms < oldest->info.last_seen_ms) {
+            oldest = slot;
+        }
+    }
+
+    bool evicted = false;
+    if (found) {
+        beacon_tracker_entry_t *info = &found->info;
+        if (info->channel != fields.channel || info->security != fields.security ||
+            info->beacon_interval != fields.beacon_interval ||
+            ((info->capability ^ fields.capability) & CAPABILITY_MASK)) {
+            // Dois rádios com o mesmo BSSID (ou um AP reconfigurado)
+            alerts |= BEACON_ALERT_FINGERPRINT;
+            info->channel = fields.channel;
+            info->security = fields.security;
+            info->beacon_interval = fields.beacon_interval;
+        }
+        info->capability = fields.capability;
+        found->rssi_x16 += (rssi * 16 - found->rssi_x16) / 8;
+    } else {
+        found = reusable ? reusable : oldest;
+        evicted = reusable == NULL;
+        slot_fill(found, &fields, rssi, now_ms);
+    }
+
+    beacon_tracker_entry_t *info = &found->info;
+    if (fields.ssid_len > 0) {
+        // Redes ocultas mandam SSID vazio no beacon e o nome só na probe response
+        memcpy(info->ssid, fields.ssid, fields.ssid_len);
+        info->ssid[fields.ssid_len] = '\0';
+    }
+    info->rssi = (int8_t)(found->rssi_x16 / 16);
+    info->last_seen_ms = now_ms;
+    info->beacons++;
+
+    uint8_t new_alerts = alerts & ~info->alerts;
+    info->alerts |= alerts;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (evicted) {
+        metric_inc(m_evictions);
+    }
+    if (new_alerts) {
+        metric_inc(m_alerts);
+        __atomic_fetch_add(&s_pending, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void beacon_tracker_poll(beacon_tracker_alert_cb_t cb, void *ctx)
+{
+    /*
+    @brief Entrega cada alerta novo uma vez, com uma cópia da entrada.
+    @note O callback roda fora do lock (pode logar).
+    */
+    if (__atomic_exchange_n(&s_pending, 0, __ATOMIC_ACQUIRE) == 0) {
+        return;
+    }
+
+    for (int i = 0; i < BEACON_TRACKER_SLOTS; i++) {
+        beacon_tracker_entry_t entry;
+        uint8_t new_alerts;
+
+        portENTER_CRITICAL(&s_lock);
+        beacon_slot_t *slot = &s_slots[i];
+        new_alerts = slot->used ? slot->info.alerts & ~slot->reported : 0;
+        if (new_alerts) {
+            slot->reported |= new_alerts;
+            entry = slot->info;
+        }
+        portEXIT_CRITICAL(&s_lock);
+
+        if (new_alerts) {
+            cb(&entry, new_alerts, ctx);
+        }
+    }
+}
+
+const char *beacon_tracker_alert_name(uint8_t alert)
+{
+    switch (alert) {
+    case BEACON_ALERT_SSID_CLONE:
+        return "SSID CLONADO";
+    case BEACON_ALERT_BSSID_SPOOF:
+        return "BSSID FORJADO";
+    case BEACON_ALERT_SECURITY:
+        return "SEGURANCA DIVERGENTE";
+    case BEACON_ALERT_FINGERPRINT:
+        return "IMPRESSAO DIGITAL ALTERADA";
+    default:
+        return "DESCONHECIDO";
+    }
+}
+
+void beacon_tracker_log(const char *tag, uint32_t now_ms)
+{
+    /*
+    @brief Total de BSSIDs vivos e uma linha por entrada suspeita.
+    */
+    int live = 0;
+    int suspicious = 0;
+
+    ESP_LOGI(tag, "=== RASTREADOR DE BEACONS ===");
+    for (int i = 0; i < BEACON_TRACKER_SLOTS; i++) {
+        beacon_tracker_entry_t entry;
+
+        portENTER_CRITICAL(&s_lock);
+        bool used = s_slots[i].used;
+        entry = s_slots[i].info;
+        portEXIT_CRITICAL(&s_lock);
+
+        if (!used || now_ms - entry.last_seen_ms > s_config.max_age_ms) {
+            continue;
+        }
+        live++;
+        if (!entry.alerts) {
+            continue;
+        }
+        suspicious++;
+        ESP_LOGI(tag, "  %02x:%02x:%02x:%02x:%02x:%02x \"%s\" canal %d, RSSI %d, intervalo %u TU, seg 0x%06lx, "
+                 "%lu beacons, visto ha %lu s, alertas 0x%x",
+                 entry.bssid[0], entry.bssid[1], entry.bssid[2], entry.bssid[3], entry.bssid[4], entry.bssid[5],
+                 entry.ssid, entry.channel, entry.rssi, entry.beacon_interval, (unsigned long)entry.security,
+                 (unsigned long)entry.beacons, (unsigned long)((now_ms - entry.last_seen_ms) / 1000), entry.alerts);
+    }
+    ESP_LOGI(tag, "  BSSIDs vivos: %d/%d, suspeitos: %d, alertas: %ld, substituicoes: %ld",
+             live, BEACON_TRACKER_SLOTS, suspicious,
+             (long)metric_value(m_alerts), (long)metric_value(m_evictions));
+}
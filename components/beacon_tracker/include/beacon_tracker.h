@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Rastreador de beacons e probe responses para detectar APs falsos (evil twin).
+ *
+ * Cada BSSID ouvido ocupa uma entrada de uma tabela hash de tamanho fixo
+ * (endereçamento aberto, no máximo BEACON_TRACKER_MAX_PROBE slots por busca).
+ * Entradas sem beacon há max_age_ms são reaproveitadas; com a janela de busca
+ * toda ocupada, a mais antiga é substituída. O custo por beacon é constante e
+ * a memória é fixa, independente de quantos APs existem ao redor.
+ *
+ * As entradas são comparadas com a rede protegida (SSID, BSSID, segurança e
+ * intervalo de beacon). beacon_tracker_observe() roda no callback do Wi-Fi e
+ * só marca alertas; beacon_tracker_poll() os entrega fora dele.
+ */
+
+#ifndef BEACON_TRACKER_SLOTS
+#define BEACON_TRACKER_SLOTS 64         // potência de 2
+#endif
+#define BEACON_TRACKER_MAX_PROBE 8
+#define BEACON_TRACKER_SSID_MAX 32
+
+// Impressão digital de segurança: bits de presença + cifras pareadas e AKMs do RSN/WPA
+#define BEACON_SEC_PRIVACY   (1u << 0)  // bit Privacy do Capability Info
+#define BEACON_SEC_RSN       (1u << 1)  // elemento RSN (WPA2/WPA3)
+#define BEACON_SEC_WPA       (1u << 2)  // elemento WPA do fabricante (WPA1)
+#define BEACON_SEC_CIPHER(t) (1u << (8 + ((t) & 0x7)))     // tipo da suíte (4 = CCMP, 2 = TKIP)
+#define BEACON_SEC_AKM(t)    (1u << (16 + ((t) & 0xF)))    // tipo do AKM (2 = PSK, 8 = SAE)
+
+// Alertas (bits de beacon_tracker_entry_t.alerts)
+#define BEACON_ALERT_SSID_CLONE     (1u << 0)   // outro BSSID anunciando o nosso SSID
+#define BEACON_ALERT_BSSID_SPOOF    (1u << 1)   // o nosso BSSID transmitido por outro rádio
+#define BEACON_ALERT_SECURITY       (1u << 2)   // nosso SSID com segurança/intervalo diferentes
+#define BEACON_ALERT_FINGERPRINT    (1u << 3)   // mesmo BSSID alternando canal, capacidades ou segurança
+
+typedef struct {
+    const char *ssid;               // rede protegida
+    uint8_t bssid[6];               // BSSID do próprio AP (o rádio não recebe os próprios beacons)
+    uint16_t beacon_interval;       // em TU; 0 = não comparar
+    uint32_t security;              // BEACON_SEC_* esperados
+    uint32_t max_age_ms;            // entrada sem beacon por este tempo pode ser reaproveitada
+} beacon_tracker_config_t;
+
+// Cópia de uma entrada (para alertas e relatórios)
+typedef struct {
+    uint8_t bssid[6];
+    char ssid[BEACON_TRACKER_SSID_MAX + 1];
+    uint8_t channel;                // do DS Parameter Set (ou do rádio, se ausente)
+    int8_t rssi;                    // média móvel exponencial (alfa 1/8)
+    uint16_t beacon_interval;
+    uint16_t capability;
+    uint32_t security;
+    uint32_t beacons;
+    uint32_t first_seen_ms;
+    uint32_t last_seen_ms;
+    uint8_t alerts;
+} beacon_tracker_entry_t;
+
+typedef void (*beacon_tracker_alert_cb_t)(const beacon_tracker_entry_t *entry, uint8_t new_alerts, void *ctx);
+
+void beacon_tracker_init(const beacon_tracker_config_t *config);
+
+// Beacon ou probe response cru (sem FCS). Outros quadros são ignorados.
+void beacon_tracker_observe(const uint8_t *frame, uint32_t len, uint8_t rx_channel, int8_t rssi, uint32_t now_ms);
+
+// Entrega os alertas ainda não reportados (O(1) quando não há nenhum pendente)
+void beacon_tracker_poll(beacon_tracker_alert_cb_t cb, void *ctx);
+
+// Tabela das entradas vivas, com as suspeitas marcadas
+void beacon_tracker_log(const char *tag, uint32_t now_ms);
+
+const char *beacon_tracker_alert_name(uint8_t alert);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,253 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "chan_monitor.h"
+#include "metrics.h"
+#include "wifi_sniffer.h"
+
+static const char *TAG = "CHAN_MONITOR";
+
+// Contadores do callback promíscuo (única escrita: task do Wi-Fi) e do escalonador
+typedef struct {
+    volatile uint32_t mgmt;
+    volatile uint32_t beacons;
+    volatile uint32_t probes;
+    volatile uint32_t auth;
+    volatile uint32_t deauth;
+    volatile uint32_t disassoc;
+    volatile uint32_t suspicious;   // deauth + disassoc + auth
+    uint32_t visits;
+    uint32_t dwell_ms;
+    uint32_t score;                 // quadros suspeitos com decaimento de 1/2 por visita
+    uint32_t missed_estimate;
+} chan_stats_t;
+
+static chan_monitor_config_t s_config;
+static chan_stats_t s_stats[CHAN_MONITOR_MAX_CHANNEL + 1];
+static volatile uint8_t s_current = 0;     // canal sintonizado (0 = em troca)
+static QueueHandle_t s_queue = NULL;
+
+static metric_t *m_hops;
+static metric_t *m_hop_time_us;
+static metric_t *m_missed_estimate;
+static metric_t *m_offchannel;
+static metric_t *m_events_dropped;
+
+static inline void stat_inc(volatile uint32_t *counter)
+{
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+static void chan_monitor_rx_cb(const wifi_promiscuous_pkt_t *pkt, wifi_promiscuous_pkt_type_t type, void *ctx)
+{
+    /*
+    @brief Consumidor do wifi_sniffer: contagem por canal e enfileiramento de eventos.
+    @note Roda na task do Wi-Fi: só o cabeçalho é lido, sem laços e sem bloqueio
+    (fila cheia descarta o evento e conta em chan_events_dropped_total).
+    */
+    uint8_t channel = pkt->rx_ctrl.channel;
+    if (channel == 0 || channel > CHAN_MONITOR_MAX_CHANNEL) {
+        return;
+    }
+    if (channel != s_current) {
+        // Entregue durante a troca de canal (já estava no buffer do driver)
+        metric_inc(m_offchannel);
+    }
+
+    ids_dot11_hdr_t hdr;
+    if (type != WIFI_PKT_MGMT || !ids_dot11_parse(pkt->payload, pkt->rx_ctrl.sig_len, &hdr)) {
+        return;
+    }
+
+    chan_stats_t *stats = &s_stats[channel];
+    stat_inc(&stats->mgmt);
+    switch (hdr.subtype) {
+    case IDS_DOT11_MGMT_BEACON:
+        stat_inc(&stats->beacons);
+        break;
+    case IDS_DOT11_MGMT_PROBE_REQ:
+        stat_inc(&stats->probes);
+        break;
+    case IDS_DOT11_MGMT_AUTH:
+        stat_inc(&stats->auth);
+        stat_inc(&stats->suspicious);
+        break;
+    case IDS_DOT11_MGMT_DEAUTH:
+        stat_inc(&stats->deauth);
+        stat_inc(&stats->suspicious);
+        break;
+    case IDS_DOT11_MGMT_DISASSOC:
+        stat_inc(&stats->disassoc);
+        stat_inc(&stats->suspicious);
+        break;
+    default:
+        break;
+    }
+
+    const uint8_t *station = NULL;
+    ids_dot11_event_t event = ids_dot11_event(&hdr, &station);
+    if (event == IDS_DOT11_EVENT_NONE || s_config.on_event == NULL) {
+        return;
+    }
+
+    chan_monitor_event_t record = {
+        .channel = channel,
+        .rssi = pkt->rx_ctrl.rssi,
+        .event = event,
+    };
+    memcpy(record.mac, station, 6);
+    memcpy(record.bssid, ids_dot11_bssid(&hdr), 6);
+    if (xQueueSend(s_queue, &record, 0) != pdTRUE) {
+        metric_inc(m_events_dropped);
+    }
+}
+
+static uint32_t chan_dwell_ms(const chan_stats_t *stats)
+{
+    // Permanência proporcional à atividade suspeita recente, limitada a max_dwell_ms
+    uint32_t extra = stats->score * s_config.boost_ms;
+    uint32_t limit = s_config.max_dwell_ms - s_config.base_dwell_ms;
+    return s_config.base_dwell_ms + (extra < limit ? extra : limit);
+}
+
+static uint8_t chan_next(uint8_t channel)
+{
+    for (int i = 0; i < CHAN_MONITOR_MAX_CHANNEL; i++) {
+        channel = channel >= CHAN_MONITOR_MAX_CHANNEL ? 1 : channel + 1;
+        if (s_config.channel_mask & (1u << channel)) {
+            return channel;
+        }
+    }
+    return channel;
+}
+
+static void chan_monitor_dwell(int64_t deadline_us)
+{
+    // Entrega os eventos enfileirados até o fim da permanência no canal
+    chan_monitor_event_t event;
+    int64_t now;
+
+    while ((now = esp_timer_get_time()) < deadline_us) {
+        TickType_t wait = pdMS_TO_TICKS((deadline_us - now + 999) / 1000);
+        if (xQueueReceive(s_queue, &event, wait ? wait : 1) == pdTRUE && s_config.on_event) {
+            s_config.on_event(&event, s_config.ctx);
+        }
+    }
+}
+
+static void chan_monitor_task(void *arg)
+{
+    /*
+    @brief Escalonador de saltos.
+    @note Cada troca de canal deixa o rádio surdo por alguns ms. As perdas são
+    estimadas pela taxa média de quadros do canal (quadros por ms de permanência)
+    multiplicada pelo tempo da troca, e acumuladas em chan_frames_missed_estimate_total.
+    */
+    uint8_t channel = chan_next(0);
+
+    while (1) {
+        chan_stats_t *stats = &s_stats[channel];
+
+        int64_t switch_start = esp_timer_get_time();
+        s_current = 0;
+        esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+        int64_t tuned = esp_timer_get_time();
+        s_current = channel;
+
+        uint32_t switch_us = (uint32_t)(tuned - switch_start);
+        metric_inc(m_hops);
+        metric_add(m_hop_time_us, switch_us);
+        if (stats->dwell_ms > 0) {
+            uint32_t missed = (uint32_t)(((uint64_t)stats->mgmt * switch_us) / ((uint64_t)stats->dwell_ms * 1000));
+            stats->missed_estimate += missed;
+            metric_add(m_missed_estimate, missed);
+        }
+
+        uint32_t suspicious_before = stats->suspicious;
+        chan_monitor_dwell(tuned + (int64_t)chan_dwell_ms(stats) * 1000);
+
+        uint32_t visit_suspicious = stats->suspicious - suspicious_before;
+        uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - tuned) / 1000);
+        stats->visits++;
+        stats->dwell_ms += elapsed_ms;
+        stats->score = stats->score / 2 + visit_suspicious;
+
+        if (s_config.alert_threshold && visit_suspicious >= s_config.alert_threshold) {
+            ESP_LOGW(TAG, "Atividade suspeita no canal %d: %lu quadros deauth/disassoc/auth em %lu ms",
+                     channel, (unsigned long)visit_suspicious, (unsigned long)elapsed_ms);
+        }
+
+        channel = chan_next(channel);
+    }
+}
+
+esp_err_t chan_monitor_init(const chan_monitor_config_t *config)
+{
+    /*
+    @brief Valida a configuração, cria a fila de eventos e registra o consumidor.
+    */
+    if ((config->channel_mask & (((1u << (CHAN_MONITOR_MAX_CHANNEL + 1)) - 1) & ~1u)) == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (config->max_dwell_ms < config->base_dwell_ms || config->base_dwell_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_config = *config;
+    memset(s_stats, 0, sizeof(s_stats));
+
+    s_queue = xQueueCreate(CHAN_MONITOR_QUEUE_LEN, sizeof(chan_monitor_event_t));
+    if (s_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    m_hops = metrics_counter("chan_hops_total", "Trocas de canal do monitor");
+    m_hop_time_us = metrics_counter("chan_hop_time_us_total", "Tempo gasto em trocas de canal (us)");
+    m_missed_estimate = metrics_counter("chan_frames_missed_estimate_total", "Quadros estimados perdidos nas trocas");
+    m_offchannel = metrics_counter("chan_offchannel_frames_total", "Quadros entregues durante uma troca");
+    m_events_dropped = metrics_counter("chan_events_dropped_total", "Eventos descartados com a fila cheia");
+
+    return wifi_sniffer_register(chan_monitor_rx_cb, NULL);
+}
+
+esp_err_t chan_monitor_start(int core, int priority, int stack_size)
+{
+    if (s_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xTaskCreatePinnedToCore(chan_monitor_task, "chan_monitor", stack_size, NULL,
+                                priority, NULL, core) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Monitor multicanal ativo (mascara 0x%04x, dwell %u-%u ms)",
+             s_config.channel_mask, s_config.base_dwell_ms, s_config.max_dwell_ms);
+    return ESP_OK;
+}
+
+void chan_monitor_log(const char *tag)
+{
+    /*
+    @brief Uma linha por canal monitorado.
+    @note Leituras relaxadas: os valores podem estar uma visita atrasados.
+    */
+    ESP_LOGI(tag, "=== MONITOR DE CANAIS ===");
+    ESP_LOGI(tag, "  Canal Visitas Dwell(ms)   Mgmt Beacon  Probe   Auth Deauth Disass Pont. Perd.(est)");
+    for (int ch = 1; ch <= CHAN_MONITOR_MAX_CHANNEL; ch++) {
+        if (!(s_config.channel_mask & (1u << ch))) {
+            continue;
+        }
+        const chan_stats_t *stats = &s_stats[ch];
+        ESP_LOGI(tag, "  %5d %7lu %9lu %6lu %6lu %6lu %6lu %6lu %6lu %5lu %10lu", ch,
+                 (unsigned long)stats->visits, (unsigned long)stats->dwell_ms,
+                 (unsigned long)stats->mgmt, (unsigned long)stats->beacons, (unsigned long)stats->probes,
+                 (unsigned long)stats->auth, (unsigned long)stats->deauth, (unsigned long)stats->disassoc,
+                 (unsigned long)stats->score, (unsigned long)stats->missed_estimate);
+    }
+    ESP_LOGI(tag, "  Trocas: %ld, tempo em troca: %ld us, eventos descartados: %ld",
+             (long)metric_value(m_hops), (long)metric_value(m_hop_time_us), (long)metric_value(m_events_dropped));
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "ids_dot11.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Monitor multicanal: salta entre os canais de 2,4 GHz com um tempo de
+ * permanência (dwell) por canal que cresce com a atividade suspeita recente
+ * (deauth, disassoc e auth), e agrega estatísticas de gerenciamento por canal.
+ *
+ * O callback promíscuo faz só trabalho O(1): conta o quadro no canal em que
+ * chegou e, se o quadro vira evento do IDS (ids_dot11_event), enfileira um
+ * registro compacto. A task do monitor consome a fila entre os saltos e entrega
+ * os eventos à aplicação (on_event), fora da task do Wi-Fi.
+ *
+ * Trocar de canal exige que nenhuma estação esteja associada a um softAP da
+ * própria placa (restrição de esp_wifi_set_channel): o monitor é para uma
+ * placa sensora, com a interface em STA sem conexão.
+ */
+
+#define CHAN_MONITOR_MAX_CHANNEL 14
+#define CHAN_MONITOR_ALL_CHANNELS 0x3FFEu      // canais 1 a 13
+#define CHAN_MONITOR_QUEUE_LEN 32
+
+typedef struct {
+    uint8_t mac[6];             // estação afetada
+    uint8_t bssid[6];
+    uint8_t channel;
+    int8_t rssi;
+    ids_dot11_event_t event;
+} chan_monitor_event_t;
+
+typedef void (*chan_monitor_event_cb_t)(const chan_monitor_event_t *event, void *ctx);
+
+typedef struct {
+    uint16_t channel_mask;      // bit n = canal n
+    uint16_t base_dwell_ms;     // permanência sem atividade suspeita
+    uint16_t max_dwell_ms;      // teto da permanência
+    uint16_t boost_ms;          // permanência extra por quadro suspeito (pontuação com decaimento)
+    uint16_t alert_threshold;   // quadros suspeitos numa visita que geram alerta no log
+    chan_monitor_event_cb_t on_event;   // na task do monitor (opcional)
+    void *ctx;
+} chan_monitor_config_t;
+
+// Registra o consumidor no wifi_sniffer (antes de wifi_sniffer_start)
+esp_err_t chan_monitor_init(const chan_monitor_config_t *config);
+
+// Cria a task de saltos (depois de wifi_sniffer_start, com a interface iniciada)
+esp_err_t chan_monitor_start(int core, int priority, int stack_size);
+
+// Tabela por canal: permanência, quadros por tipo, pontuação e perdas estimadas
+void chan_monitor_log(const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
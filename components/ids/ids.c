@@ -0,0 +1,689 @@
+#include <string.h>
+#include "ids.h"
+#include "mem_pool.h"
+#include "metrics.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#define IDS_LOGD(fmt, ...) ESP_LOGD(TAG, fmt, ##__VA_ARGS__)
+#else
+// Build de host (tools/ids_host): o analisador imprime os próprios resultados
+#define IDS_LOGD(fmt, ...) do { } while (0)
+#endif
+
+/*
+ * Caminho quente (um evento por pacote ou quadro durante um flood): as buscas
+ * e os detectores ficam na IRAM, fora do cache da flash que o driver Wi-Fi
+ * disputa. As tabelas são estáticas e já ficam na DRAM. IDS_HOT_IRAM=0 deixa
+ * tudo na flash, para comparar os ciclos (histograma ids_event_cycles).
+ */
+#ifndef IDS_HOT_IRAM
+#define IDS_HOT_IRAM 1
+#endif
+#if defined(ESP_PLATFORM) && IDS_HOT_IRAM
+#include "esp_attr.h"
+#define IDS_HOT IRAM_ATTR
+#else
+#define IDS_HOT
+#endif
+
+#if IDS_BLOOM
+// Contadores do filtro por shard: potência de 2 >= IDS_BLACKLIST_CAPACITY * IDS_BLOOM_COUNTERS_PER_ENTRY
+#define IDS_BLOOM_WANTED ((uint32_t)IDS_BLACKLIST_CAPACITY * IDS_BLOOM_COUNTERS_PER_ENTRY - 1)
+#define IDS_BLOOM_SMEAR1 (IDS_BLOOM_WANTED | (IDS_BLOOM_WANTED >> 1))
+#define IDS_BLOOM_SMEAR2 (IDS_BLOOM_SMEAR1 | (IDS_BLOOM_SMEAR1 >> 2))
+#define IDS_BLOOM_SMEAR4 (IDS_BLOOM_SMEAR2 | (IDS_BLOOM_SMEAR2 >> 4))
+#define IDS_BLOOM_SMEAR8 (IDS_BLOOM_SMEAR4 | (IDS_BLOOM_SMEAR4 >> 8))
+#define IDS_BLOOM_COUNTERS ((IDS_BLOOM_SMEAR8 | (IDS_BLOOM_SMEAR8 >> 16)) + 1)
+#define IDS_BLOOM_MASK (IDS_BLOOM_COUNTERS - 1)
+
+_Static_assert(IDS_BLOOM_HASHES >= 1 && IDS_BLOOM_HASHES <= 4, "IDS_BLOOM_HASHES deve estar entre 1 e 4");
+#endif
+
+typedef struct ids_shard ids_shard_t;
+
+// Dados frios das entradas (pools); as chaves ficam nas tabelas do shard, pelo índice do bloco
+typedef struct {
+    ids_shard_t *shard;
+    tw_timer_t expiry_timer;
+    time_us_t blocked_until;
+    uint8_t attack_type; // 1=deauth, 2=auth, 3=packet, 4=connection
+} blacklist_entry_t;
+
+typedef struct {
+    ids_shard_t *shard;
+    tw_timer_t window_timer;
+    time_us_t last_packet_time;
+    uint16_t packet_count;
+    uint16_t suspicion;     // pontuação de conteúdo na janela (soma-se aos pacotes)
+    ids_client_activity_t activity;     // bytes, conexões e erros na janela
+    bool window_open;       // true: janela em curso; false: timer conta ociosidade
+} client_monitor_t;
+
+/*
+ * Estado de um shard: só o dono do shard o acessa. As buscas por MAC varrem só
+ * os arrays de chaves (MAC em 64 bits, 0 = bloco livre), contíguos e sem
+ * ponteiros: 20 clientes cabem em 160 bytes, contra uma lista encadeada com
+ * memcmp de 6 bytes por nó.
+ */
+struct ids_shard {
+    uint64_t blacklist_keys[IDS_BLACKLIST_CAPACITY];
+    uint64_t monitor_keys[IDS_MONITOR_CAPACITY];
+    mem_pool_t *blacklist_pool;
+    mem_pool_t *monitor_pool;
+    timer_wheel_t wheel;
+#if IDS_BLOOM
+    uint8_t bloom[IDS_BLOOM_COUNTERS];
+    // Contados pelo dono sem atômicos e somados às métricas em ids_advance_shard()
+    uint32_t bloom_negatives;
+    uint32_t bloom_false_positives;
+#endif
+};
+
+// Mesmo formato das chaves do filtro de entrada do AP: marcador no bit 48, MAC nos 48 baixos
+#define IDS_KEY_MAC (1ULL << 48)
+
+static const char *TAG __attribute__((unused)) = "IDS";
+
+static ids_config_t s_config;
+
+// Entradas das tabelas vêm de pools estáticos, um par por shard (nomes com o índice)
+#define IDS_SHARD_POOLS(n)                                                                        \
+    MEM_POOL_DEFINE(blacklist_pool_##n, blacklist_entry_t, IDS_BLACKLIST_CAPACITY, "ids_blacklist_" #n); \
+    MEM_POOL_DEFINE(monitor_pool_##n, client_monitor_t, IDS_MONITOR_CAPACITY, "ids_monitor_" #n)
+
+IDS_SHARD_POOLS(0);
+#if IDS_SHARDS > 1
+IDS_SHARD_POOLS(1);
+#endif
+#if IDS_SHARDS > 2
+IDS_SHARD_POOLS(2);
+#endif
+#if IDS_SHARDS > 3
+IDS_SHARD_POOLS(3);
+#endif
+
+static ids_shard_t s_shards[IDS_SHARDS] = {
+    {.blacklist_pool = &blacklist_pool_0, .monitor_pool = &monitor_pool_0},
+#if IDS_SHARDS > 1
+    {.blacklist_pool = &blacklist_pool_1, .monitor_pool = &monitor_pool_1},
+#endif
+#if IDS_SHARDS > 2
+    {.blacklist_pool = &blacklist_pool_2, .monitor_pool = &monitor_pool_2},
+#endif
+#if IDS_SHARDS > 3
+    {.blacklist_pool = &blacklist_pool_3, .monitor_pool = &monitor_pool_3},
+#endif
+};
+
+/*
+ * Janelas globais de taxa (desconexões e autenticações de todos os shards).
+ * Cada uma é uma palavra atômica: 16 bits do número da janela (now_us /
+ * rate_window_ms) e 16 bits da contagem. O primeiro evento de uma janela nova
+ * zera a contagem, então nenhum shard precisa de timer para o rollover. Ao lado,
+ * os 32 bits baixos do instante do último evento (intervalos de até ~71 min).
+ */
+static uint32_t disconnections_window = 0;
+static uint32_t auth_window = 0;
+static uint32_t disconnections_last_us = 0;
+static uint32_t auth_last_us = 0;
+
+static metric_t *m_deauth_floods;
+static metric_t *m_auth_floods;
+static metric_t *m_packet_floods;
+static metric_t *m_connection_floods;
+static metric_t *m_client_bytes_in;
+static metric_t *m_client_bytes_out;
+static metric_t *m_client_connections;
+static metric_t *m_client_empty_connections;
+static metric_t *m_client_recv_errors;
+static metric_t *m_blacklist_additions;
+static metric_t *m_blacklist_active;
+static metric_t *m_monitored_clients;
+#if IDS_BLOOM
+static metric_t *m_bloom_negatives;
+static metric_t *m_bloom_false_positives;
+#endif
+
+static inline uint64_t ids_mac_key(const uint8_t *mac)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) {
+        key = (key << 8) | mac[i];
+    }
+    return IDS_KEY_MAC | key;
+}
+
+static void ids_key_mac(uint64_t key, uint8_t *mac)
+{
+    for (int i = 5; i >= 0; i--) {
+        mac[i] = (uint8_t)key;
+        key >>= 8;
+    }
+}
+
+static IDS_HOT int ids_key_find(const uint64_t *keys, int capacity, uint64_t key)
+{
+    // Capacidade constante em cada chamada: o compilador desenrola a varredura
+    for (int i = 0; i < capacity; i++) {
+        if (keys[i] == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#if IDS_BLOOM
+static IDS_HOT uint32_t bloom_hash(uint64_t key)
+{
+    // Finalizador do MurmurHash3 sobre a chave dobrada em 32 bits (multiplicação de 32 bits no ESP32)
+    uint32_t h = (uint32_t)key ^ ((uint32_t)(key >> 32) * 0x9e3779b1u);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/*
+ * Hash duplo: a sonda i lê o contador (h + i * passo), com passo ímpar tirado
+ * dos bits altos, então as IDS_BLOOM_HASHES sondas caem em contadores distintos.
+ */
+#define BLOOM_FOREACH(h, index)                                                     \
+    for (uint32_t index = (h) & IDS_BLOOM_MASK, step_ = ((h) >> 16) | 1, i_ = 0;    \
+         i_ < IDS_BLOOM_HASHES; i_++, index = (index + step_) & IDS_BLOOM_MASK)
+
+static IDS_HOT bool bloom_maybe(const ids_shard_t *shard, uint64_t key)
+{
+    uint32_t h = bloom_hash(key);
+    BLOOM_FOREACH(h, index) {
+        if (shard->bloom[index] == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void bloom_add(ids_shard_t *shard, uint64_t key)
+{
+    uint32_t h = bloom_hash(key);
+    BLOOM_FOREACH(h, index) {
+        if (shard->bloom[index] < UINT8_MAX) {
+            shard->bloom[index]++;
+        }
+    }
+}
+
+static void bloom_remove(ids_shard_t *shard, uint64_t key)
+{
+    // Contador saturado fica: não se sabe mais quantas chaves passam por ele
+    uint32_t h = bloom_hash(key);
+    BLOOM_FOREACH(h, index) {
+        if (shard->bloom[index] < UINT8_MAX) {
+            shard->bloom[index]--;
+        }
+    }
+}
+#endif
+
+static void blacklist_expired_cb(tw_timer_t *timer, void *arg)
+{
+    /*
+    @brief Callback do timer wheel: libera a entrada da blacklist assim que o bloqueio vence.
+    @note Executa dentro de ids_advance_shard(), no dono do shard.
+    */
+    blacklist_entry_t *entry = (blacklist_entry_t *)arg;
+    ids_shard_t *shard = entry->shard;
+    size_t index = mem_pool_index(shard->blacklist_pool, entry);
+
+    if (s_config.on_unblock) {
+        uint8_t mac[6];
+        ids_key_mac(shard->blacklist_keys[index], mac);
+        s_config.on_unblock(mac, s_config.ctx);
+    }
+#if IDS_BLOOM
+    bloom_remove(shard, shard->blacklist_keys[index]);
+#endif
+    shard->blacklist_keys[index] = 0;
+    mem_pool_free(shard->blacklist_pool, entry);
+    metric_gauge_add(m_blacklist_active, -1);
+}
+
+static void client_window_cb(tw_timer_t *timer, void *arg)
+{
+    /*
+    @brief Callback do timer wheel para a janela de taxa de um cliente.
+    @note Ao fim da janela o contador é zerado e o mesmo timer passa a medir
+    ociosidade; se nenhum pacote chegar em monitor_idle_timeout_ms a entrada é
+    liberada (clientes identificados por IP nunca geram evento de desconexão).
+    */
+    client_monitor_t *monitor = (client_monitor_t *)arg;
+    ids_shard_t *shard = monitor->shard;
+
+    if (monitor->window_open) {
+        monitor->packet_count = 0;
+        monitor->suspicion = 0;
+        memset(&monitor->activity, 0, sizeof(monitor->activity));
+        monitor->window_open = false;
+        timer_wheel_schedule(&shard->wheel, &monitor->window_timer,
+                             IDS_MS_TO_TICKS(s_config.monitor_idle_timeout_ms));
+        return;
+    }
+
+    size_t index = mem_pool_index(shard->monitor_pool, monitor);
+    IDS_LOGD("Cliente ocioso removido do monitor: %012llx",
+             (unsigned long long)(shard->monitor_keys[index] & ~IDS_KEY_MAC));
+    shard->monitor_keys[index] = 0;
+    mem_pool_free(shard->monitor_pool, monitor);
+    metric_gauge_add(m_monitored_clients, -1);
+}
+
+static IDS_HOT uint32_t interval_since(uint32_t *last_us, time_us_t now_us)
+{
+    // Troca atômica: o intervalo é medido contra o evento anterior de qualquer shard
+    uint32_t prev = __atomic_exchange_n(last_us, (uint32_t)now_us, __ATOMIC_RELAXED);
+    return (uint32_t)now_us - prev;
+}
+
+static IDS_HOT uint16_t global_window_hit(uint32_t *window, time_us_t now_us)
+{
+    /*
+    @brief Conta um evento na janela global corrente e devolve o total da janela.
+    @note CAS sem lock: shards em núcleos diferentes podem contar ao mesmo tempo.
+    */
+    uint32_t epoch = (uint32_t)(now_us / TIME_MS_TO_US(s_config.rate_window_ms)) & 0xFFFF;
+    uint32_t old = __atomic_load_n(window, __ATOMIC_RELAXED);
+    uint32_t next;
+    do {
+        uint32_t count = (old >> 16) == epoch ? (old & 0xFFFF) : 0;
+        if (count < 0xFFFF) {
+            count++;
+        }
+        next = (epoch << 16) | count;
+    } while (!__atomic_compare_exchange_n(window, &old, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return (uint16_t)(next & 0xFFFF);
+}
+
+static IDS_HOT blacklist_entry_t *blacklist_find(ids_shard_t *shard, uint64_t key)
+{
+    // Blacklist vazia (o caso comum) não toca nas chaves
+    if (mem_pool_in_use(shard->blacklist_pool) == 0) {
+        return NULL;
+    }
+#if IDS_BLOOM
+    // MAC não bloqueado: respondido pelo filtro sem varrer a tabela
+    if (!bloom_maybe(shard, key)) {
+        shard->bloom_negatives++;
+        return NULL;
+    }
+#endif
+    int index = ids_key_find(shard->blacklist_keys, IDS_BLACKLIST_CAPACITY, key);
+    if (index < 0) {
+#if IDS_BLOOM
+        shard->bloom_false_positives++;
+#endif
+        return NULL;
+    }
+    return mem_pool_at(shard->blacklist_pool, index);
+}
+
+static IDS_HOT client_monitor_t *monitor_find(ids_shard_t *shard, uint64_t key)
+{
+    int index = ids_key_find(shard->monitor_keys, IDS_MONITOR_CAPACITY, key);
+    return index < 0 ? NULL : mem_pool_at(shard->monitor_pool, index);
+}
+
+void ids_init(const ids_config_t *config, time_us_t now_us)
+{
+    /*
+    @brief Inicializa as tabelas e o timer wheel de cada shard e as métricas.
+    @param config Limites e ganchos (copiado)
+    @param now_us Instante inicial do relógio do IDS
+    */
+    s_config = *config;
+
+    m_deauth_floods = metrics_counter("ids_deauth_floods_total", "Deauth floods detectados");
+    m_auth_floods = metrics_counter("ids_auth_floods_total", "Auth floods detectados");
+    m_packet_floods = metrics_counter("ids_packet_floods_total", "Packet floods detectados");
+    m_connection_floods = metrics_counter("ids_connection_floods_total", "Connection floods detectados");
+    m_client_bytes_in = metrics_counter("ids_client_bytes_in_total", "Bytes recebidos de clientes monitorados");
+    m_client_bytes_out = metrics_counter("ids_client_bytes_out_total", "Bytes enviados a clientes monitorados");
+    m_client_connections = metrics_counter("ids_client_connections_total", "Conexoes abertas por clientes monitorados");
+    m_client_empty_connections = metrics_counter("ids_client_empty_connections_total",
+                                                 "Conexoes de clientes fechadas sem dados");
+    m_client_recv_errors = metrics_counter("ids_client_recv_errors_total", "Erros de recv em conexoes de clientes");
+    m_blacklist_additions = metrics_counter("ids_blacklist_additions_total", "MACs adicionados a blacklist");
+    m_blacklist_active = metrics_gauge("ids_blacklist_active", "Entradas ativas na blacklist");
+    m_monitored_clients = metrics_gauge("ids_monitored_clients", "Clientes no monitor de pacotes");
+#if IDS_BLOOM
+    m_bloom_negatives = metrics_counter("ids_bloom_negatives_total", "Buscas na blacklist respondidas pelo filtro de Bloom");
+    m_bloom_false_positives = metrics_counter("ids_bloom_false_positives_total",
+                                              "Buscas que passaram pelo filtro sem o MAC estar na blacklist");
+#endif
+
+    for (int i = 0; i < IDS_SHARDS; i++) {
+        ids_shard_t *shard = &s_shards[i];
+        mem_pool_init(shard->blacklist_pool);
+        mem_pool_init(shard->monitor_pool);
+        memset(shard->blacklist_keys, 0, sizeof(shard->blacklist_keys));
+        memset(shard->monitor_keys, 0, sizeof(shard->monitor_keys));
+#if IDS_BLOOM
+        memset(shard->bloom, 0, sizeof(shard->bloom));
+        shard->bloom_negatives = 0;
+        shard->bloom_false_positives = 0;
+#endif
+        timer_wheel_init(&shard->wheel, (uint32_t)(now_us / TIME_MS_TO_US(IDS_TICK_MS)));
+    }
+    __atomic_store_n(&disconnections_window, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&auth_window, 0, __ATOMIC_RELAXED);
+}
+
+uint32_t ids_advance_shard(uint8_t shard, time_us_t now_us)
+{
+    ids_shard_t *s = &s_shards[shard];
+#if IDS_BLOOM
+    // Contadores do filtro vão para as métricas uma vez por tick, não por busca
+    metric_add(m_bloom_negatives, s->bloom_negatives);
+    metric_add(m_bloom_false_positives, s->bloom_false_positives);
+    s->bloom_negatives = 0;
+    s->bloom_false_positives = 0;
+#endif
+    return timer_wheel_advance(&s->wheel, (uint32_t)(now_us / TIME_MS_TO_US(IDS_TICK_MS)));
+}
+
+uint32_t ids_advance(time_us_t now_us)
+{
+    uint32_t fired = 0;
+    for (uint8_t i = 0; i < IDS_SHARDS; i++) {
+        fired += ids_advance_shard(i, now_us);
+    }
+    return fired;
+}
+
+timer_wheel_t *ids_timer_wheel(uint8_t shard)
+{
+    return &s_shards[shard].wheel;
+}
+
+IDS_HOT bool ids_is_blacklisted(const uint8_t *mac)
+{
+    /*
+    @brief Verifica se um MAC address está na blacklist.
+    @note A expiração é feita pelo timer wheel (blacklist_expired_cb), então
+    esta função apenas consulta a tabela do shard do MAC.
+    */
+    return blacklist_find(&s_shards[ids_shard_of(mac)], ids_mac_key(mac)) != NULL;
+}
+
+ids_result_t ids_blacklist_add(const uint8_t *mac, ids_attack_t attack, time_us_t now_us)
+{
+    /*
+    @brief Adiciona um MAC address à blacklist com o tipo de ataque e tempo de bloqueio.
+    @param mac MAC address a ser adicionado
+    @param attack Tipo de ataque detectado
+    @note O timer de expiração da entrada é (re)agendado no timer wheel.
+    @note Com o pool esgotado o MAC não é bloqueado (contado em mempool_ids_blacklist_exhausted_total).
+    */
+    ids_result_t result = {
+        .verdict = IDS_VERDICT_ATTACK,
+        .attack = attack,
+    };
+    ids_shard_t *shard = &s_shards[ids_shard_of(mac)];
+    uint64_t key = ids_mac_key(mac);
+
+    blacklist_entry_t *entry = blacklist_find(shard, key);
+    if (entry != NULL) {
+        // Atualizar tempo e tipo de ataque
+        entry->blocked_until = now_us + TIME_MS_TO_US(s_config.blacklist_duration_ms);
+        entry->attack_type = attack;
+        timer_wheel_schedule(&shard->wheel, &entry->expiry_timer, IDS_MS_TO_TICKS(s_config.blacklist_duration_ms));
+        result.refreshed = true;
+        return result;
+    }
+
+    entry = mem_pool_alloc(shard->blacklist_pool);
+    if (entry == NULL) {
+        result.blacklist_full = true;
+        return result;
+    }
+
+    entry->shard = shard;
+    shard->blacklist_keys[mem_pool_index(shard->blacklist_pool, entry)] = key;
+#if IDS_BLOOM
+    bloom_add(shard, key);
+#endif
+    entry->blocked_until = now_us + TIME_MS_TO_US(s_config.blacklist_duration_ms);
+    entry->attack_type = attack;
+    tw_timer_init(&entry->expiry_timer, blacklist_expired_cb, entry);
+    timer_wheel_schedule(&shard->wheel, &entry->expiry_timer, IDS_MS_TO_TICKS(s_config.blacklist_duration_ms));
+    metric_inc(m_blacklist_additions);
+    metric_gauge_add(m_blacklist_active, 1);
+
+    if (s_config.on_block) {
+        s_config.on_block(mac, attack, s_config.ctx);
+    }
+    return result;
+}
+
+static ids_result_t detector_block(const uint8_t *mac, ids_attack_t attack,
+                                   const ids_result_t *observed, time_us_t now_us)
+{
+    // Bloqueia o MAC mantendo a contagem e o intervalo medidos pelo detector
+    ids_result_t result = ids_blacklist_add(mac, attack, now_us);
+    result.count = observed->count;
+    result.suspicion = observed->suspicion;
+    result.activity = observed->activity;
+    result.interval_us = observed->interval_us;
+    return result;
+}
+
+static void monitor_remove(ids_shard_t *shard, const uint8_t *mac)
+{
+    int index = ids_key_find(shard->monitor_keys, IDS_MONITOR_CAPACITY, ids_mac_key(mac));
+    if (index >= 0) {
+        client_monitor_t *monitor = mem_pool_at(shard->monitor_pool, index);
+        timer_wheel_cancel(&shard->wheel, &monitor->window_timer);
+        shard->monitor_keys[index] = 0;
+        mem_pool_free(shard->monitor_pool, monitor);
+        metric_gauge_add(m_monitored_clients, -1);
+        IDS_LOGD("Cliente removido do monitor: %02x:%02x:%02x:%02x:%02x:%02x",
+                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    }
+}
+
+IDS_HOT ids_result_t ids_station_connected(const uint8_t *mac, time_us_t now_us)
+{
+    /*
+    @brief Estação associada: recusa MACs bloqueados e detecta auth flood.
+    @note Utiliza um contador global (todos os shards) de tentativas de
+    autenticação por janela; acima de max_auth_attempts a estação é bloqueada.
+    */
+    ids_result_t result = {0};
+
+    if (blacklist_find(&s_shards[ids_shard_of(mac)], ids_mac_key(mac)) != NULL) {
+        result.verdict = IDS_VERDICT_BLOCKED;
+        return result;
+    }
+
+    result.count = global_window_hit(&auth_window, now_us);
+    result.interval_us = interval_since(&auth_last_us, now_us);
+    if (result.count > s_config.max_auth_attempts) {
+        metric_inc(m_auth_floods);
+        result = detector_block(mac, IDS_ATTACK_AUTH_FLOOD, &result, now_us);
+    }
+    return result;
+}
+
+IDS_HOT ids_result_t ids_station_disconnected(const uint8_t *mac, time_us_t now_us)
+{
+    /*
+    @brief Estação desconectada: detecta deauth flood e tira o cliente do monitor.
+    @note Utiliza um contador global (todos os shards) de desconexões por
+    janela; acima de max_disconnections a estação é bloqueada.
+    */
+    ids_result_t result = {0};
+
+    result.count = global_window_hit(&disconnections_window, now_us);
+    result.interval_us = interval_since(&disconnections_last_us, now_us);
+    if (result.count > s_config.max_disconnections) {
+        metric_inc(m_deauth_floods);
+        result = detector_block(mac, IDS_ATTACK_DEAUTH_FLOOD, &result, now_us);
+    }
+
+    monitor_remove(&s_shards[ids_shard_of(mac)], mac);
+    return result;
+}
+
+static void client_window_open(client_monitor_t *monitor)
+{
+    monitor->window_open = true;
+    monitor->packet_count = 0;
+    monitor->suspicion = 0;
+    memset(&monitor->activity, 0, sizeof(monitor->activity));
+    timer_wheel_schedule(&monitor->shard->wheel, &monitor->window_timer, IDS_MS_TO_TICKS(s_config.rate_window_ms));
+}
+
+static IDS_HOT client_monitor_t *monitor_acquire(ids_shard_t *shard, const uint8_t *mac, time_us_t now_us)
+{
+    /*
+    @brief Entrada do cliente no monitor, criada no primeiro evento; reabre a janela se fechada.
+    @return NULL com o pool esgotado (cliente sem monitoramento até uma entrada vagar)
+    */
+    uint64_t key = ids_mac_key(mac);
+    client_monitor_t *monitor = monitor_find(shard, key);
+    if (monitor != NULL) {
+        if (!monitor->window_open) {
+            client_window_open(monitor);
+        }
+        return monitor;
+    }
+
+    monitor = mem_pool_alloc(shard->monitor_pool);
+    if (monitor == NULL) {
+        return NULL;
+    }
+    monitor->shard = shard;
+    shard->monitor_keys[mem_pool_index(shard->monitor_pool, monitor)] = key;
+    monitor->last_packet_time = now_us;
+    tw_timer_init(&monitor->window_timer, client_window_cb, monitor);
+    client_window_open(monitor);
+    metric_gauge_add(m_monitored_clients, 1);
+    IDS_LOGD("Novo cliente adicionado ao monitor: %02x:%02x:%02x:%02x:%02x:%02x",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return monitor;
+}
+
+IDS_HOT ids_result_t ids_client_packet(const uint8_t *mac, uint8_t suspicion, time_us_t now_us)
+{
+    /*
+    @brief Pacote de um cliente: detecta packet flood.
+    @param suspicion Pontuação do conteúdo dada pela aplicação, somada à contagem
+    @note Utiliza um contador por cliente; a janela de cada cliente é aberta no
+    primeiro pacote e fechada pelo timer wheel. O limite vale para pacotes mais
+    pontuação: conteúdo suspeito chega a max_packets_per_client com menos pacotes.
+    @note Pool esgotado: o cliente fica sem monitoramento até uma entrada vagar.
+    */
+    ids_result_t result = {0};
+    client_monitor_t *monitor = monitor_acquire(&s_shards[ids_shard_of(mac)], mac, now_us);
+    if (monitor == NULL) {
+        return result;
+    }
+
+    result.interval_us = (uint32_t)(now_us - monitor->last_packet_time);
+    monitor->last_packet_time = now_us;
+    if (monitor->packet_count < UINT16_MAX) {
+        monitor->packet_count++;
+    }
+    if (suspicion > 0 && monitor->suspicion <= UINT16_MAX - suspicion) {
+        monitor->suspicion += suspicion;
+    }
+    result.count = monitor->packet_count;
+    result.suspicion = monitor->suspicion;
+
+    if ((uint32_t)result.count + result.suspicion > s_config.max_packets_per_client) {
+        metric_inc(m_packet_floods);
+        result = detector_block(mac, IDS_ATTACK_PACKET_FLOOD, &result, now_us);
+    }
+    return result;
+}
+
+static inline uint32_t add_sat32(uint32_t a, uint32_t b)
+{
+    return a > UINT32_MAX - b ? UINT32_MAX : a + b;
+}
+
+static inline uint16_t add_sat16(uint16_t a, uint16_t b)
+{
+    return a > UINT16_MAX - b ? UINT16_MAX : (uint16_t)(a + b);
+}
+
+static inline bool over_limit(uint32_t value, uint32_t limit)
+{
+    return limit != 0 && value > limit;
+}
+
+IDS_HOT ids_result_t ids_client_activity(const uint8_t *mac, const ids_client_activity_t *activity, time_us_t now_us)
+{
+    /*
+    @brief Atividade TCP de um cliente: bytes, conexões, conexões vazias e erros de recv.
+    @param activity Delta desde o último relato (tipicamente uma conexão inteira)
+    @note Soma na mesma janela de ids_client_packet (O(1), saturando) e compara
+    com os limites max_*_per_client configurados; limite 0 fica desligado.
+    Bytes excessivos contam como packet flood (volume), o resto como connection flood.
+    */
+    ids_result_t result = {0};
+    client_monitor_t *monitor = monitor_acquire(&s_shards[ids_shard_of(mac)], mac, now_us);
+
+    metric_add(m_client_bytes_in, activity->bytes_in);
+    metric_add(m_client_bytes_out, activity->bytes_out);
+    metric_add(m_client_connections, activity->connections);
+    metric_add(m_client_empty_connections, activity->empty_connections);
+    metric_add(m_client_recv_errors, activity->recv_errors);
+    if (monitor == NULL) {
+        return result;
+    }
+
+    ids_client_activity_t *window = &monitor->activity;
+    window->bytes_in = add_sat32(window->bytes_in, activity->bytes_in);
+    window->bytes_out = add_sat32(window->bytes_out, activity->bytes_out);
+    window->connections = add_sat16(window->connections, activity->connections);
+    window->empty_connections = add_sat16(window->empty_connections, activity->empty_connections);
+    window->recv_errors = add_sat16(window->recv_errors, activity->recv_errors);
+    result.activity = *window;
+    result.count = window->connections;
+
+    if (over_limit(window->bytes_in, s_config.max_bytes_in_per_client) ||
+        over_limit(window->bytes_out, s_config.max_bytes_out_per_client)) {
+        metric_inc(m_packet_floods);
+        result = detector_block(mac, IDS_ATTACK_PACKET_FLOOD, &result, now_us);
+    } else if (over_limit(window->connections, s_config.max_connections_per_client) ||
+               over_limit(window->empty_connections, s_config.max_empty_connections_per_client) ||
+               over_limit(window->recv_errors, s_config.max_recv_errors_per_client)) {
+        metric_inc(m_connection_floods);
+        result = detector_block(mac, IDS_ATTACK_CONNECTION_FLOOD, &result, now_us);
+    }
+    return result;
+}
+
+void ids_get_stats(ids_stats_t *stats)
+{
+    // Contadores atômicos e ocupação dos pools: nenhuma tabela é varrida (seguro de qualquer task)
+    stats->deauth_floods = (uint32_t)metric_value(m_deauth_floods);
+    stats->auth_floods = (uint32_t)metric_value(m_auth_floods);
+    stats->packet_floods = (uint32_t)metric_value(m_packet_floods);
+    stats->connection_floods = (uint32_t)metric_value(m_connection_floods);
+    stats->blacklist_additions = (uint32_t)metric_value(m_blacklist_additions);
+    stats->blacklist_active = 0;
+    stats->monitored_clients = 0;
+    for (int i = 0; i < IDS_SHARDS; i++) {
+        stats->blacklist_active += mem_pool_in_use(s_shards[i].blacklist_pool);
+        stats->monitored_clients += mem_pool_in_use(s_shards[i].monitor_pool);
+    }
+}
+
+const char *ids_attack_name(ids_attack_t attack)
+{
+    static const char *attack_names[] = {"UNKNOWN", "DEAUTH_FLOOD", "AUTH_FLOOD", "PACKET_FLOOD", "CONNECTION_FLOOD"};
+    return (unsigned)attack < sizeof(attack_names) / sizeof(attack_names[0]) ? attack_names[attack] : "UNKNOWN";
+}
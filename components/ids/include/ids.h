@@ -0,0 +1,169 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "time_base.h"
+#include "timer_wheel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Núcleo de detecção do IDS: limites de taxa, monitor por cliente e blacklist.
+ *
+ * Não depende de Wi-Fi, sockets nem FreeRTOS, então o AP (AP/main/AP.c) e o
+ * analisador offline (tools/ids_host) executam exatamente o mesmo código. O
+ * chamador traduz o que observa em eventos (estação conectou, desconectou,
+ * cliente enviou um pacote) e informa o instante em µs monotônicos (time_base);
+ * as expirações andam pelo timer wheel em ids_advance().
+ *
+ * O estado é dividido em IDS_SHARDS shards pelo hash do MAC (ids_shard_of):
+ * cada shard tem a sua blacklist, o seu monitor de clientes e o seu timer
+ * wheel. As funções não são thread-safe dentro de um shard: todos os eventos
+ * de um shard devem vir do mesmo dono (no AP, a task worker do shard, ver
+ * AP/main/ids_workers.c). Shards diferentes podem rodar em paralelo; o único
+ * estado compartilhado são as janelas globais de desconexão/autenticação e
+ * as métricas, ambos atômicos.
+ */
+
+#ifndef IDS_TICK_MS
+#define IDS_TICK_MS 100
+#endif
+#ifndef IDS_SHARDS
+#define IDS_SHARDS 2                // um por núcleo do ESP32 (máximo 4)
+#endif
+#ifndef IDS_BLACKLIST_CAPACITY
+#define IDS_BLACKLIST_CAPACITY 10   // por shard
+#endif
+#ifndef IDS_MONITOR_CAPACITY
+#define IDS_MONITOR_CAPACITY 20     // por shard: todas as estações podem cair no mesmo (AP_MAX_STA_CONN)
+#endif
+
+/*
+ * Pré-filtro da blacklist: Bloom filter de contadores por shard, consultado
+ * antes da varredura das chaves. Quase toda busca é de um MAC que não está
+ * bloqueado, e o filtro a responde com IDS_BLOOM_HASHES leituras de contador;
+ * só os falsos positivos (e os bloqueados) varrem a tabela. Contadores de 8
+ * bits permitem remover na expiração; um contador saturado não desce mais
+ * (nunca há falso negativo). Com IDS_BLOOM_COUNTERS_PER_ENTRY=16 e 2 hashes a
+ * taxa de falso positivo com a blacklist cheia fica perto de 1,4%.
+ */
+#ifndef IDS_BLOOM
+#define IDS_BLOOM 1
+#endif
+#ifndef IDS_BLOOM_COUNTERS_PER_ENTRY
+#define IDS_BLOOM_COUNTERS_PER_ENTRY 16     // contadores (bytes) por entrada da blacklist, arredondado a potência de 2
+#endif
+#ifndef IDS_BLOOM_HASHES
+#define IDS_BLOOM_HASHES 2
+#endif
+#define IDS_MS_TO_TICKS(ms) (((ms) + IDS_TICK_MS - 1) / IDS_TICK_MS)
+
+_Static_assert(IDS_SHARDS >= 1 && IDS_SHARDS <= 4, "IDS_SHARDS deve estar entre 1 e 4");
+
+typedef enum {
+    IDS_ATTACK_UNKNOWN = 0,
+    IDS_ATTACK_DEAUTH_FLOOD = 1,
+    IDS_ATTACK_AUTH_FLOOD = 2,
+    IDS_ATTACK_PACKET_FLOOD = 3,
+    IDS_ATTACK_CONNECTION_FLOOD = 4,
+} ids_attack_t;
+
+typedef enum {
+    IDS_VERDICT_ALLOW = 0,      // evento normal
+    IDS_VERDICT_BLOCKED,        // MAC já está na blacklist
+    IDS_VERDICT_ATTACK,         // limite excedido agora: MAC (re)colocado na blacklist
+} ids_verdict_t;
+
+// Atividade TCP de um cliente: delta informado pela aplicação e contadores da janela no monitor
+typedef struct {
+    uint32_t bytes_in;
+    uint32_t bytes_out;
+    uint16_t connections;           // conexões abertas, inclusive as recusadas ou que falharam antes do recv
+    uint16_t empty_connections;     // fechadas sem nenhum byte recebido
+    uint16_t recv_errors;
+} ids_client_activity_t;
+
+typedef struct {
+    ids_verdict_t verdict;
+    ids_attack_t attack;        // em IDS_VERDICT_ATTACK
+    uint16_t count;             // eventos na janela corrente do detector
+    uint16_t suspicion;         // packet flood: pontuação de conteúdo somada na janela
+    ids_client_activity_t activity; // ids_client_activity: contadores da janela do cliente
+    uint32_t interval_us;       // desde o evento anterior do mesmo detector (cadência do ataque)
+    bool refreshed;             // ATTACK: MAC já bloqueado, prazo renovado
+    bool blacklist_full;        // ATTACK: sem entrada livre, MAC não bloqueado
+} ids_result_t;
+
+typedef struct {
+    uint16_t max_disconnections;        // por janela global
+    uint16_t max_auth_attempts;         // por janela global
+    uint16_t max_packets_per_client;    // por janela do cliente (pacotes + pontuação de suspeita)
+    uint32_t rate_window_ms;
+    uint32_t blacklist_duration_ms;
+    uint32_t monitor_idle_timeout_ms;
+
+    // Limites por janela do cliente sobre a atividade TCP (ids_client_activity); 0 = sem limite.
+    // Bytes acima do limite contam como packet flood; conexões, conexões vazias e erros, como connection flood.
+    uint32_t max_bytes_in_per_client;
+    uint32_t max_bytes_out_per_client;
+    uint16_t max_connections_per_client;
+    uint16_t max_empty_connections_per_client;
+    uint16_t max_recv_errors_per_client;
+
+    // Efeitos colaterais opcionais, chamados pelo dono do shard do MAC
+    void (*on_block)(const uint8_t *mac, ids_attack_t attack, void *ctx);  // nova entrada
+    void (*on_unblock)(const uint8_t *mac, void *ctx);                     // entrada expirou
+    void *ctx;
+} ids_config_t;
+
+typedef struct {
+    uint32_t deauth_floods;
+    uint32_t auth_floods;
+    uint32_t packet_floods;
+    uint32_t connection_floods;
+    uint32_t blacklist_additions;
+    uint16_t blacklist_active;
+    uint16_t monitored_clients;
+} ids_stats_t;
+
+static inline uint8_t ids_shard_of(const uint8_t *mac)
+{
+    // FNV-1a dos 6 bytes: MACs derivados de IP (02:00:<ip>) também se espalham
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < 6; i++) {
+        hash = (hash ^ mac[i]) * 16777619u;
+    }
+    return (uint8_t)((hash ^ (hash >> 16)) % IDS_SHARDS);
+}
+
+// Tabelas e métricas de todos os shards (caminho frio, uma vez)
+void ids_init(const ids_config_t *config, time_us_t now_us);
+
+// Avança o relógio de um shard, disparando as expirações vencidas (só o dono do shard)
+uint32_t ids_advance_shard(uint8_t shard, time_us_t now_us);
+
+// Avança todos os shards (dono único, ex.: analisador offline)
+uint32_t ids_advance(time_us_t now_us);
+
+// Wheel de um shard, para o dono agendar seus próprios timers no mesmo relógio
+timer_wheel_t *ids_timer_wheel(uint8_t shard);
+
+// Eventos observados pela aplicação (executados no shard de ids_shard_of(mac))
+ids_result_t ids_station_connected(const uint8_t *mac, time_us_t now_us);
+ids_result_t ids_station_disconnected(const uint8_t *mac, time_us_t now_us);
+// suspicion: peso extra do pacote na janela (conteúdo repetido/baixa entropia), 0 = só contagem
+ids_result_t ids_client_packet(const uint8_t *mac, uint8_t suspicion, time_us_t now_us);
+// Soma a atividade (bytes, conexões, erros) na janela do cliente e aplica os limites configurados
+ids_result_t ids_client_activity(const uint8_t *mac, const ids_client_activity_t *activity, time_us_t now_us);
+
+bool ids_is_blacklisted(const uint8_t *mac);
+ids_result_t ids_blacklist_add(const uint8_t *mac, ids_attack_t attack, time_us_t now_us);
+
+void ids_get_stats(ids_stats_t *stats);
+const char *ids_attack_name(ids_attack_t attack);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Parsing mínimo do cabeçalho 802.11 (Frame Control e endereços), sem cópia:
+ * os ponteiros apontam para dentro do quadro. Usado pelo analisador offline
+ * (tools/ids_host) e por consumidores do modo promíscuo no ESP32.
+ */
+
+#define IDS_DOT11_TYPE_MGMT 0
+#define IDS_DOT11_TYPE_CTRL 1
+#define IDS_DOT11_TYPE_DATA 2
+
+#define IDS_DOT11_MGMT_ASSOC_REQ   0x0
+#define IDS_DOT11_MGMT_REASSOC_REQ 0x2
+#define IDS_DOT11_MGMT_PROBE_REQ   0x4
+#define IDS_DOT11_MGMT_PROBE_RESP  0x5
+#define IDS_DOT11_MGMT_BEACON      0x8
+#define IDS_DOT11_MGMT_DISASSOC    0xA
+#define IDS_DOT11_MGMT_AUTH        0xB
+#define IDS_DOT11_MGMT_DEAUTH      0xC
+
+#define IDS_DOT11_FC_TO_DS   0x01
+#define IDS_DOT11_FC_FROM_DS 0x02
+
+#define IDS_DOT11_HDR_LEN 24
+
+typedef struct {
+    uint8_t type;
+    uint8_t subtype;
+    uint8_t flags;              // segundo byte do Frame Control
+    const uint8_t *addr1;       // destino (RA)
+    const uint8_t *addr2;       // origem (TA)
+    const uint8_t *addr3;       // BSSID em quadros de gerenciamento
+    const uint8_t *body;        // corpo após o cabeçalho de 24 bytes
+    uint32_t body_len;
+} ids_dot11_hdr_t;
+
+static inline bool ids_dot11_parse(const uint8_t *frame, uint32_t len, ids_dot11_hdr_t *hdr)
+{
+    /*
+    @brief Decodifica Frame Control e os três primeiros endereços.
+    @return false para quadros curtos demais ou de controle (cabeçalho reduzido)
+    */
+    if (len < IDS_DOT11_HDR_LEN) {
+        return false;
+    }
+
+    hdr->type = (frame[0] >> 2) & 0x3;
+    hdr->subtype = (frame[0] >> 4) & 0xF;
+    hdr->flags = frame[1];
+    if (hdr->type == IDS_DOT11_TYPE_CTRL) {
+        return false;
+    }
+
+    hdr->addr1 = frame + 4;
+    hdr->addr2 = frame + 10;
+    hdr->addr3 = frame + 16;
+    hdr->body = frame + IDS_DOT11_HDR_LEN;
+    hdr->body_len = len - IDS_DOT11_HDR_LEN;
+    return true;
+}
+
+static inline bool ids_dot11_mac_equal(const uint8_t *a, const uint8_t *b)
+{
+    return memcmp(a, b, 6) == 0;
+}
+
+static inline const uint8_t *ids_dot11_bssid(const ids_dot11_hdr_t *hdr)
+{
+    // Dados: ToDS -> addr1, FromDS -> addr2; gerenciamento (e IBSS): addr3
+    if (hdr->type == IDS_DOT11_TYPE_DATA) {
+        uint8_t ds = hdr->flags & (IDS_DOT11_FC_TO_DS | IDS_DOT11_FC_FROM_DS);
+        if (ds == IDS_DOT11_FC_TO_DS) {
+            return hdr->addr1;
+        }
+        if (ds == IDS_DOT11_FC_FROM_DS) {
+            return hdr->addr2;
+        }
+    }
+    return hdr->addr3;
+}
+
+/*
+ * Tradução de um quadro no evento que o AP recebe do driver/servidor, para
+ * alimentar o núcleo (ids_station_connected/disconnected, ids_client_packet).
+ */
+typedef enum {
+    IDS_DOT11_EVENT_NONE = 0,
+    IDS_DOT11_EVENT_CONNECT,        // pedido de autenticação (seq 1) da estação
+    IDS_DOT11_EVENT_DISCONNECT,     // deauth ou disassoc
+    IDS_DOT11_EVENT_PACKET,         // dados da estação para o AP (ToDS)
+} ids_dot11_event_t;
+
+static inline ids_dot11_event_t ids_dot11_event(const ids_dot11_hdr_t *hdr, const uint8_t **station)
+{
+    /*
+    @brief Classifica o quadro em O(1), sem laços sobre o corpo.
+    @param station Estação afetada (MAC usado pelo IDS)
+    */
+    if (hdr->type == IDS_DOT11_TYPE_DATA) {
+        if ((hdr->flags & (IDS_DOT11_FC_TO_DS | IDS_DOT11_FC_FROM_DS)) != IDS_DOT11_FC_TO_DS) {
+            return IDS_DOT11_EVENT_NONE;
+        }
+        *station = hdr->addr2;
+        return IDS_DOT11_EVENT_PACKET;
+    }
+    if (hdr->type != IDS_DOT11_TYPE_MGMT) {
+        return IDS_DOT11_EVENT_NONE;
+    }
+
+    switch (hdr->subtype) {
+    case IDS_DOT11_MGMT_AUTH:
+        // Corpo: algoritmo u16, sequência u16, status u16
+        if (hdr->body_len >= 6 && (hdr->body[2] | (hdr->body[3] << 8)) == 1) {
+            *station = hdr->addr2;
+            return IDS_DOT11_EVENT_CONNECT;
+        }
+        return IDS_DOT11_EVENT_NONE;
+    case IDS_DOT11_MGMT_DEAUTH:
+    case IDS_DOT11_MGMT_DISASSOC:
+        // Enviado pelo AP (TA == BSSID): a estação é o destino; senão, a origem
+        *station = ids_dot11_mac_equal(hdr->addr2, hdr->addr3) ? hdr->addr1 : hdr->addr2;
+        return IDS_DOT11_EVENT_DISCONNECT;
+    default:
+        return IDS_DOT11_EVENT_NONE;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Pool de objetos de tamanho fixo (slab). O armazenamento é um array estático
+ * definido em tempo de compilação com MEM_POOL_DEFINE, então o consumo de
+ * memória é conhecido no link e nada passa pelo heap. Os blocos livres formam
+ * uma lista encadeada dentro do próprio armazenamento: alocar e liberar são O(1).
+ *
+ * Cada pool publica no registro de métricas:
+ *   mempool_<nome>_in_use          (gauge)   blocos em uso
+ *   mempool_<nome>_exhausted_total (counter) alocações recusadas por falta de bloco
+ */
+
+typedef struct mem_pool_block {
+    struct mem_pool_block *next;
+} mem_pool_block_t;
+
+typedef struct {
+    const char *name;
+    uint8_t *storage;
+    size_t block_size;
+    uint16_t capacity;
+    uint16_t in_use;
+    uint16_t high_water;
+    mem_pool_block_t *free_list;
+    const char *in_use_metric;
+    const char *exhausted_metric;
+    metric_t *m_in_use;
+    metric_t *m_exhausted;
+    bool initialized;
+} mem_pool_t;
+
+// Tamanho do bloco: o objeto arredondado para o alinhamento de ponteiro,
+// com espaço mínimo para o encadeamento da lista livre
+#define MEM_POOL_BLOCK_SIZE(type) \
+    (((sizeof(type) > sizeof(mem_pool_block_t) ? sizeof(type) : sizeof(mem_pool_block_t)) \
+      + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+/*
+ * Define um pool estático. `pool_name` precisa ser um literal de string: os nomes
+ * das métricas são montados por concatenação em tempo de compilação.
+ *
+ *   MEM_POOL_DEFINE(conn_pool, tcp_conn_t, 4, "tcp_conn");
+ */
+#define MEM_POOL_DEFINE(var, type, count, pool_name)                               \
+    static uint8_t var##_storage[(count) * MEM_POOL_BLOCK_SIZE(type)]              \
+        __attribute__((aligned(sizeof(void *))));                                   \
+    static mem_pool_t var = {                                                       \
+        .name = pool_name,                                                          \
+        .storage = var##_storage,                                                   \
+        .block_size = MEM_POOL_BLOCK_SIZE(type),                                    \
+        .capacity = (count),                                                        \
+        .in_use_metric = "mempool_" pool_name "_in_use",                            \
+        .exhausted_metric = "mempool_" pool_name "_exhausted_total",                \
+    }
+
+// Monta a lista livre e registra as métricas (caminho frio, uma vez por pool)
+void mem_pool_init(mem_pool_t *pool);
+
+// Devolve um bloco zerado, ou NULL se o pool estiver esgotado
+void *mem_pool_alloc(mem_pool_t *pool);
+void mem_pool_free(mem_pool_t *pool, void *block);
+
+// Índice estável do bloco no armazenamento (0..capacity-1), para tabelas
+// paralelas indexadas pelo bloco (ex.: chaves compactas do IDS)
+static inline size_t mem_pool_index(const mem_pool_t *pool, const void *block)
+{
+    return (size_t)((const uint8_t *)block - pool->storage) / pool->block_size;
+}
+
+// Bloco de um índice (em uso ou não: quem chama sabe que está alocado)
+static inline void *mem_pool_at(const mem_pool_t *pool, size_t index)
+{
+    return pool->storage + index * pool->block_size;
+}
+
+static inline uint16_t mem_pool_in_use(const mem_pool_t *pool)
+{
+    return __atomic_load_n(&pool->in_use, __ATOMIC_RELAXED);
+}
+
+static inline uint16_t mem_pool_capacity(const mem_pool_t *pool)
+{
+    return pool->capacity;
+}
+
+// Resumo de todos os pools inicializados (ocupação, pico e esgotamentos)
+void mem_pool_log_all(const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
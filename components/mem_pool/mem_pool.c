@@ -0,0 +1,125 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "mem_pool.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+
+static portMUX_TYPE s_pool_lock = portMUX_INITIALIZER_UNLOCKED;
+#define POOL_LOCK()   portENTER_CRITICAL(&s_pool_lock)
+#define POOL_UNLOCK() portEXIT_CRITICAL(&s_pool_lock)
+#define POOL_LOG(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#else
+// Build de host (ferramentas e benchmarks): spinlock simples
+static volatile char s_pool_lock = 0;
+#define POOL_LOCK()   while (__atomic_test_and_set(&s_pool_lock, __ATOMIC_ACQUIRE)) {}
+#define POOL_UNLOCK() __atomic_clear(&s_pool_lock, __ATOMIC_RELEASE)
+#define POOL_LOG(tag, fmt, ...) printf("%s: " fmt "\n", tag, ##__VA_ARGS__)
+#endif
+
+// Pools inicializados, para o relatório; não há limite no número de pools definidos
+#define MEM_POOL_MAX_REGISTERED 16
+static mem_pool_t *s_pools[MEM_POOL_MAX_REGISTERED];
+static size_t s_pool_count = 0;
+
+void mem_pool_init(mem_pool_t *pool)
+{
+    /*
+    @brief Encadeia todos os blocos na lista livre e registra as métricas do pool.
+    @param pool Pool definido com MEM_POOL_DEFINE
+    @note Chamar novamente em um pool já inicializado não tem efeito.
+    */
+    if (pool->initialized) {
+        return;
+    }
+
+    pool->free_list = NULL;
+    for (int i = pool->capacity - 1; i >= 0; i--) {
+        mem_pool_block_t *block = (mem_pool_block_t *)(pool->storage + (size_t)i * pool->block_size);
+        block->next = pool->free_list;
+        pool->free_list = block;
+    }
+    pool->in_use = 0;
+    pool->high_water = 0;
+
+    pool->m_in_use = metrics_gauge(pool->in_use_metric, "Blocos em uso no pool");
+    pool->m_exhausted = metrics_counter(pool->exhausted_metric, "Alocacoes recusadas por pool esgotado");
+
+    POOL_LOCK();
+    if (s_pool_count < MEM_POOL_MAX_REGISTERED) {
+        s_pools[s_pool_count++] = pool;
+    }
+    pool->initialized = true;
+    POOL_UNLOCK();
+}
+
+void *mem_pool_alloc(mem_pool_t *pool)
+{
+    /*
+    @brief Retira um bloco da lista livre.
+    @return Bloco zerado com pool->block_size bytes, ou NULL se esgotado
+    @note O esgotamento não é fatal: é contado em mempool_<nome>_exhausted_total
+    e o chamador decide a política (recusar conexão, ignorar cliente, etc.).
+    */
+    POOL_LOCK();
+    mem_pool_block_t *block = pool->free_list;
+    if (block != NULL) {
+        pool->free_list = block->next;
+        pool->in_use++;
+        if (pool->in_use > pool->high_water) {
+            pool->high_water = pool->in_use;
+        }
+    }
+    POOL_UNLOCK();
+
+    if (block == NULL) {
+        metric_inc(pool->m_exhausted);
+        return NULL;
+    }
+
+    metric_gauge_add(pool->m_in_use, 1);
+    memset(block, 0, pool->block_size);
+    return block;
+}
+
+void mem_pool_free(mem_pool_t *pool, void *ptr)
+{
+    /*
+    @brief Devolve um bloco à lista livre.
+    @param ptr Bloco obtido de mem_pool_alloc no mesmo pool (NULL é ignorado)
+    */
+    if (ptr == NULL) {
+        return;
+    }
+
+    assert((uint8_t *)ptr >= pool->storage &&
+                (uint8_t *)ptr < pool->storage + (size_t)pool->capacity * pool->block_size);
+
+    mem_pool_block_t *block = (mem_pool_block_t *)ptr;
+
+    POOL_LOCK();
+    block->next = pool->free_list;
+    pool->free_list = block;
+    pool->in_use--;
+    POOL_UNLOCK();
+
+    metric_gauge_add(pool->m_in_use, -1);
+}
+
+void mem_pool_log_all(const char *tag)
+{
+    size_t total_bytes = 0;
+
+    POOL_LOG(tag, "=== POOLS DE MEMORIA (%u) ===", (unsigned)s_pool_count);
+    for (size_t i = 0; i < s_pool_count; i++) {
+        const mem_pool_t *pool = s_pools[i];
+        size_t bytes = (size_t)pool->capacity * pool->block_size;
+        total_bytes += bytes;
+        POOL_LOG(tag, "  %s: %u/%u em uso (pico %u), %u B, esgotado %ld vezes",
+                 pool->name, (unsigned)mem_pool_in_use(pool), (unsigned)pool->capacity,
+                 (unsigned)pool->high_water, (unsigned)bytes, (long)metric_value(pool->m_exhausted));
+    }
+    POOL_LOG(tag, "  Total reservado: %u B", (unsigned)total_bytes);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Capacidade do registro (fixa em tempo de compilação)
+#ifndef METRICS_MAX_ENTRIES
+#define METRICS_MAX_ENTRIES 112
+#endif
+#define METRICS_HISTOGRAM_MAX_BUCKETS 12
+
+typedef enum {
+    METRIC_COUNTER = 0,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM,
+} metric_type_t;
+
+typedef struct {
+    const char *name;
+    const char *help;
+    metric_type_t type;
+    volatile int32_t value;          // contador (uint32 com wrap) ou gauge
+    // Histograma: bounds[i] é o limite superior (inclusivo) do bucket i,
+    // buckets[n_bounds] acumula as amostras acima do último limite (+Inf)
+    const uint32_t *bounds;
+    uint8_t n_bounds;
+    volatile uint32_t buckets[METRICS_HISTOGRAM_MAX_BUCKETS + 1];
+    volatile uint32_t count;
+    volatile uint32_t sum;
+} metric_t;
+
+/*
+ * Registro (caminho frio): devolve a métrica existente se o nome já foi
+ * registrado. Registro cheio loga um erro e falha no assert: aumente
+ * METRICS_MAX_ENTRIES. Os handles são estáveis durante toda a execução e
+ * podem ser guardados em variáveis estáticas.
+ */
+metric_t *metrics_counter(const char *name, const char *help);
+metric_t *metrics_gauge(const char *name, const char *help);
+metric_t *metrics_histogram(const char *name, const char *help,
+                            const uint32_t *bounds, uint8_t n_bounds);
+
+/*
+ * Atualizações (caminho quente): apenas operações atômicas, sem locks.
+ * Aceitam NULL (registro cheio num build com NDEBUG). As métricas só exportam
+ * valores: nenhuma lógica da aplicação deve depender delas.
+ */
+static inline void metric_add(metric_t *m, uint32_t n)
+{
+    if (m) {
+        __atomic_fetch_add((volatile uint32_t *)&m->value, n, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void metric_inc(metric_t *m)
+{
+    metric_add(m, 1);
+}
+
+static inline void metric_set(metric_t *m, int32_t v)
+{
+    if (m) {
+        __atomic_store_n(&m->value, v, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void metric_gauge_add(metric_t *m, int32_t delta)
+{
+    if (m) {
+        __atomic_fetch_add(&m->value, delta, __ATOMIC_RELAXED);
+    }
+}
+
+static inline int32_t metric_value(const metric_t *m)
+{
+    return m ? __atomic_load_n(&m->value, __ATOMIC_RELAXED) : 0;
+}
+
+void metric_observe(metric_t *m, uint32_t sample);
+
+// Iteração para exportadores (leitura sem lock das entradas já publicadas)
+size_t metrics_count(void);
+const metric_t *metrics_at(size_t index);
+const metric_t *metrics_find(const char *name);
+
+// Despeja todas as métricas no log (substitui os relatórios ad-hoc por app)
+void metrics_log_all(const char *tag);
+
+/*
+ * Exportação no formato de texto do Prometheus. Cada métrica é copiada para
+ * um snapshot local antes de ser formatada, e o texto é entregue ao writer
+ * em pedaços (uma linha por chamada), sem buffer proporcional ao registro.
+ * Retorna 0 ou o primeiro erro devolvido pelo writer.
+ */
+typedef int (*metrics_writer_t)(void *ctx, const char *data, size_t len);
+int metrics_export_prometheus(metrics_writer_t writer, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,228 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "metrics.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+
+static portMUX_TYPE s_metrics_lock = portMUX_INITIALIZER_UNLOCKED;
+#define METRICS_LOCK()   portENTER_CRITICAL(&s_metrics_lock)
+#define METRICS_UNLOCK() portEXIT_CRITICAL(&s_metrics_lock)
+#define METRICS_LOG(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define METRICS_LOG_ERROR(tag, fmt, ...) ESP_LOGE(tag, fmt, ##__VA_ARGS__)
+#else
+// Build de host (ferramentas e benchmarks): spinlock simples
+static volatile char s_metrics_lock = 0;
+#define METRICS_LOCK()   while (__atomic_test_and_set(&s_metrics_lock, __ATOMIC_ACQUIRE)) {}
+#define METRICS_UNLOCK() __atomic_clear(&s_metrics_lock, __ATOMIC_RELEASE)
+#define METRICS_LOG(tag, fmt, ...) printf("%s: " fmt "\n", tag, ##__VA_ARGS__)
+#define METRICS_LOG_ERROR(tag, fmt, ...) fprintf(stderr, "%s: " fmt "\n", tag, ##__VA_ARGS__)
+#endif
+
+static metric_t s_metrics[METRICS_MAX_ENTRIES];
+static volatile uint32_t s_metrics_count = 0;
+
+static metric_t *metrics_register(const char *name, const char *help, metric_type_t type,
+                                  const uint32_t *bounds, uint8_t n_bounds)
+{
+    /*
+    @brief Registra uma métrica no registro global (ou devolve a existente).
+    @param name Nome da métrica (estilo Prometheus, ex.: ids_deauth_floods_total)
+    @param help Descrição curta usada pelos exportadores
+    @param type Tipo da métrica
+    @note As entradas são preenchidas antes de s_metrics_count ser publicado,
+    então leitores concorrentes nunca enxergam uma métrica pela metade.
+    @note Registro cheio é erro de dimensionamento (METRICS_MAX_ENTRIES): loga e
+    falha no assert, em vez de devolver NULL e perder a métrica em silêncio.
+    */
+    metric_t *m = NULL;
+
+    if (n_bounds > METRICS_HISTOGRAM_MAX_BUCKETS) {
+        n_bounds = METRICS_HISTOGRAM_MAX_BUCKETS;
+    }
+
+    METRICS_LOCK();
+    uint32_t count = s_metrics_count;
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(s_metrics[i].name, name) == 0) {
+            m = &s_metrics[i];
+            break;
+        }
+    }
+
+    if (m == NULL && count < METRICS_MAX_ENTRIES) {
+        m = &s_metrics[count];
+        memset(m, 0, sizeof(*m));
+        m->name = name;
+        m->help = help;
+        m->type = type;
+        m->bounds = bounds;
+        m->n_bounds = n_bounds;
+        __atomic_store_n(&s_metrics_count, count + 1, __ATOMIC_RELEASE);
+    }
+    METRICS_UNLOCK();
+
+    if (m == NULL) {
+        METRICS_LOG_ERROR("METRICS", "Registro cheio (METRICS_MAX_ENTRIES = %d): %s nao registrada",
+                          METRICS_MAX_ENTRIES, name);
+    }
+    assert(m != NULL);
+    return m;
+}
+
+metric_t *metrics_counter(const char *name, const char *help)
+{
+    return metrics_register(name, help, METRIC_COUNTER, NULL, 0);
+}
+
+metric_t *metrics_gauge(const char *name, const char *help)
+{
+    return metrics_register(name, help, METRIC_GAUGE, NULL, 0);
+}
+
+metric_t *metrics_histogram(const char *name, const char *help,
+                            const uint32_t *bounds, uint8_t n_bounds)
+{
+    return metrics_register(name, help, METRIC_HISTOGRAM, bounds, n_bounds);
+}
+
+void metric_observe(metric_t *m, uint32_t sample)
+{
+    /*
+    @brief Registra uma amostra em um histograma.
+    @note Busca linear nos limites (no máximo METRICS_HISTOGRAM_MAX_BUCKETS),
+    seguida de incrementos atômicos; nenhum lock é adquirido.
+    */
+    if (m == NULL || m->type != METRIC_HISTOGRAM) {
+        return;
+    }
+
+    uint8_t bucket = 0;
+    while (bucket < m->n_bounds && sample > m->bounds[bucket]) {
+        bucket++;
+    }
+
+    __atomic_fetch_add(&m->buckets[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->sum, sample, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->count, 1, __ATOMIC_RELAXED);
+}
+
+size_t metrics_count(void)
+{
+    return __atomic_load_n(&s_metrics_count, __ATOMIC_ACQUIRE);
+}
+
+const metric_t *metrics_at(size_t index)
+{
+    return index < metrics_count() ? &s_metrics[index] : NULL;
+}
+
+const metric_t *metrics_find(const char *name)
+{
+    size_t count = metrics_count();
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(s_metrics[i].name, name) == 0) {
+            return &s_metrics[i];
+        }
+    }
+    return NULL;
+}
+
+void metrics_log_all(const char *tag)
+{
+    size_t count = metrics_count();
+
+    METRICS_LOG(tag, "=== METRICAS (%u) ===", (unsigned)count);
+    for (size_t i = 0; i < count; i++) {
+        const metric_t *m = &s_metrics[i];
+        switch (m->type) {
+        case METRIC_COUNTER:
+            METRICS_LOG(tag, "  %s: %lu", m->name, (unsigned long)(uint32_t)metric_value(m));
+            break;
+        case METRIC_GAUGE:
+            METRICS_LOG(tag, "  %s: %ld", m->name, (long)metric_value(m));
+            break;
+        case METRIC_HISTOGRAM: {
+            uint32_t count_obs = __atomic_load_n(&m->count, __ATOMIC_RELAXED);
+            uint32_t sum = __atomic_load_n(&m->sum, __ATOMIC_RELAXED);
+            METRICS_LOG(tag, "  %s: n=%lu media=%lu", m->name, (unsigned long)count_obs,
+                        (unsigned long)(count_obs ? sum / count_obs : 0));
+            break;
+        }
+        }
+    }
+}
+
+static int metrics_emit(metrics_writer_t writer, void *ctx, char *line, size_t size, int len)
+{
+    if (len < 0) {
+        return 0;
+    }
+    if ((size_t)len >= size) {
+        len = size - 1;
+    }
+    return writer(ctx, line, len);
+}
+
+int metrics_export_prometheus(metrics_writer_t writer, void *ctx)
+{
+    /*
+    @brief Gera o texto de exposição do Prometheus para todas as métricas.
+    @param writer Função que recebe cada pedaço de texto (ex.: httpd_resp_send_chunk)
+    @param ctx Contexto repassado ao writer
+    @note Os valores são lidos atomicamente para um snapshot antes da formatação;
+    nenhum lock do registro ou das tabelas da aplicação é mantido durante o envio.
+    */
+    static const char *type_names[] = {"counter", "gauge", "histogram"};
+    char line[160];
+    int err = 0;
+    size_t count = metrics_count();
+
+    for (size_t i = 0; i < count && err == 0; i++) {
+        const metric_t *m = &s_metrics[i];
+
+        err = metrics_emit(writer, ctx, line, sizeof(line),
+                           snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n",
+                                    m->name, m->help ? m->help : "", m->name, type_names[m->type]));
+        if (err) {
+            break;
+        }
+
+        if (m->type == METRIC_COUNTER) {
+            err = metrics_emit(writer, ctx, line, sizeof(line),
+                               snprintf(line, sizeof(line), "%s %lu\n", m->name,
+                                        (unsigned long)(uint32_t)metric_value(m)));
+        } else if (m->type == METRIC_GAUGE) {
+            err = metrics_emit(writer, ctx, line, sizeof(line),
+                               snprintf(line, sizeof(line), "%s %ld\n", m->name, (long)metric_value(m)));
+        } else {
+            uint32_t snapshot[METRICS_HISTOGRAM_MAX_BUCKETS + 1];
+            for (uint8_t b = 0; b <= m->n_bounds; b++) {
+                snapshot[b] = __atomic_load_n(&m->buckets[b], __ATOMIC_RELAXED);
+            }
+            uint32_t sum = __atomic_load_n(&m->sum, __ATOMIC_RELAXED);
+
+            // Buckets do Prometheus são cumulativos; o total vem do próprio snapshot
+            uint32_t cumulative = 0;
+            for (uint8_t b = 0; b < m->n_bounds && err == 0; b++) {
+                cumulative += snapshot[b];
+                err = metrics_emit(writer, ctx, line, sizeof(line),
+                                   snprintf(line, sizeof(line), "%s_bucket{le=\"%lu\"} %lu\n", m->name,
+                                            (unsigned long)m->bounds[b], (unsigned long)cumulative));
+            }
+            cumulative += snapshot[m->n_bounds];
+            if (err == 0) {
+                err = metrics_emit(writer, ctx, line, sizeof(line),
+                                   snprintf(line, sizeof(line),
+                                            "%s_bucket{le=\"+Inf\"} %lu\n%s_sum %lu\n%s_count %lu\n",
+                                            m->name, (unsigned long)cumulative,
+                                            m->name, (unsigned long)sum,
+                                            m->name, (unsigned long)cumulative));
+            }
+        }
+    }
+
+    return err;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Captura de quadros em PCAPNG transmitida por UART.
+ *
+ * Cada quadro vira um Enhanced Packet Block (link type 127, IEEE 802.11 +
+ * radiotap com canal e RSSI), gravado em um de dois buffers estáticos. Quando
+ * um buffer enche (ou a cada PCAP_STREAM_FLUSH_MS) uma task de escrita o envia
+ * pela UART enquanto o outro continua recebendo. Se os dois estiverem ocupados
+ * o quadro é descartado e contado - pcap_stream_write() nunca bloqueia.
+ *
+ * Na UART os blocos seguem em chunks com cabeçalho próprio, para o receptor
+ * (tools/pcap/pcap_receiver.py) ressincronizar e contabilizar perdas:
+ *
+ *   magic "\xA5\x5APC" | seq u16 | len u16 | dropped u32 | EPBs (len bytes) | crc32 u32
+ *
+ * O SHB e o IDB do arquivo .pcapng são escritos pelo receptor.
+ */
+
+#ifndef PCAP_STREAM_UART
+#define PCAP_STREAM_UART 1          // UART dedicada: a UART0 continua com o console
+#endif
+#ifndef PCAP_STREAM_TX_PIN
+#define PCAP_STREAM_TX_PIN 17
+#endif
+#ifndef PCAP_STREAM_BAUD
+#define PCAP_STREAM_BAUD 2000000
+#endif
+#define PCAP_STREAM_BUF_SIZE 4096   // por buffer (dois buffers)
+#define PCAP_STREAM_SNAPLEN 256     // bytes do quadro 802.11 guardados por registro
+#define PCAP_STREAM_FLUSH_MS 200    // envio de buffers parcialmente cheios
+
+#define PCAP_STREAM_LINKTYPE 127    // LINKTYPE_IEEE802_11_RADIOTAP
+#define PCAP_STREAM_CHUNK_MAGIC 0x43505AA5u
+
+// Configura a UART e cria a task de escrita (núcleo/prioridade definidos pela app)
+esp_err_t pcap_stream_start(int core, int priority, int stack_size);
+
+/*
+ * Registra um quadro. Seguro no callback promíscuo: O(len), sem bloqueio.
+ * @param frame  Quadro 802.11 (com FCS, como entregue pelo driver)
+ * @param len    Tamanho do quadro
+ * @param channel Canal em que foi recebido
+ * @param rssi   RSSI em dBm
+ * @param ts_us  Timestamp em µs
+ */
+void pcap_stream_write(const uint8_t *frame, uint16_t len, uint8_t channel, int8_t rssi, int64_t ts_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,238 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "metrics.h"
+#include "pcap_stream.h"
+
+static const char *TAG = "PCAP_STREAM";
+
+#define EPB_BLOCK_TYPE 0x00000006u
+#define EPB_HEADER_LEN 28           // tipo, tamanho, interface, ts alto/baixo, cap_len, orig_len
+#define EPB_TRAILER_LEN 4           // tamanho repetido
+#define RADIOTAP_LEN 15
+#define CHUNK_HEADER_LEN 12
+#define CHUNK_TRAILER_LEN 4
+
+#define RADIOTAP_PRESENT_FLAGS   (1u << 1)
+#define RADIOTAP_PRESENT_CHANNEL (1u << 3)
+#define RADIOTAP_PRESENT_SIGNAL  (1u << 5)
+#define RADIOTAP_FLAG_FCS        0x10
+#define RADIOTAP_CHAN_2GHZ       0x0080
+
+// Buffers com espaço para o cabeçalho e o CRC do chunk: o envio é um único bloco contíguo
+typedef struct {
+    uint8_t data[CHUNK_HEADER_LEN + PCAP_STREAM_BUF_SIZE + CHUNK_TRAILER_LEN] __attribute__((aligned(4)));
+    size_t fill;
+} pcap_buffer_t;
+
+static pcap_buffer_t s_buffers[2];
+static int s_active = 0;            // buffer recebendo registros
+static int s_ready = -1;            // buffer cheio aguardando envio
+static int s_sending = -1;          // buffer em transmissão
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_writer = NULL;
+static uint16_t s_seq = 0;
+static volatile uint32_t s_dropped = 0;
+
+static metric_t *m_captured;
+static metric_t *m_dropped;
+static metric_t *m_bytes_sent;
+static metric_t *m_chunks_sent;
+
+static inline void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static bool pcap_buffer_is_free(int index)
+{
+    return index != s_ready && index != s_sending;
+}
+
+static void pcap_build_record(uint8_t *record, const uint8_t *frame, uint16_t len, uint16_t cap_len,
+                              uint32_t block_len, uint8_t channel, int8_t rssi, int64_t ts_us)
+{
+    uint32_t packet_len = RADIOTAP_LEN + cap_len;
+    uint32_t padded_len = (packet_len + 3) & ~3u;
+    uint64_t ts = (uint64_t)ts_us;
+
+    put_u32(record, EPB_BLOCK_TYPE);
+    put_u32(record + 4, block_len);
+    put_u32(record + 8, 0);                         // interface 0
+    put_u32(record + 12, (uint32_t)(ts >> 32));
+    put_u32(record + 16, (uint32_t)ts);
+    put_u32(record + 20, packet_len);
+    put_u32(record + 24, RADIOTAP_LEN + len);
+
+    uint8_t *rt = record + EPB_HEADER_LEN;
+    uint16_t freq = channel == 14 ? 2484 : 2407 + 5 * channel;
+    rt[0] = 0;                                      // versão
+    rt[1] = 0;
+    put_u16(rt + 2, RADIOTAP_LEN);
+    put_u32(rt + 4, RADIOTAP_PRESENT_FLAGS | RADIOTAP_PRESENT_CHANNEL | RADIOTAP_PRESENT_SIGNAL);
+    rt[8] = RADIOTAP_FLAG_FCS;
+    rt[9] = 0;                                      // alinhamento do campo de canal
+    put_u16(rt + 10, freq);
+    put_u16(rt + 12, RADIOTAP_CHAN_2GHZ);
+    rt[14] = (uint8_t)rssi;
+
+    memcpy(rt + RADIOTAP_LEN, frame, cap_len);
+    memset(rt + packet_len, 0, padded_len - packet_len);
+    put_u32(record + EPB_HEADER_LEN + padded_len, block_len);
+}
+
+void pcap_stream_write(const uint8_t *frame, uint16_t len, uint8_t channel, int8_t rssi, int64_t ts_us)
+{
+    /*
+    @brief Monta um EPB (radiotap + quadro truncado em PCAP_STREAM_SNAPLEN) no buffer ativo.
+    @note O registro (no máximo ~300 B) é montado dentro da seção crítica, então a
+    task de escrita nunca envia um buffer com um registro pela metade. Sem buffer
+    livre, o quadro é descartado e contado.
+    */
+    if (s_writer == NULL) {
+        return;
+    }
+
+    uint16_t cap_len = len > PCAP_STREAM_SNAPLEN ? PCAP_STREAM_SNAPLEN : len;
+    uint32_t block_len = EPB_HEADER_LEN + ((RADIOTAP_LEN + cap_len + 3) & ~3u) + EPB_TRAILER_LEN;
+    bool stored = false;
+    bool notify = false;
+
+    portENTER_CRITICAL(&s_lock);
+    pcap_buffer_t *buffer = &s_buffers[s_active];
+    if (buffer->fill + block_len > PCAP_STREAM_BUF_SIZE) {
+        int other = s_active ^ 1;
+        if (buffer->fill > 0 && pcap_buffer_is_free(other)) {
+            s_ready = s_active;
+            s_active = other;
+            notify = true;
+            buffer = &s_buffers[s_active];
+        } else {
+            buffer = NULL;
+        }
+    }
+    if (buffer != NULL) {
+        pcap_build_record(buffer->data + CHUNK_HEADER_LEN + buffer->fill, frame, len, cap_len,
+                          block_len, channel, rssi, ts_us);
+        buffer->fill += block_len;
+        stored = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (notify) {
+        xTaskNotifyGive(s_writer);
+    }
+
+    if (!stored) {
+        __atomic_fetch_add(&s_dropped, 1, __ATOMIC_RELAXED);
+        metric_inc(m_dropped);
+        return;
+    }
+    metric_inc(m_captured);
+}
+
+static void pcap_send_buffer(pcap_buffer_t *buffer)
+{
+    uint8_t *chunk = buffer->data;
+    uint16_t len = (uint16_t)buffer->fill;
+
+    put_u32(chunk, PCAP_STREAM_CHUNK_MAGIC);
+    put_u16(chunk + 4, s_seq++);
+    put_u16(chunk + 6, len);
+    put_u32(chunk + 8, __atomic_load_n(&s_dropped, __ATOMIC_RELAXED));
+
+    uint32_t crc = esp_rom_crc32_le(0, chunk, CHUNK_HEADER_LEN + len);
+    put_u32(chunk + CHUNK_HEADER_LEN + len, crc);
+
+    size_t total = CHUNK_HEADER_LEN + len + CHUNK_TRAILER_LEN;
+    uart_write_bytes(PCAP_STREAM_UART, chunk, total);
+    metric_add(m_bytes_sent, total);
+    metric_inc(m_chunks_sent);
+}
+
+static void pcap_writer_task(void *arg)
+{
+    /*
+    @brief Envia pela UART os buffers prontos.
+    @note Acordada pela troca de buffer no pcap_stream_write ou a cada PCAP_STREAM_FLUSH_MS;
+    no timeout, um buffer parcialmente cheio é enviado para limitar a latência da captura.
+    */
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PCAP_STREAM_FLUSH_MS));
+
+        int index = -1;
+        portENTER_CRITICAL(&s_lock);
+        if (s_ready >= 0) {
+            index = s_ready;
+            s_ready = -1;
+        } else if (s_buffers[s_active].fill > 0 && pcap_buffer_is_free(s_active ^ 1)) {
+            index = s_active;
+            s_active ^= 1;
+        }
+        s_sending = index;
+        portEXIT_CRITICAL(&s_lock);
+
+        if (index < 0) {
+            continue;
+        }
+
+        pcap_send_buffer(&s_buffers[index]);
+
+        portENTER_CRITICAL(&s_lock);
+        s_buffers[index].fill = 0;
+        s_sending = -1;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+esp_err_t pcap_stream_start(int core, int priority, int stack_size)
+{
+    /*
+    @brief Configura a UART de captura e inicia a task de escrita.
+    @note O driver da UART recebe um buffer de TX do tamanho de um chunk, então
+    uart_write_bytes retorna assim que o chunk é copiado e a transmissão segue por interrupção.
+    */
+    if (s_writer != NULL) {
+        return ESP_OK;
+    }
+
+    m_captured = metrics_counter("pcap_frames_captured_total", "Quadros gravados no stream PCAP");
+    m_dropped = metrics_counter("pcap_frames_dropped_total", "Quadros descartados por buffers cheios");
+    m_bytes_sent = metrics_counter("pcap_bytes_sent_total", "Bytes enviados pela UART de captura");
+    m_chunks_sent = metrics_counter("pcap_chunks_sent_total", "Chunks enviados pela UART de captura");
+
+    uart_config_t uart_config = {
+        .baud_rate = PCAP_STREAM_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    ESP_ERROR_CHECK(uart_driver_install(PCAP_STREAM_UART, 256,
+                                        sizeof(s_buffers[0].data), 0, NULL, 0));
+    ESP_ERROR_CHECK(uart_param_config(PCAP_STREAM_UART, &uart_config));
+    ESP_ERROR_CHECK(uart_set_pin(PCAP_STREAM_UART, PCAP_STREAM_TX_PIN, UART_PIN_NO_CHANGE,
+                                 UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+
+    if (xTaskCreatePinnedToCore(pcap_writer_task, "pcap_writer", stack_size, NULL,
+                                priority, &s_writer, core) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Captura PCAPNG na UART%d (TX GPIO%d, %d baud)",
+             PCAP_STREAM_UART, PCAP_STREAM_TX_PIN, PCAP_STREAM_BAUD);
+    return ESP_OK;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Base de tempo monotônica única: microssegundos em 64 bits desde o boot.
+ *
+ * No ESP32 é o esp_timer (resolução de 1 µs, sem wrap na prática), então
+ * janelas de taxa, expirações e registros de eventos não dependem do tick do
+ * FreeRTOS (10 ms) nem de um contador de ms de 32 bits que volta a zero em
+ * ~49 dias. No host (tools/ids_host) o relógio é o CLOCK_MONOTONIC, ou um
+ * relógio manual (time_base_mock_set) para reproduzir capturas e testes.
+ */
+
+typedef int64_t time_us_t;
+
+#define TIME_US_PER_MS 1000
+#define TIME_MS_TO_US(ms) ((time_us_t)(ms) * TIME_US_PER_MS)
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+
+static inline time_us_t time_base_now_us(void)
+{
+    return esp_timer_get_time();
+}
+#else
+time_us_t time_base_now_us(void);
+
+// Relógio manual do host: a partir daqui time_base_now_us() devolve now_us
+void time_base_mock_set(time_us_t now_us);
+void time_base_mock_advance(time_us_t delta_us);
+
+// Volta ao CLOCK_MONOTONIC
+void time_base_mock_release(void);
+#endif
+
+// Milissegundos em 32 bits, só para idades e LRU comparadas por diferença
+// (a aritmética modular tolera o wrap de ~49 dias)
+static inline uint32_t time_base_now_ms(void)
+{
+    return (uint32_t)(time_base_now_us() / TIME_US_PER_MS);
+}
+
+#ifdef __cplusplus
+}
+#endif
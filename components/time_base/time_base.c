@@ -0,0 +1,36 @@
+#include "time_base.h"
+
+#ifndef ESP_PLATFORM
+#include <time.h>
+
+// No ESP32 time_base_now_us() é inline (esp_timer); este arquivo só implementa o host
+static bool s_mocked = false;
+static time_us_t s_mock_us = 0;
+
+time_us_t time_base_now_us(void)
+{
+    if (s_mocked) {
+        return s_mock_us;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (time_us_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void time_base_mock_set(time_us_t now_us)
+{
+    s_mock_us = now_us;
+    s_mocked = true;
+}
+
+void time_base_mock_advance(time_us_t delta_us)
+{
+    s_mock_us += delta_us;
+    s_mocked = true;
+}
+
+void time_base_mock_release(void)
+{
+    s_mocked = false;
+}
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Timer wheel hierárquico (3 níveis de 64 slots). Com tick de 100 ms cobre
+ * 6,4 s no nível 0, 6,8 min no nível 1 e 7,3 h no nível 2; prazos maiores
+ * são limitados ao horizonte do último nível.
+ *
+ * Os timers são intrusivos (embutidos na estrutura do dono): agendar,
+ * cancelar e reagendar são O(1) e não alocam memória. A estrutura não é
+ * thread-safe e não tem lock: cada wheel deve ter um único dono (no IDS, o
+ * worker do shard, que é o único a agendar, cancelar e avançar o wheel).
+ */
+#define TIMER_WHEEL_BITS   6
+#define TIMER_WHEEL_SLOTS  (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 3
+
+struct tw_timer;
+typedef void (*tw_callback_t)(struct tw_timer *timer, void *arg);
+
+typedef struct tw_timer {
+    struct tw_timer *next;
+    struct tw_timer *prev;
+    uint32_t expires;
+    tw_callback_t callback;
+    void *arg;
+} tw_timer_t;
+
+typedef struct {
+    tw_timer_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];  // sentinelas das listas circulares
+    uint32_t now;
+    uint32_t pending;
+} timer_wheel_t;
+
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t now);
+
+// Inicializa um timer ainda não agendado (obrigatório antes do primeiro uso)
+void tw_timer_init(tw_timer_t *timer, tw_callback_t callback, void *arg);
+bool tw_timer_pending(const tw_timer_t *timer);
+
+// Agenda (ou reagenda) o timer para daqui a delay_ticks ticks (mínimo 1)
+void timer_wheel_schedule(timer_wheel_t *wheel, tw_timer_t *timer, uint32_t delay_ticks);
+void timer_wheel_cancel(timer_wheel_t *wheel, tw_timer_t *timer);
+
+/*
+ * Avança o relógio do wheel até target, disparando os timers vencidos.
+ * Callbacks podem reagendar o próprio timer ou outros. Retorna o número
+ * de timers disparados.
+ */
+uint32_t timer_wheel_advance(timer_wheel_t *wheel, uint32_t target);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,146 @@
+#include <stddef.h>
+#include "timer_wheel.h"
+
+#define TW_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TW_HORIZON ((uint32_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+static void tw_list_init(tw_timer_t *head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+static void tw_list_unlink(tw_timer_t *timer)
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+static void tw_list_append(tw_timer_t *head, tw_timer_t *timer)
+{
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t now)
+{
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            tw_list_init(&wheel->slots[level][slot]);
+        }
+    }
+    wheel->now = now;
+    wheel->pending = 0;
+}
+
+void tw_timer_init(tw_timer_t *timer, tw_callback_t callback, void *arg)
+{
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->expires = 0;
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+bool tw_timer_pending(const tw_timer_t *timer)
+{
+    return timer->next != NULL;
+}
+
+static void tw_insert(timer_wheel_t *wheel, tw_timer_t *timer)
+{
+    /*
+    @brief Coloca o timer no nível cuja granularidade cobre a distância até o prazo.
+    @note Mesmo esquema do kernel Linux: o slot é indexado pelos bits do
+    próprio prazo, então timers não precisam ser reordenados a cada tick.
+    */
+    uint32_t delta = timer->expires - wheel->now;
+    int level = 0;
+
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= ((uint32_t)1 << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    uint32_t slot = (timer->expires >> (TIMER_WHEEL_BITS * level)) & TW_MASK;
+    tw_list_append(&wheel->slots[level][slot], timer);
+}
+
+void timer_wheel_schedule(timer_wheel_t *wheel, tw_timer_t *timer, uint32_t delay_ticks)
+{
+    if (tw_timer_pending(timer)) {
+        tw_list_unlink(timer);
+        wheel->pending--;
+    }
+
+    if (delay_ticks == 0) {
+        delay_ticks = 1;
+    } else if (delay_ticks >= TW_HORIZON) {
+        delay_ticks = TW_HORIZON - 1;
+    }
+
+    timer->expires = wheel->now + delay_ticks;
+    tw_insert(wheel, timer);
+    wheel->pending++;
+}
+
+void timer_wheel_cancel(timer_wheel_t *wheel, tw_timer_t *timer)
+{
+    if (tw_timer_pending(timer)) {
+        tw_list_unlink(timer);
+        wheel->pending--;
+    }
+}
+
+static void tw_cascade(timer_wheel_t *wheel, int level)
+{
+    /*
+    @brief Redistribui o slot atual de um nível superior nos níveis inferiores.
+    */
+    uint32_t slot = (wheel->now >> (TIMER_WHEEL_BITS * level)) & TW_MASK;
+    tw_timer_t *head = &wheel->slots[level][slot];
+
+    while (head->next != head) {
+        tw_timer_t *timer = head->next;
+        tw_list_unlink(timer);
+        tw_insert(wheel, timer);
+    }
+}
+
+uint32_t timer_wheel_advance(timer_wheel_t *wheel, uint32_t target)
+{
+    uint32_t fired = 0;
+
+    while ((int32_t)(target - wheel->now) > 0) {
+        wheel->now++;
+
+        // Ao completar uma volta de um nível, traz o próximo slot do nível acima
+        for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            if ((wheel->now & (((uint32_t)1 << (TIMER_WHEEL_BITS * level)) - 1)) != 0) {
+                break;
+            }
+            tw_cascade(wheel, level);
+        }
+
+        if (wheel->pending == 0) {
+            // Nada agendado: salta direto para o alvo
+            wheel->now = target;
+            break;
+        }
+
+        tw_timer_t *head = &wheel->slots[0][wheel->now & TW_MASK];
+        while (head->next != head) {
+            tw_timer_t *timer = head->next;
+            tw_list_unlink(timer);
+            wheel->pending--;
+            fired++;
+            timer->callback(timer, timer->arg);
+        }
+    }
+
+    return fired;
+}
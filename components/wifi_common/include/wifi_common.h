@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Event bits do gerenciador de conexão (compartilhados por todas as apps)
+#define WIFI_CONNECTED_BIT BIT0
+#define WIFI_FAIL_BIT      BIT1
+
+typedef struct {
+    const char *ssid;
+    const char *password;
+    uint8_t channel;
+    uint8_t max_connection;
+    esp_event_handler_t handler;   // handler da aplicação para WIFI_EVENT (opcional)
+} wifi_common_ap_config_t;
+
+typedef struct {
+    const char *ssid;
+    const char *password;
+    esp_event_handler_t handler;   // handler da aplicação para WIFI_EVENT e IP_EVENT_STA_GOT_IP (opcional)
+    bool start;                    // false: apenas configura o modo STA (a app chama esp_wifi_start)
+} wifi_common_sta_config_t;
+
+// NVS com a mesma política de recuperação em todas as apps
+void wifi_common_nvs_init(void);
+
+// Inicialização completa de netif, event loop e driver Wi-Fi
+esp_netif_t *wifi_common_init_ap(const wifi_common_ap_config_t *config);
+esp_netif_t *wifi_common_init_sta(const wifi_common_sta_config_t *config);
+
+// Preenche um wifi_config_t de STA com os parâmetros padrão do projeto (WPA2, PMF capaz)
+void wifi_common_fill_sta_config(wifi_config_t *wifi_config, const char *ssid, const char *password);
+
+// Estado mantido pelo gerenciador de conexão
+EventGroupHandle_t wifi_common_event_group(void);
+EventBits_t wifi_common_wait(EventBits_t bits, bool clear_on_exit, TickType_t timeout);
+bool wifi_common_is_connected(void);
+esp_ip4_addr_t wifi_common_ip(void);
+esp_ip4_addr_t wifi_common_gateway(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,219 @@
+#include <string.h>
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "metrics.h"
+#include "wifi_common.h"
+
+static const char *TAG = "WIFI_COMMON";
+
+static EventGroupHandle_t s_wifi_event_group;
+static volatile bool s_is_connected = false;
+static esp_ip4_addr_t s_ip;
+static esp_ip4_addr_t s_gateway;
+
+static metric_t *m_sta_connected;
+static metric_t *m_sta_disconnected;
+static metric_t *m_sta_got_ip;
+static metric_t *m_sta_last_reason;
+static metric_t *m_ap_sta_connected;
+static metric_t *m_ap_sta_disconnected;
+
+static void connection_manager_handler(void* arg, esp_event_base_t event_base,
+                                       int32_t event_id, void* event_data)
+{
+    /*
+    @brief Handler interno do gerenciador de conexão.
+    @note É registrado antes do handler da aplicação, então quando a app
+    é notificada o estado (conectado, IP, gateway, bits) já está atualizado.
+    @note Políticas (reconectar, desistir, desconectar de propósito) ficam
+    com a aplicação; aqui só se mantém estado e métricas comparáveis.
+    */
+    if (event_base == WIFI_EVENT) {
+        switch (event_id) {
+        case WIFI_EVENT_STA_CONNECTED:
+            metric_inc(m_sta_connected);
+            break;
+        case WIFI_EVENT_STA_DISCONNECTED: {
+            wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
+            s_is_connected = false;
+            xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+            metric_inc(m_sta_disconnected);
+            metric_set(m_sta_last_reason, event->reason);
+            break;
+        }
+        case WIFI_EVENT_AP_STACONNECTED:
+            metric_inc(m_ap_sta_connected);
+            break;
+        case WIFI_EVENT_AP_STADISCONNECTED:
+            metric_inc(m_ap_sta_disconnected);
+            break;
+        default:
+            break;
+        }
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+        s_ip = event->ip_info.ip;
+        s_gateway = event->ip_info.gw;
+        s_is_connected = true;
+        metric_inc(m_sta_got_ip);
+        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+    }
+}
+
+void wifi_common_nvs_init(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+}
+
+static void wifi_common_driver_init(void)
+{
+    /*
+    @brief Passos comuns a AP e STA: netif, event loop, driver e métricas.
+    */
+    s_wifi_event_group = xEventGroupCreate();
+
+    m_sta_connected = metrics_counter("wifi_sta_connected_total", "Associacoes da STA concluidas");
+    m_sta_disconnected = metrics_counter("wifi_sta_disconnected_total", "Desconexoes da STA");
+    m_sta_got_ip = metrics_counter("wifi_sta_got_ip_total", "Enderecos IP obtidos pela STA");
+    m_sta_last_reason = metrics_gauge("wifi_sta_last_disconnect_reason", "Ultimo reason code de desconexao");
+    m_ap_sta_connected = metrics_counter("wifi_ap_sta_connected_total", "Estacoes associadas ao AP");
+    m_ap_sta_disconnected = metrics_counter("wifi_ap_sta_disconnected_total", "Estacoes desassociadas do AP");
+
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+}
+
+static void wifi_common_register_handlers(esp_event_handler_t app_handler, bool sta)
+{
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
+                                                        ESP_EVENT_ANY_ID,
+                                                        &connection_manager_handler,
+                                                        NULL,
+                                                        NULL));
+    if (sta) {
+        ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
+                                                            IP_EVENT_STA_GOT_IP,
+                                                            &connection_manager_handler,
+                                                            NULL,
+                                                            NULL));
+    }
+
+    if (app_handler == NULL) {
+        return;
+    }
+
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
+                                                        ESP_EVENT_ANY_ID,
+                                                        app_handler,
+                                                        NULL,
+                                                        NULL));
+    if (sta) {
+        ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
+                                                            IP_EVENT_STA_GOT_IP,
+                                                            app_handler,
+                                                            NULL,
+                                                            NULL));
+    }
+}
+
+esp_netif_t *wifi_common_init_ap(const wifi_common_ap_config_t *config)
+{
+    wifi_common_driver_init();
+
+    esp_netif_t *netif = esp_netif_create_default_wifi_ap();
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+
+    wifi_common_register_handlers(config->handler, false);
+
+    wifi_config_t wifi_config = {
+        .ap = {
+            .channel = config->channel,
+            .max_connection = config->max_connection,
+            .authmode = WIFI_AUTH_WPA2_PSK,
+            .pmf_cfg = {
+                .required = false,
+            },
+        },
+    };
+    strlcpy((char *)wifi_config.ap.ssid, config->ssid, sizeof(wifi_config.ap.ssid));
+    strlcpy((char *)wifi_config.ap.password, config->password, sizeof(wifi_config.ap.password));
+    wifi_config.ap.ssid_len = strlen(config->ssid);
+
+    if (strlen(config->password) == 0) {
+        wifi_config.ap.authmode = WIFI_AUTH_OPEN;
+    }
+
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_start());
+
+    ESP_LOGI(TAG, "AP configurado - SSID: %s, Canal: %d", config->ssid, config->channel);
+    return netif;
+}
+
+void wifi_common_fill_sta_config(wifi_config_t *wifi_config, const char *ssid, const char *password)
+{
+    memset(wifi_config, 0, sizeof(*wifi_config));
+    strlcpy((char *)wifi_config->sta.ssid, ssid, sizeof(wifi_config->sta.ssid));
+    strlcpy((char *)wifi_config->sta.password, password, sizeof(wifi_config->sta.password));
+    wifi_config->sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    wifi_config->sta.pmf_cfg.capable = true;
+    wifi_config->sta.pmf_cfg.required = false;
+}
+
+esp_netif_t *wifi_common_init_sta(const wifi_common_sta_config_t *config)
+{
+    wifi_common_driver_init();
+
+    esp_netif_t *netif = esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+
+    wifi_common_register_handlers(config->handler, true);
+
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+
+    if (config->start) {
+        wifi_config_t wifi_config;
+        wifi_common_fill_sta_config(&wifi_config, config->ssid, config->password);
+        ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+        ESP_ERROR_CHECK(esp_wifi_start());
+    }
+
+    ESP_LOGI(TAG, "STA configurada - SSID alvo: %s", config->ssid);
+    return netif;
+}
+
+EventGroupHandle_t wifi_common_event_group(void)
+{
+    return s_wifi_event_group;
+}
+
+EventBits_t wifi_common_wait(EventBits_t bits, bool clear_on_exit, TickType_t timeout)
+{
+    return xEventGroupWaitBits(s_wifi_event_group, bits,
+                               clear_on_exit ? pdTRUE : pdFALSE, pdFALSE, timeout);
+}
+
+bool wifi_common_is_connected(void)
+{
+    return s_is_connected;
+}
+
+esp_ip4_addr_t wifi_common_ip(void)
+{
+    return s_ip;
+}
+
+esp_ip4_addr_t wifi_common_gateway(void)
+{
+    return s_gateway;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Reconexão da STA que nunca desiste: cada queda agenda um esp_wifi_connect()
+ * com backoff exponencial e jitter (metade fixa, metade aleatória), do
+ * backoff_base_ms até backoff_max_ms, e volta ao início quando o IP é obtido.
+ *
+ * O BSSID e o canal da última associação ficam em cache e são fixados na
+ * configuração da STA (fast connect, sem varredura). Depois de
+ * fast_connect_max_failures tentativas seguidas sem associar, o cache é
+ * descartado e a STA volta a varrer os canais (o AP pode ter mudado de canal).
+ *
+ * Quedas com reason codes típicos de deauth forjado, ou em rajada, são
+ * contadas como suspeitas. O tempo entre a queda e o novo IP vai para o
+ * histograma wifi_reconnect_recovery_ms.
+ */
+
+#define WIFI_RECONNECT_BURST_COUNT 3            // quedas associadas dentro da janela = rajada
+#define WIFI_RECONNECT_BURST_WINDOW_MS 10000
+
+typedef struct {
+    const char *ssid;
+    const char *password;
+    uint32_t backoff_base_ms;
+    uint32_t backoff_max_ms;
+    uint8_t fast_connect_max_failures;
+} wifi_reconnect_config_t;
+
+// Depois de wifi_common_init_sta(.start = false): aplica a configuração, registra os handlers e inicia o Wi-Fi
+esp_err_t wifi_reconnect_start(const wifi_reconnect_config_t *config);
+
+// Reason codes de desconexão típicos de deauth/disassoc forjados
+bool wifi_reconnect_reason_suspicious(uint8_t reason);
+
+// Tentativas, cache do fast connect e tempos de recuperação
+void wifi_reconnect_log(const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
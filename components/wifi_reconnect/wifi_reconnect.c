@@ -0,0 +1,228 @@
+#include <string.h>
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "metrics.h"
+#include "wifi_common.h"
+#include "wifi_reconnect.h"
+
+static const char *TAG = "WIFI_RECONNECT";
+
+// Estado só alterado no event loop (sys_evt); o timer apenas chama esp_wifi_connect()
+static wifi_reconnect_config_t s_config;
+static esp_timer_handle_t s_retry_timer;
+static uint32_t s_attempt = 0;              // tentativas desde o último IP
+static uint32_t s_last_backoff_ms = 0;
+static bool s_associated = false;
+static int64_t s_outage_start_us = 0;       // 0 = sem queda em andamento
+
+// Cache do fast connect
+static bool s_cache_valid = false;
+static bool s_cache_in_use = false;
+static uint8_t s_cache_bssid[6];
+static uint8_t s_cache_channel;
+static uint8_t s_fast_failures = 0;
+
+// Rajada: instantes das últimas quedas com a STA associada
+static int64_t s_drop_times_us[WIFI_RECONNECT_BURST_COUNT];
+static uint8_t s_drop_index = 0;
+
+static metric_t *m_attempts;
+static metric_t *m_suspicious;
+static metric_t *m_fast_connects;
+static metric_t *m_cache_invalidations;
+static metric_t *m_recovery_ms;
+
+static const uint32_t recovery_bounds_ms[] = {100, 200, 500, 1000, 2000, 5000, 10000, 20000, 60000};
+#define RECOVERY_BUCKETS (sizeof(recovery_bounds_ms) / sizeof(recovery_bounds_ms[0]))
+
+bool wifi_reconnect_reason_suspicious(uint8_t reason)
+{
+    /*
+    @brief Reason codes usados por ferramentas de deauth (aireplay-ng usa 7 por padrão).
+    @note Com PMF negociado o driver descarta deauth sem proteção e estes códigos
+    deixam de aparecer para quedas forjadas.
+    */
+    switch (reason) {
+    case WIFI_REASON_UNSPECIFIED:
+    case WIFI_REASON_CLASS2_FRAME_FROM_NONAUTH_STA:
+    case WIFI_REASON_CLASS3_FRAME_FROM_NONASSOC_STA:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void reconnect_apply_config(void)
+{
+    // Com cache: BSSID e canal fixos, sem varredura; sem cache: varredura pelo SSID
+    wifi_config_t wifi_config;
+    wifi_common_fill_sta_config(&wifi_config, s_config.ssid, s_config.password);
+
+    s_cache_in_use = s_cache_valid;
+    if (s_cache_in_use) {
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, s_cache_bssid, 6);
+        wifi_config.sta.channel = s_cache_channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    }
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+}
+
+static void reconnect_timer_cb(void *arg)
+{
+    // Sem evento de desconexão para uma chamada recusada: tenta de novo no teto do backoff
+    if (esp_wifi_connect() != ESP_OK) {
+        esp_timer_start_once(s_retry_timer, (uint64_t)s_config.backoff_max_ms * 1000);
+    }
+}
+
+static uint32_t reconnect_backoff_ms(void)
+{
+    /*
+    @brief Backoff exponencial com jitter: metade da janela fixa e metade aleatória.
+    @note A parte fixa evita rajadas de tentativas; a aleatória evita que vários
+    clientes derrubados pelo mesmo deauth reconectem em sincronia.
+    */
+    uint32_t shift = s_attempt < 16 ? s_attempt : 16;
+    uint64_t window = (uint64_t)s_config.backoff_base_ms << shift;
+    if (window > s_config.backoff_max_ms) {
+        window = s_config.backoff_max_ms;
+    }
+    uint32_t half = (uint32_t)window / 2;
+    return half + esp_random() % (half + 1);
+}
+
+static bool reconnect_burst(int64_t now_us)
+{
+    // Janela deslizante das últimas WIFI_RECONNECT_BURST_COUNT quedas
+    int64_t oldest = s_drop_times_us[s_drop_index];
+    s_drop_times_us[s_drop_index] = now_us;
+    s_drop_index = (s_drop_index + 1) % WIFI_RECONNECT_BURST_COUNT;
+    return oldest != 0 && now_us - oldest <= (int64_t)WIFI_RECONNECT_BURST_WINDOW_MS * 1000;
+}
+
+static void reconnect_on_disconnect(const wifi_event_sta_disconnected_t *event)
+{
+    int64_t now_us = esp_timer_get_time();
+    bool was_associated = s_associated;
+    s_associated = false;
+
+    if (was_associated) {
+        if (s_outage_start_us == 0) {
+            s_outage_start_us = now_us;
+        }
+        bool burst = reconnect_burst(now_us);
+        if (wifi_reconnect_reason_suspicious(event->reason) || burst) {
+            metric_inc(m_suspicious);
+            ESP_LOGW(TAG, "Queda suspeita (reason %d%s) - possivel deauth forjado",
+                     event->reason, burst ? ", rajada" : "");
+        }
+    } else if (s_cache_in_use && ++s_fast_failures >= s_config.fast_connect_max_failures) {
+        // O AP pode ter mudado de canal ou de BSSID
+        s_cache_valid = false;
+        s_fast_failures = 0;
+        metric_inc(m_cache_invalidations);
+        ESP_LOGI(TAG, "Fast connect falhou %d vezes - voltando a varredura completa",
+                 s_config.fast_connect_max_failures);
+    }
+
+    s_last_backoff_ms = reconnect_backoff_ms();
+    s_attempt++;
+    metric_inc(m_attempts);
+    reconnect_apply_config();
+
+    esp_timer_stop(s_retry_timer);
+    esp_timer_start_once(s_retry_timer, (uint64_t)s_last_backoff_ms * 1000);
+    ESP_LOGI(TAG, "Reconexao %lu em %lu ms (reason %d, %s)", (unsigned long)s_attempt,
+             (unsigned long)s_last_backoff_ms, event->reason, s_cache_in_use ? "fast connect" : "varredura");
+}
+
+static void reconnect_event_handler(void* arg, esp_event_base_t event_base,
+                                    int32_t event_id, void* event_data)
+{
+    /*
+    @brief Política de reconexão (o estado da conexão fica em wifi_common).
+    */
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        reconnect_apply_config();
+        esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t *)event_data;
+        s_associated = true;
+        s_fast_failures = 0;
+        if (s_cache_in_use) {
+            metric_inc(m_fast_connects);
+        }
+        memcpy(s_cache_bssid, event->bssid, 6);
+        s_cache_channel = event->channel;
+        s_cache_valid = true;
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        reconnect_on_disconnect((wifi_event_sta_disconnected_t *)event_data);
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        if (s_outage_start_us != 0) {
+            uint32_t recovery_ms = (uint32_t)((esp_timer_get_time() - s_outage_start_us) / 1000);
+            metric_observe(m_recovery_ms, recovery_ms);
+            ESP_LOGI(TAG, "Conexao recuperada em %lu ms apos %lu tentativas",
+                     (unsigned long)recovery_ms, (unsigned long)s_attempt);
+        }
+        s_outage_start_us = 0;
+        s_attempt = 0;
+    }
+}
+
+esp_err_t wifi_reconnect_start(const wifi_reconnect_config_t *config)
+{
+    if (config->backoff_base_ms == 0 || config->backoff_max_ms < config->backoff_base_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_config = *config;
+    if (s_config.fast_connect_max_failures == 0) {
+        s_config.fast_connect_max_failures = 1;
+    }
+
+    m_attempts = metrics_counter("wifi_reconnect_attempts_total", "Tentativas de reconexao agendadas");
+    m_suspicious = metrics_counter("wifi_reconnect_suspicious_total", "Quedas com reason code suspeito ou em rajada");
+    m_fast_connects = metrics_counter("wifi_reconnect_fast_connects_total", "Associacoes pelo BSSID/canal em cache");
+    m_cache_invalidations = metrics_counter("wifi_reconnect_cache_invalidations_total", "Fast connect abandonado por falhas");
+    m_recovery_ms = metrics_histogram("wifi_reconnect_recovery_ms", "Tempo da queda ate o novo IP (ms)",
+                                      recovery_bounds_ms, RECOVERY_BUCKETS);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = reconnect_timer_cb,
+        .name = "wifi_reconnect",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_retry_timer));
+
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID,
+                                                        &reconnect_event_handler, NULL, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP,
+                                                        &reconnect_event_handler, NULL, NULL));
+
+    return esp_wifi_start();
+}
+
+void wifi_reconnect_log(const char *tag)
+{
+    /*
+    @brief Resumo da política de reconexão.
+    @note Leitura sem lock do estado do event loop: apenas informativa.
+    */
+    uint32_t recoveries = m_recovery_ms ? m_recovery_ms->count : 0;
+    uint32_t recovery_sum = m_recovery_ms ? m_recovery_ms->sum : 0;
+
+    ESP_LOGI(tag, "Reconexao: tentativa atual %lu, ultimo backoff %lu ms, suspeitas %ld",
+             (unsigned long)s_attempt, (unsigned long)s_last_backoff_ms, (long)metric_value(m_suspicious));
+    if (s_cache_valid) {
+        ESP_LOGI(tag, "Fast connect: BSSID %02x:%02x:%02x:%02x:%02x:%02x, canal %d (%ld associacoes pelo cache)",
+                 s_cache_bssid[0], s_cache_bssid[1], s_cache_bssid[2],
+                 s_cache_bssid[3], s_cache_bssid[4], s_cache_bssid[5],
+                 s_cache_channel, (long)metric_value(m_fast_connects));
+    }
+    if (recoveries > 0) {
+        ESP_LOGI(tag, "Recuperacoes: %lu, tempo medio %lu ms", (unsigned long)recoveries,
+                 (unsigned long)(recovery_sum / recoveries));
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_wifi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Callback promíscuo único do Wi-Fi, repassado a vários consumidores (captura,
+ * IDS, rastreador de beacons...). Os consumidores rodam dentro da task do Wi-Fi:
+ * precisam ser curtos, sem bloqueio e sem alocação.
+ */
+#define WIFI_SNIFFER_MAX_LISTENERS 4
+
+typedef void (*wifi_sniffer_cb_t)(const wifi_promiscuous_pkt_t *pkt, wifi_promiscuous_pkt_type_t type, void *ctx);
+
+// Registro (caminho frio): antes de wifi_sniffer_start()
+esp_err_t wifi_sniffer_register(wifi_sniffer_cb_t cb, void *ctx);
+
+// Liga o modo promíscuo na interface já iniciada (ex.: WIFI_PROMIS_FILTER_MASK_MGMT)
+esp_err_t wifi_sniffer_start(uint32_t filter_mask);
+void wifi_sniffer_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+#include "esp_log.h"
+#include "metrics.h"
+#include "wifi_sniffer.h"
+
+static const char *TAG = "WIFI_SNIFFER";
+
+typedef struct {
+    wifi_sniffer_cb_t cb;
+    void *ctx;
+} sniffer_listener_t;
+
+static sniffer_listener_t s_listeners[WIFI_SNIFFER_MAX_LISTENERS];
+static int s_listener_count = 0;
+static bool s_running = false;
+
+static metric_t *m_frames;
+
+static void wifi_sniffer_rx_cb(void *buf, wifi_promiscuous_pkt_type_t type)
+{
+    /*
+    @brief Callback promíscuo registrado no driver; repassa o quadro a cada consumidor.
+    @note A lista de consumidores só muda com o sniffer parado, então é lida sem lock.
+    */
+    const wifi_promiscuous_pkt_t *pkt = (const wifi_promiscuous_pkt_t *)buf;
+
+    metric_inc(m_frames);
+    for (int i = 0; i < s_listener_count; i++) {
+        s_listeners[i].cb(pkt, type, s_listeners[i].ctx);
+    }
+}
+
+esp_err_t wifi_sniffer_register(wifi_sniffer_cb_t cb, void *ctx)
+{
+    if (s_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_listener_count >= WIFI_SNIFFER_MAX_LISTENERS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_listeners[s_listener_count].cb = cb;
+    s_listeners[s_listener_count].ctx = ctx;
+    s_listener_count++;
+    return ESP_OK;
+}
+
+esp_err_t wifi_sniffer_start(uint32_t filter_mask)
+{
+    /*
+    @brief Liga o modo promíscuo com o filtro pedido.
+    @note Em modo AP o rádio continua servindo as estações; o sniffer só enxerga o
+    canal atual do AP.
+    */
+    if (s_running) {
+        return ESP_OK;
+    }
+
+    m_frames = metrics_counter("wifi_sniffer_frames_total", "Quadros recebidos pelo callback promiscuo");
+
+    wifi_promiscuous_filter_t filter = {
+        .filter_mask = filter_mask,
+    };
+    ESP_ERROR_CHECK(esp_wifi_set_promiscuous_filter(&filter));
+    ESP_ERROR_CHECK(esp_wifi_set_promiscuous_rx_cb(wifi_sniffer_rx_cb));
+    ESP_ERROR_CHECK(esp_wifi_set_promiscuous(true));
+    s_running = true;
+
+    ESP_LOGI(TAG, "Modo promiscuo ativo (filtro 0x%lx, %d consumidores)",
+             (unsigned long)filter_mask, s_listener_count);
+    return ESP_OK;
+}
+
+void wifi_sniffer_stop(void)
+{
+    if (!s_running) {
+        return;
+    }
+    esp_wifi_set_promiscuous(false);
+    s_running = false;
+}
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+Gera a allowlist de estações confiáveis do AP como uma tabela de hash perfeito.
+
+Entrada: um MAC por linha (aa:bb:cc:dd:ee:ff ou aa-bb-...), '#' inicia comentário.
+Saída: um header C com a tabela e os parâmetros do hash, incluído só por
+AP/main/allowlist.c:
+
+    slot = (chave * TRUSTED_HASH_MULT) >> TRUSTED_HASH_SHIFT
+
+A chave é a mesma do IDS e do filtro de entrada, (1 << 48) | MAC, nunca zero;
+slots vazios valem 0. O multiplicador é procurado aqui (determinístico, semente
+fixa) até não haver colisões, dobrando a tabela se preciso: no firmware a
+consulta é uma multiplicação, um shift e uma comparação, sem sondagem.
+
+Rodado pelo build (AP/main/CMakeLists.txt) sempre que a lista muda:
+
+    python3 tools/allowlist/gen_allowlist.py AP/trusted_stations.txt -o trusted_stations_table.h
+"""
+import argparse
+import random
+import re
+import sys
+
+MAC_RE = re.compile(r"^([0-9a-fA-F]{2})([:-][0-9a-fA-F]{2}){5}$")
+MASK64 = (1 << 64) - 1
+TRIES_PER_SIZE = 200000
+
+
+def parse_list(path):
+    macs = []
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            text = line.split("#", 1)[0].strip()
+            if not text:
+                continue
+            if not MAC_RE.match(text):
+                sys.exit("%s:%d: MAC invalido: %r" % (path, lineno, text))
+            mac = bytes(int(b, 16) for b in re.split("[:-]", text))
+            if mac in macs:
+                sys.exit("%s:%d: MAC repetido: %s" % (path, lineno, text))
+            macs.append(mac)
+    return macs
+
+
+def mac_key(mac):
+    return (1 << 48) | int.from_bytes(mac, "big")
+
+
+def find_hash(keys):
+    # Tabela potência de 2 com ao menos o dobro das chaves (e 2 slots); cresce se a busca falhar
+    bits = 1
+    while (1 << bits) < 2 * max(len(keys), 1):
+        bits += 1
+    rng = random.Random(0x5eed)
+    while bits <= 16:
+        shift = 64 - bits
+        for _ in range(TRIES_PER_SIZE):
+            mult = rng.getrandbits(64) | 1
+            slots = {((k * mult) & MASK64) >> shift for k in keys}
+            if len(slots) == len(keys):
+                return bits, mult
+        bits += 1
+    sys.exit("nenhum hash perfeito encontrado para %d chaves" % len(keys))
+
+
+def render(source, macs, bits, mult):
+    size = 1 << bits
+    shift = 64 - bits
+    table = [0] * size
+    owner = [None] * size
+    for mac in macs:
+        key = mac_key(mac)
+        slot = ((key * mult) & MASK64) >> shift
+        table[slot] = key
+        owner[slot] = mac
+
+    out = [
+        "// Gerado por tools/allowlist/gen_allowlist.py a partir de %s - nao editar" % source,
+        "#pragma once",
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define TRUSTED_COUNT %d" % len(macs),
+        "#define TRUSTED_TABLE_SIZE %d" % size,
+        "#define TRUSTED_HASH_MULT 0x%016xULL" % mult,
+        "#define TRUSTED_HASH_SHIFT %d" % shift,
+        "",
+        "static const uint64_t trusted_table[TRUSTED_TABLE_SIZE] = {",
+    ]
+    for key, mac in zip(table, owner):
+        comment = "  // " + ":".join("%02x" % b for b in mac) if mac else ""
+        out.append("    0x%016xULL,%s" % (key, comment))
+    out.append("};")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("list", help="arquivo com um MAC por linha")
+    parser.add_argument("-o", "--output", required=True, help="header gerado")
+    args = parser.parse_args()
+
+    macs = parse_list(args.list)
+    bits, mult = find_hash([mac_key(m) for m in macs])
+    text = render(args.list.replace("\\", "/").split("/")[-1], macs, bits, mult)
+
+    with open(args.output, "w") as f:
+        f.write(text)
+    print("allowlist: %d MACs em %d slots (mult 0x%016x)" % (len(macs), 1 << bits, mult), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,38 @@
+#!/bin/bash
+# Compila, grava e mede o AP em cada perfil de buffers (AP/profiles/sdkconfig.*).
+#
+# Pré-requisitos: ambiente do ESP-IDF carregado (idf.py no PATH), AP na porta
+# serial PORT e este computador configurado para se reconectar à rede ESP32_AP.
+#
+#   tools/bench/run_profiles.sh /dev/ttyUSB0 [lowmem balanced throughput]
+set -e
+
+PORT=${1:?uso: $0 <porta-serial> [perfis...]}
+shift
+PROFILES=${*:-lowmem balanced throughput}
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+RESULTS=${RESULTS:-$ROOT/bench_profiles.csv}
+
+# Durante a medição os limites anti-flood não podem confundir vazão com ataque,
+# e o relatório BENCH sai a cada 10 s em vez de 60 s
+BENCH_DEFINES="MAX_PACKETS_PER_CLIENT=100000;ADMISSION_MAX_CONN_PER_WINDOW=100000;STATUS_LOG_INTERVAL_MS=10000"
+# Uma conexão por mensagem com eco de ~200 B: os limites de atividade por cliente (0 = desligado)
+BENCH_DEFINES="$BENCH_DEFINES;MAX_CONNECTIONS_PER_CLIENT=0;MAX_EMPTY_CONNECTIONS_PER_CLIENT=0;MAX_BYTES_IN_PER_CLIENT=0;MAX_BYTES_OUT_PER_CLIENT=0;MAX_RECV_ERRORS_PER_CLIENT=0"
+
+for profile in $PROFILES; do
+    build="$ROOT/AP/build_$profile"
+    echo "=== Perfil $profile ==="
+    # SDKCONFIG separado por perfil: o sdkconfig versionado do AP não é tocado
+    idf.py -C "$ROOT/AP" -B "$build" -p "$PORT" \
+        -DSDKCONFIG="$build/sdkconfig" \
+        -DSDKCONFIG_DEFAULTS="sdkconfig.defaults;profiles/sdkconfig.$profile" \
+        -DAP_EXTRA_DEFINES="$BENCH_DEFINES" \
+        build flash
+
+    echo "Aguardando o AP subir e o host reassociar..."
+    sleep 20
+    python3 "$ROOT/tools/bench/tcp_load.py" --profile "$profile" --serial "$PORT" --csv "$RESULTS"
+done
+
+echo "Resultados em $RESULTS"
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+Gerador de carga para o servidor TCP do AP (porta 3333) e coletor das linhas
+"BENCH" impressas pelo firmware no UART.
+
+Roda em um computador conectado à rede ESP32_AP. Cada worker repete o ciclo do
+CLIENTS (conecta, envia uma mensagem, espera o eco, fecha) o mais rápido
+possível; ao final imprime mensagens/s e latência vistos pelo cliente e, com
+--serial, heap livre, maior bloco livre e mensagens/s vistos pelo AP.
+
+    python3 tools/bench/tcp_load.py --profile balanced --serial /dev/ttyUSB0 --csv bench.csv
+"""
+import argparse
+import csv
+import os
+import re
+import socket
+import threading
+import time
+
+BENCH_RE = re.compile(r"BENCH (.*)$")
+
+
+def worker(args, stop, results, lock):
+    payload = (b"bench " * 64)[: args.size]
+    ok, errors, latencies = 0, 0, []
+    while not stop.is_set():
+        start = time.perf_counter()
+        try:
+            with socket.create_connection((args.host, args.port), timeout=args.timeout) as sock:
+                sock.sendall(payload)
+                if not sock.recv(512):
+                    raise ConnectionError("conexao fechada sem resposta")
+            latencies.append((time.perf_counter() - start) * 1000)
+            ok += 1
+        except OSError:
+            errors += 1
+            time.sleep(0.05)
+    with lock:
+        results["ok"] += ok
+        results["errors"] += errors
+        results["latencies"].extend(latencies)
+
+
+def serial_reader(port, baud, stop, bench_lines):
+    import serial  # pyserial, já instalado no ambiente do ESP-IDF
+
+    ser = serial.Serial()
+    ser.port = port
+    ser.baudrate = baud
+    ser.timeout = 0.5
+    # Abrir a porta com DTR/RTS ativos reinicia o ESP32
+    ser.dtr = False
+    ser.rts = False
+    ser.open()
+    while not stop.is_set():
+        line = ser.readline().decode(errors="replace").strip()
+        match = BENCH_RE.search(line)
+        if match:
+            fields = dict(kv.split("=", 1) for kv in match.group(1).split())
+            bench_lines.append((time.time(), fields))
+    ser.close()
+
+
+def percentile(values, pct):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * pct / 100))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="192.168.4.1")
+    parser.add_argument("--port", type=int, default=3333)
+    parser.add_argument("--workers", type=int, default=2)
+    parser.add_argument("--duration", type=float, default=30.0, help="segundos de carga")
+    parser.add_argument("--size", type=int, default=100, help="bytes por mensagem (o AP lê até 127)")
+    parser.add_argument("--timeout", type=float, default=5.0)
+    parser.add_argument("--serial", help="porta serial do AP para ler as linhas BENCH")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--settle", type=float, default=15.0,
+                        help="segundos esperando a próxima linha BENCH após a carga")
+    parser.add_argument("--profile", default="custom", help="nome do perfil (coluna do CSV)")
+    parser.add_argument("--csv", help="acrescenta uma linha de resultado a este arquivo")
+    args = parser.parse_args()
+
+    stop_serial = threading.Event()
+    bench_lines = []
+    if args.serial:
+        threading.Thread(target=serial_reader, args=(args.serial, args.baud, stop_serial, bench_lines),
+                         daemon=True).start()
+
+    stop = threading.Event()
+    lock = threading.Lock()
+    results = {"ok": 0, "errors": 0, "latencies": []}
+    threads = [threading.Thread(target=worker, args=(args, stop, results, lock)) for _ in range(args.workers)]
+    load_start = time.time()
+    for t in threads:
+        t.start()
+    time.sleep(args.duration)
+    stop.set()
+    for t in threads:
+        t.join()
+    load_end = time.time()
+
+    ap = {}
+    if args.serial:
+        # A primeira linha depois da carga cobre (parte de) a janela medida
+        deadline = time.time() + args.settle
+        while time.time() < deadline and not any(ts > load_end for ts, _ in bench_lines):
+            time.sleep(0.2)
+        stop_serial.set()
+        during = [f for ts, f in bench_lines if ts > load_start]
+        if during:
+            ap = dict(during[-1])
+            ap["msgs_per_s"] = max(float(f.get("msgs_per_s", 0)) for f in during)
+
+    row = {
+        "profile": args.profile,
+        "client_msgs_per_s": round(results["ok"] / (load_end - load_start), 1),
+        "errors": results["errors"],
+        "p50_ms": round(percentile(results["latencies"], 50), 1),
+        "p99_ms": round(percentile(results["latencies"], 99), 1),
+        "ap_msgs_per_s": ap.get("msgs_per_s", ""),
+        "heap_free": ap.get("heap_free", ""),
+        "heap_min": ap.get("heap_min", ""),
+        "largest_block": ap.get("largest_block", ""),
+    }
+
+    for key, value in row.items():
+        print(f"{key:>18}: {value}")
+
+    if args.csv:
+        new_file = not os.path.exists(args.csv)
+        with open(args.csv, "a", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(row))
+            if new_file:
+                writer.writeheader()
+            writer.writerow(row)
+
+
+if __name__ == "__main__":
+    main()
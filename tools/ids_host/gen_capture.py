@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+Gera capturas sintéticas (.pcap, LINKTYPE_IEEE802_11) para o ids_host.
+
+Tráfego de fundo (beacons, auth/assoc e dados de estações legítimas) com
+ataques injetados nos instantes pedidos, no mesmo padrão das apps de ataque:
+
+    python3 tools/ids_host/gen_capture.py -o teste.pcap --duration 60 \\
+        --attack deauth@10 --attack auth@30
+    python3 tools/ids_host/gen_capture.py -o grande.pcap --frames 2000000   # benchmark
+
+Cada ataque dura --attack-secs segundos a --attack-rate quadros/s.
+"""
+import argparse
+import random
+import struct
+
+LINKTYPE_IEEE802_11 = 105
+BSSID = bytes.fromhex("246f28aabbcc")
+BROADCAST = b"\xff" * 6
+
+
+def mac(prefix, n):
+    return bytes([prefix, 0x11, 0x22, (n >> 16) & 0xFF, (n >> 8) & 0xFF, n & 0xFF])
+
+
+def mgmt(subtype, da, sa, bssid, body, seq):
+    fc = struct.pack("<BB", (subtype << 4) | (0 << 2), 0)
+    return fc + struct.pack("<H", 0) + da + sa + bssid + struct.pack("<H", (seq & 0xFFF) << 4) + body
+
+
+def data_to_ds(sta, seq, payload_len):
+    fc = struct.pack("<BB", (0 << 4) | (2 << 2), 0x01)
+    return fc + struct.pack("<H", 0) + BSSID + sta + BSSID + struct.pack("<H", (seq & 0xFFF) << 4) + bytes(payload_len)
+
+
+def beacon(seq):
+    body = struct.pack("<QHH", 0, 100, 0x0431) + b"\x00\x08ESP32_AP"
+    return mgmt(0x8, BROADCAST, BSSID, BSSID, body, seq)
+
+
+def auth_req(sta, seq):
+    return mgmt(0xB, BSSID, sta, BSSID, struct.pack("<HHH", 0, 1, 0), seq)
+
+
+def assoc_req(sta, seq):
+    return mgmt(0x0, BSSID, sta, BSSID, struct.pack("<HH", 0x0431, 10), seq)
+
+
+def deauth(da, sa, seq, reason=7):
+    return mgmt(0xC, da, sa, BSSID, struct.pack("<H", reason), seq)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--duration", type=float, default=60, help="segundos de tráfego de fundo")
+    parser.add_argument("--frames", type=int, default=0, help="para após N quadros (repete o cenário)")
+    parser.add_argument("--stations", type=int, default=8)
+    parser.add_argument("--attack", action="append", default=[],
+                        help="tipo@segundo: deauth, auth ou data (ex.: deauth@10)")
+    parser.add_argument("--attack-secs", type=float, default=3)
+    parser.add_argument("--attack-rate", type=int, default=50, help="quadros/s durante o ataque")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rnd = random.Random(args.seed)
+    stations = [mac(0x3C, i) for i in range(args.stations)]
+    attacks = []
+    for spec in args.attack:
+        kind, _, at = spec.partition("@")
+        attacks.append((kind, float(at or 0)))
+
+    def scenario(base_us):
+        events = []
+        t = 0.0
+        while t < args.duration:
+            events.append((t, beacon(int(t * 10))))
+            t += 0.1024
+        for i, sta in enumerate(stations):
+            join = rnd.uniform(0, 2)
+            events.append((join, auth_req(sta, i)))
+            events.append((join + 0.002, assoc_req(sta, i)))
+            t = join + 0.5
+            while t < args.duration:
+                events.append((t, data_to_ds(sta, int(t * 100), rnd.randint(40, 600))))
+                t += rnd.expovariate(10)
+        for kind, at in attacks:
+            n = int(args.attack_secs * args.attack_rate)
+            for k in range(n):
+                t = at + k / args.attack_rate
+                if kind == "deauth":
+                    # Deauth forjado em nome do AP para uma vítima (como DeauthFlood)
+                    events.append((t, deauth(stations[k % len(stations)], BSSID, k)))
+                elif kind == "auth":
+                    # MACs aleatórios a cada tentativa (como AuthFlood)
+                    events.append((t, auth_req(mac(0x02, rnd.randrange(1 << 24)), k)))
+                elif kind == "data":
+                    events.append((t, data_to_ds(stations[0], k, 64)))
+        events.sort(key=lambda e: e[0])
+        return [(base_us + int(t * 1e6), frame) for t, frame in events]
+
+    written = 0
+    base_us = 1_700_000_000 * 1_000_000
+    with open(args.output, "wb") as out:
+        out.write(struct.pack("<IHHiIII", 0xA1B2C3D4, 2, 4, 0, 0, 65535, LINKTYPE_IEEE802_11))
+        while True:
+            for ts_us, frame in scenario(base_us):
+                out.write(struct.pack("<IIII", ts_us // 1_000_000, ts_us % 1_000_000, len(frame), len(frame)))
+                out.write(frame)
+                written += 1
+                if args.frames and written >= args.frames:
+                    break
+            base_us += int(args.duration * 1e6)
+            if not args.frames or written >= args.frames:
+                break
+    print(f"{written} quadros em {args.output}")
+
+
+if __name__ == "__main__":
+    main()
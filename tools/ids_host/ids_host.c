@@ -0,0 +1,583 @@
+/*
+ * Analisador offline do IDS: executa o núcleo de detecção do AP
+ * (components/ids) sobre capturas .pcap/.pcapng de quadros 802.11.
+ *
+ * Os quadros são traduzidos nos mesmos eventos que o driver entrega ao AP:
+ *   auth (seq 1) da estação     -> ids_station_connected      (auth flood, MAC bloqueado)
+ *   deauth / disassoc            -> ids_station_disconnected   (deauth flood)
+ *   dados ToDS (com --data)      -> ids_client_packet          (packet flood)
+ * e o relógio do IDS anda pelos timestamps da captura.
+ *
+ *   ids_host captura.pcapng
+ *   ids_host --bssid 24:6f:28:aa:bb:cc --max-auth 4 ataque.pcap
+ *   ids_host --quiet --bench 5 grande.pcap
+ *   ids_host --data --threads 2 grande.pcap
+ *
+ * Com --threads N os eventos são lidos primeiro e depois reproduzidos por N
+ * threads, cada uma dona dos shards ids_shard_of(mac) % N (como os workers do
+ * AP, um por núcleo), para medir a vazão do IDS dividido em shards.
+ */
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ids.h"
+#include "ids_dot11.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "pcap_reader.h"
+#include "time_base.h"
+
+// Mesmos limites do AP (AP/main/AP.c); podem ser alterados pela linha de comando
+#define DEFAULT_MAX_DISCONNECTIONS 5
+#define DEFAULT_MAX_AUTH_ATTEMPTS 8
+#define DEFAULT_MAX_PACKETS 30
+#define DEFAULT_RATE_WINDOW_MS 1000
+#define DEFAULT_BLACKLIST_MS 300000
+#define DEFAULT_MONITOR_IDLE_MS 60000
+
+#define LATENCY_BUCKETS 40      // potências de 2 em ns
+
+typedef struct {
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t unparsed;      // curtos demais ou de controle
+    uint64_t auth;
+    uint64_t assoc;
+    uint64_t deauth;
+    uint64_t disassoc;
+    uint64_t beacon;
+    uint64_t other_mgmt;
+    uint64_t data;
+} frame_stats_t;
+
+typedef struct {
+    uint64_t events;
+    uint64_t allowed;
+    uint64_t blocked;
+    uint64_t attacks;
+    uint64_t blacklist_full;   // ataques sem entrada livre na blacklist
+    uint64_t expired;
+    uint64_t latency_ns_total;
+    uint64_t latency_ns_max;
+    uint64_t latency_hist[LATENCY_BUCKETS];
+} ids_run_stats_t;
+
+typedef struct {
+    bool quiet;
+    bool verbose;
+    bool use_data;
+    bool has_bssid;
+    uint8_t bssid[6];
+    int bench_passes;
+    int threads;            // 0 = análise sequencial
+} options_t;
+
+// Evento já decodificado, para o replay em threads
+typedef struct {
+    time_us_t ts_us;
+    uint8_t event;          // ids_dot11_event_t
+    uint8_t mac[6];
+} replay_event_t;
+
+typedef struct {
+    pthread_t thread;
+    replay_event_t *events; // em ordem da captura, só dos shards desta thread
+    size_t count;
+    size_t capacity;
+    ids_run_stats_t run;
+    double secs;
+} replay_worker_t;
+
+static options_t s_opts;
+static ids_run_stats_t s_run;
+static time_us_t s_now_us;       // relógio da captura (µs desde o primeiro quadro)
+static replay_worker_t *s_workers;
+
+static inline uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static bool parse_mac(const char *text, uint8_t *mac)
+{
+    unsigned int b[6];
+    if (sscanf(text, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        mac[i] = (uint8_t)b[i];
+    }
+    return true;
+}
+
+static void ids_unblock_cb(const uint8_t *mac, void *ctx)
+{
+    // Chamado pelas threads do replay: único campo de s_run alterado em paralelo
+    __atomic_fetch_add(&s_run.expired, 1, __ATOMIC_RELAXED);
+    if (s_opts.verbose) {
+        printf("%10.3f s  EXPIROU       %02x:%02x:%02x:%02x:%02x:%02x\n", s_now_us / 1e6,
+               mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    }
+}
+
+static ids_dot11_event_t frame_to_event(const ids_dot11_hdr_t *hdr, frame_stats_t *stats, const uint8_t **station)
+{
+    /*
+    @brief Conta o quadro por tipo e traduz para o evento que o AP receberia (ids_dot11_event).
+    @param station Estação afetada (MAC usado pelo IDS)
+    */
+    if (hdr->type == IDS_DOT11_TYPE_DATA) {
+        stats->data++;
+    } else {
+        switch (hdr->subtype) {
+        case IDS_DOT11_MGMT_AUTH: stats->auth++; break;
+        case IDS_DOT11_MGMT_ASSOC_REQ:
+        case IDS_DOT11_MGMT_REASSOC_REQ: stats->assoc++; break;
+        case IDS_DOT11_MGMT_DEAUTH: stats->deauth++; break;
+        case IDS_DOT11_MGMT_DISASSOC: stats->disassoc++; break;
+        case IDS_DOT11_MGMT_BEACON: stats->beacon++; break;
+        default: stats->other_mgmt++; break;
+        }
+    }
+
+    ids_dot11_event_t event = ids_dot11_event(hdr, station);
+    if (event == IDS_DOT11_EVENT_PACKET && !s_opts.use_data) {
+        return IDS_DOT11_EVENT_NONE;
+    }
+    if (event != IDS_DOT11_EVENT_NONE && s_opts.has_bssid && !ids_dot11_mac_equal(ids_dot11_bssid(hdr), s_opts.bssid)) {
+        return IDS_DOT11_EVENT_NONE;
+    }
+    return event;
+}
+
+static void report_attack(const uint8_t *mac, const ids_result_t *result)
+{
+    const char *action = result->refreshed ? "prazo renovado"
+                         : result->blacklist_full ? "blacklist cheia" : "bloqueado";
+
+    printf("%10.6f s  %-13s %02x:%02x:%02x:%02x:%02x:%02x  %u na janela  intervalo %u us  %s\n",
+           s_now_us / 1e6, ids_attack_name(result->attack), mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+           result->count, result->interval_us, action);
+}
+
+static void record_latency(ids_run_stats_t *run, uint64_t ns)
+{
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && (1ull << bucket) < ns) {
+        bucket++;
+    }
+    run->latency_hist[bucket]++;
+    run->latency_ns_total += ns;
+    if (ns > run->latency_ns_max) {
+        run->latency_ns_max = ns;
+    }
+}
+
+static ids_result_t feed_event(ids_run_stats_t *run, ids_dot11_event_t event, const uint8_t *station, time_us_t now_us)
+{
+    // Um evento no núcleo do IDS, com latência e veredito contados em run
+    uint64_t start = now_ns();
+    ids_result_t result;
+    if (event == IDS_DOT11_EVENT_CONNECT) {
+        result = ids_station_connected(station, now_us);
+    } else if (event == IDS_DOT11_EVENT_DISCONNECT) {
+        result = ids_station_disconnected(station, now_us);
+    } else {
+        result = ids_client_packet(station, 0, now_us);     // só cabeçalhos: sem pontuação de conteúdo
+    }
+    record_latency(run, now_ns() - start);
+    run->events++;
+
+    if (result.verdict == IDS_VERDICT_ATTACK) {
+        run->attacks++;
+        if (result.blacklist_full) {
+            run->blacklist_full++;
+        }
+    } else if (result.verdict == IDS_VERDICT_BLOCKED) {
+        run->blocked++;
+    } else {
+        run->allowed++;
+    }
+    return result;
+}
+
+static void replay_append(ids_dot11_event_t event, const uint8_t *station, time_us_t ts_us)
+{
+    replay_worker_t *worker = &s_workers[ids_shard_of(station) % s_opts.threads];
+    if (worker->count == worker->capacity) {
+        worker->capacity = worker->capacity ? worker->capacity * 2 : 4096;
+        worker->events = realloc(worker->events, worker->capacity * sizeof(*worker->events));
+        if (worker->events == NULL) {
+            fprintf(stderr, "sem memoria para o replay\n");
+            exit(1);
+        }
+    }
+    replay_event_t *e = &worker->events[worker->count++];
+    e->ts_us = ts_us;
+    e->event = (uint8_t)event;
+    memcpy(e->mac, station, 6);
+}
+
+static uint64_t latency_percentile(double p)
+{
+    // Limite superior do bucket que contém o percentil
+    uint64_t target = (uint64_t)(s_run.events * p);
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += s_run.latency_hist[b];
+        if (seen > target) {
+            return 1ull << b;
+        }
+    }
+    return s_run.latency_ns_max;
+}
+
+static void analyze(pcap_reader_t *readers, int n_readers, frame_stats_t *stats)
+{
+    /*
+    @brief Passada única pelas capturas, alimentando o núcleo do IDS.
+    @note O tempo do IDS é o da captura (µs desde o primeiro quadro, no relógio
+    manual da time_base), mantido
+    monotônico entre arquivos e registros fora de ordem.
+    @note Com --threads os eventos só são guardados, por thread dona, para replay_run().
+    */
+    uint64_t t0_us = 0;
+    bool started = false;
+
+    for (int i = 0; i < n_readers; i++) {
+        pcap_frame_t frame;
+        while (pcap_reader_next(&readers[i], &frame)) {
+            stats->frames++;
+            stats->bytes += frame.len;
+
+            if (!started) {
+                t0_us = frame.ts_us;
+                started = true;
+            }
+            time_us_t ts_us = frame.ts_us > t0_us ? (time_us_t)(frame.ts_us - t0_us) : 0;
+            if (ts_us > s_now_us) {
+                s_now_us = ts_us;
+                time_base_mock_set(s_now_us);
+                if (s_opts.threads == 0) {
+                    ids_advance(s_now_us);
+                }
+            }
+
+            ids_dot11_hdr_t hdr;
+            if (!ids_dot11_parse(frame.data, frame.len, &hdr)) {
+                stats->unparsed++;
+                continue;
+            }
+
+            const uint8_t *station = NULL;
+            ids_dot11_event_t event = frame_to_event(&hdr, stats, &station);
+            if (event == IDS_DOT11_EVENT_NONE) {
+                continue;
+            }
+
+            if (s_opts.threads > 0) {
+                replay_append(event, station, s_now_us);
+                continue;
+            }
+
+            ids_result_t result = feed_event(&s_run, event, station, s_now_us);
+            // Renovações e recusas por blacklist cheia só com --verbose (uma por evento)
+            if (result.verdict == IDS_VERDICT_ATTACK && !s_opts.quiet &&
+                ((!result.refreshed && !result.blacklist_full) || s_opts.verbose)) {
+                report_attack(station, &result);
+            }
+        }
+    }
+}
+
+static void *replay_thread(void *arg)
+{
+    /*
+    @brief Dona de alguns shards: reproduz os eventos deles em ordem da captura.
+    @note Cada wheel só avança no shard do evento; os demais shards da thread
+    são alcançados no fim. Nenhum estado de shard é compartilhado entre threads.
+    */
+    replay_worker_t *worker = (replay_worker_t *)arg;
+    int index = (int)(worker - s_workers);
+    uint64_t start = now_ns();
+
+    for (size_t i = 0; i < worker->count; i++) {
+        const replay_event_t *e = &worker->events[i];
+        ids_advance_shard(ids_shard_of(e->mac), e->ts_us);
+        feed_event(&worker->run, (ids_dot11_event_t)e->event, e->mac, e->ts_us);
+    }
+    for (int shard = index; shard < IDS_SHARDS; shard += s_opts.threads) {
+        ids_advance_shard((uint8_t)shard, s_now_us);
+    }
+
+    worker->secs = (now_ns() - start) / 1e9;
+    return NULL;
+}
+
+static double replay_run(void)
+{
+    /*
+    @brief Reproduz os eventos guardados em s_opts.threads threads e junta as estatísticas.
+    @return Tempo de parede do replay (s)
+    @note As janelas globais de auth/deauth recebem eventos de threads em
+    pontos diferentes da captura, então as detecções desses dois detectores
+    podem diferir da análise sequencial; o modo serve para medir vazão.
+    */
+    uint64_t start = now_ns();
+    for (int t = 0; t < s_opts.threads; t++) {
+        if (pthread_create(&s_workers[t].thread, NULL, replay_thread, &s_workers[t]) != 0) {
+            fprintf(stderr, "falha ao criar a thread %d\n", t);
+            exit(1);
+        }
+    }
+    for (int t = 0; t < s_opts.threads; t++) {
+        pthread_join(s_workers[t].thread, NULL);
+    }
+    double secs = (now_ns() - start) / 1e9;
+
+    for (int t = 0; t < s_opts.threads; t++) {
+        const ids_run_stats_t *run = &s_workers[t].run;
+        s_run.events += run->events;
+        s_run.allowed += run->allowed;
+        s_run.blocked += run->blocked;
+        s_run.attacks += run->attacks;
+        s_run.blacklist_full += run->blacklist_full;
+        s_run.latency_ns_total += run->latency_ns_total;
+        if (run->latency_ns_max > s_run.latency_ns_max) {
+            s_run.latency_ns_max = run->latency_ns_max;
+        }
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            s_run.latency_hist[b] += run->latency_hist[b];
+        }
+    }
+    return secs;
+}
+
+static void bench_parser(pcap_reader_t *readers, int n_readers, int passes)
+{
+    /*
+    @brief Mede só o leitor e o parsing 802.11 (sem IDS), em passadas repetidas.
+    @note Os contadores por tipo são acumulados para o compilador não eliminar o parsing.
+    */
+    double best = 0, sum = 0;
+    uint64_t frames = 0, checksum = 0;
+
+    for (int p = 0; p < passes; p++) {
+        frames = 0;
+        uint64_t start = now_ns();
+        for (int i = 0; i < n_readers; i++) {
+            pcap_reader_rewind(&readers[i]);
+            pcap_frame_t frame;
+            while (pcap_reader_next(&readers[i], &frame)) {
+                ids_dot11_hdr_t hdr;
+                if (ids_dot11_parse(frame.data, frame.len, &hdr)) {
+                    checksum += hdr.subtype + hdr.addr2[5];
+                }
+                frames++;
+            }
+        }
+        double secs = (now_ns() - start) / 1e9;
+        double rate = secs > 0 ? frames / secs : 0;
+        sum += rate;
+        if (rate > best) {
+            best = rate;
+        }
+    }
+
+    printf("\n=== BENCHMARK DO PARSER (%d passadas, %llu quadros cada) ===\n", passes, (unsigned long long)frames);
+    printf("  Melhor: %.0f quadros/s\n", best);
+    printf("  Media:  %.0f quadros/s\n", sum / passes);
+    if (s_opts.verbose) {
+        printf("  (checksum %llu)\n", (unsigned long long)checksum);
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "uso: %s [opcoes] captura.pcap[ng] ...\n"
+            "  -b, --bssid MAC        considera só quadros deste BSS (como o AP)\n"
+            "  -d, --data             quadros de dados ToDS alimentam o detector de packet flood\n"
+            "      --max-deauth N     desconexoes por janela (padrao %d)\n"
+            "      --max-auth N       autenticacoes por janela (padrao %d)\n"
+            "      --max-packets N    pacotes por cliente por janela (padrao %d)\n"
+            "      --window-ms N      janela de taxa (padrao %d)\n"
+            "      --blacklist-ms N   duracao do bloqueio (padrao %d)\n"
+            "  -q, --quiet            sem uma linha por deteccao\n"
+            "  -v, --verbose          expiracoes, pools e metricas do IDS\n"
+            "      --bench N          N passadas extras só do parser\n"
+            "      --threads N        replay dos eventos em N threads, uma por grupo de shards (%d shards)\n",
+            prog, DEFAULT_MAX_DISCONNECTIONS, DEFAULT_MAX_AUTH_ATTEMPTS, DEFAULT_MAX_PACKETS,
+            DEFAULT_RATE_WINDOW_MS, DEFAULT_BLACKLIST_MS, IDS_SHARDS);
+}
+
+int main(int argc, char **argv)
+{
+    ids_config_t config = {
+        .max_disconnections = DEFAULT_MAX_DISCONNECTIONS,
+        .max_auth_attempts = DEFAULT_MAX_AUTH_ATTEMPTS,
+        .max_packets_per_client = DEFAULT_MAX_PACKETS,
+        .rate_window_ms = DEFAULT_RATE_WINDOW_MS,
+        .blacklist_duration_ms = DEFAULT_BLACKLIST_MS,
+        .monitor_idle_timeout_ms = DEFAULT_MONITOR_IDLE_MS,
+        .on_unblock = ids_unblock_cb,
+    };
+
+    enum { OPT_MAX_DEAUTH = 256, OPT_MAX_AUTH, OPT_MAX_PACKETS, OPT_WINDOW, OPT_BLACKLIST, OPT_BENCH, OPT_THREADS };
+    static const struct option long_opts[] = {
+        {"bssid", required_argument, NULL, 'b'},
+        {"data", no_argument, NULL, 'd'},
+        {"quiet", no_argument, NULL, 'q'},
+        {"verbose", no_argument, NULL, 'v'},
+        {"max-deauth", required_argument, NULL, OPT_MAX_DEAUTH},
+        {"max-auth", required_argument, NULL, OPT_MAX_AUTH},
+        {"max-packets", required_argument, NULL, OPT_MAX_PACKETS},
+        {"window-ms", required_argument, NULL, OPT_WINDOW},
+        {"blacklist-ms", required_argument, NULL, OPT_BLACKLIST},
+        {"bench", required_argument, NULL, OPT_BENCH},
+        {"threads", required_argument, NULL, OPT_THREADS},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "b:dqvh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'b':
+            if (!parse_mac(optarg, s_opts.bssid)) {
+                fprintf(stderr, "BSSID invalido: %s\n", optarg);
+                return 2;
+            }
+            s_opts.has_bssid = true;
+            break;
+        case 'd': s_opts.use_data = true; break;
+        case 'q': s_opts.quiet = true; break;
+        case 'v': s_opts.verbose = true; break;
+        case OPT_MAX_DEAUTH: config.max_disconnections = (uint16_t)atoi(optarg); break;
+        case OPT_MAX_AUTH: config.max_auth_attempts = (uint16_t)atoi(optarg); break;
+        case OPT_MAX_PACKETS: config.max_packets_per_client = (uint16_t)atoi(optarg); break;
+        case OPT_WINDOW: config.rate_window_ms = (uint32_t)atoi(optarg); break;
+        case OPT_BLACKLIST: config.blacklist_duration_ms = (uint32_t)atoi(optarg); break;
+        case OPT_BENCH: s_opts.bench_passes = atoi(optarg); break;
+        case OPT_THREADS: {
+            // Número inteiro entre 1 e IDS_SHARDS; qualquer outra coisa vira -1 (recusado abaixo)
+            char *end;
+            long value = strtol(optarg, &end, 10);
+            s_opts.threads = (end == optarg || *end != '\0' || value < 1 || value > IDS_SHARDS) ? -1 : (int)value;
+            break;
+        }
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    int n_readers = argc - optind;
+    if (n_readers <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (s_opts.threads < 0 || s_opts.threads > IDS_SHARDS) {
+        fprintf(stderr, "--threads deve estar entre 1 e %d (IDS_SHARDS)\n", IDS_SHARDS);
+        return 2;
+    }
+    if (s_opts.threads > 0) {
+        s_workers = calloc((size_t)s_opts.threads, sizeof(*s_workers));
+        if (s_workers == NULL) {
+            return 1;
+        }
+    }
+
+    pcap_reader_t *readers = calloc((size_t)n_readers, sizeof(*readers));
+    if (readers == NULL) {
+        return 1;
+    }
+    uint64_t file_bytes = 0;
+    for (int i = 0; i < n_readers; i++) {
+        if (pcap_reader_open(&readers[i], argv[optind + i]) != 0) {
+            return 1;
+        }
+        file_bytes += readers[i].size;
+    }
+
+    ids_init(&config, 0);
+
+    frame_stats_t stats = {0};
+    uint64_t start = now_ns();
+    analyze(readers, n_readers, &stats);
+    double secs = (now_ns() - start) / 1e9;
+    double replay_secs = s_opts.threads > 0 ? replay_run() : 0;
+
+    uint64_t skipped = 0;
+    for (int i = 0; i < n_readers; i++) {
+        skipped += readers[i].skipped;
+        if (readers[i].truncated) {
+            fprintf(stderr, "aviso: %s termina no meio de um registro\n", argv[optind + i]);
+        }
+    }
+
+    ids_stats_t ids_stats;
+    ids_get_stats(&ids_stats);
+
+    printf("\n=== CAPTURA ===\n");
+    printf("  Quadros: %llu (%llu ignorados pelo leitor, %llu sem cabecalho 802.11 util)\n",
+           (unsigned long long)stats.frames, (unsigned long long)skipped, (unsigned long long)stats.unparsed);
+    printf("  Auth: %llu  Assoc/Reassoc: %llu  Deauth: %llu  Disassoc: %llu  Beacon: %llu  Outros mgmt: %llu  Dados: %llu\n",
+           (unsigned long long)stats.auth, (unsigned long long)stats.assoc, (unsigned long long)stats.deauth,
+           (unsigned long long)stats.disassoc, (unsigned long long)stats.beacon,
+           (unsigned long long)stats.other_mgmt, (unsigned long long)stats.data);
+    printf("  Duracao da captura: %.3f s\n", s_now_us / 1e6);
+
+    printf("\n=== IDS ===\n");
+    printf("  Eventos: %llu (normais %llu, de MACs bloqueados %llu, ataques %llu)\n",
+           (unsigned long long)s_run.events, (unsigned long long)s_run.allowed,
+           (unsigned long long)s_run.blocked, (unsigned long long)s_run.attacks);
+    printf("  Deauth Floods: %u  Auth Floods: %u  Packet Floods: %u\n",
+           (unsigned)ids_stats.deauth_floods, (unsigned)ids_stats.auth_floods, (unsigned)ids_stats.packet_floods);
+    printf("  MACs bloqueados: %u (ativos no fim: %u/%d, expirados: %llu, recusados por blacklist cheia: %llu)\n",
+           (unsigned)ids_stats.blacklist_additions, ids_stats.blacklist_active, IDS_BLACKLIST_CAPACITY * IDS_SHARDS,
+           (unsigned long long)s_run.expired, (unsigned long long)s_run.blacklist_full);
+
+    printf("\n=== DESEMPENHO ===\n");
+    printf("  %s: %.3f s  (%.0f quadros/s, %.1f MB/s do arquivo)\n",
+           s_opts.threads > 0 ? "Leitura e decodificacao" : "Tempo total", secs,
+           secs > 0 ? stats.frames / secs : 0, secs > 0 ? file_bytes / secs / 1e6 : 0);
+    if (s_opts.threads > 0) {
+        printf("  Replay: %d threads, %d shards: %.3f s  (%.0f eventos/s)\n", s_opts.threads, IDS_SHARDS,
+               replay_secs, replay_secs > 0 ? s_run.events / replay_secs : 0);
+        for (int t = 0; t < s_opts.threads; t++) {
+            printf("    Thread %d: %zu eventos em %.3f s\n", t, s_workers[t].count, s_workers[t].secs);
+        }
+    }
+    if (s_run.events > 0) {
+        printf("  Latencia por evento do IDS: media %llu ns, p50 <= %llu ns, p99 <= %llu ns, max %llu ns\n",
+               (unsigned long long)(s_run.latency_ns_total / s_run.events),
+               (unsigned long long)latency_percentile(0.50), (unsigned long long)latency_percentile(0.99),
+               (unsigned long long)s_run.latency_ns_max);
+    }
+
+    if (s_opts.verbose) {
+        printf("\n");
+        mem_pool_log_all("ids_host");
+        metrics_log_all("ids_host");
+    }
+
+    if (s_opts.bench_passes > 0) {
+        bench_parser(readers, n_readers, s_opts.bench_passes);
+    }
+
+    for (int i = 0; i < n_readers; i++) {
+        pcap_reader_close(&readers[i]);
+    }
+    free(readers);
+    for (int t = 0; t < s_opts.threads; t++) {
+        free(s_workers[t].events);
+    }
+    free(s_workers);
+    return 0;
+}
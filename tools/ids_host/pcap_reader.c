@@ -0,0 +1,284 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "pcap_reader.h"
+
+#define PCAP_MAGIC_US       0xA1B2C3D4u
+#define PCAP_MAGIC_NS       0xA1B23C4Du
+#define PCAP_FILE_HEADER    24
+#define PCAP_RECORD_HEADER  16
+
+#define PCAPNG_SHB          0x0A0D0D0Au
+#define PCAPNG_IDB          0x00000001u
+#define PCAPNG_SPB          0x00000003u
+#define PCAPNG_EPB          0x00000006u
+#define PCAPNG_BOM          0x1A2B3C4Du
+#define PCAPNG_OPT_TSRESOL  9
+
+#define LINKTYPE_IEEE802_11          105
+#define LINKTYPE_IEEE802_11_RADIOTAP 127
+
+static inline uint16_t rd16(const pcap_reader_t *r, const uint8_t *p)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return r->swapped ? __builtin_bswap16(v) : v;
+}
+
+static inline uint32_t rd32(const pcap_reader_t *r, const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return r->swapped ? __builtin_bswap32(v) : v;
+}
+
+static uint64_t pcapng_ts_to_us(uint64_t ts, uint8_t tsresol)
+{
+    // if_tsresol: bit 7 = 0 -> 10^-n s, bit 7 = 1 -> 2^-n s
+    uint8_t n = tsresol & 0x7F;
+
+    if (tsresol & 0x80) {
+        return (uint64_t)(((unsigned __int128)ts * 1000000u) >> n);
+    }
+    for (; n < 6; n++) {
+        ts *= 10;
+    }
+    for (; n > 6; n--) {
+        ts /= 10;
+    }
+    return ts;
+}
+
+static bool pcap_deliver(pcap_reader_t *r, uint16_t linktype, const uint8_t *data, uint32_t caplen,
+                         uint64_t ts_us, pcap_frame_t *frame)
+{
+    /*
+    @brief Remove o cabeçalho de enlace e preenche o quadro devolvido.
+    @return false se o registro deve ser pulado (contado em skipped)
+    */
+    if (linktype == LINKTYPE_IEEE802_11_RADIOTAP) {
+        // O cabeçalho radiotap é sempre little endian, independente do arquivo
+        if (caplen < 4) {
+            r->skipped++;
+            return false;
+        }
+        uint16_t it_len = (uint16_t)(data[2] | (data[3] << 8));
+        if (it_len > caplen) {
+            r->skipped++;
+            return false;
+        }
+        data += it_len;
+        caplen -= it_len;
+    } else if (linktype != LINKTYPE_IEEE802_11) {
+        r->skipped++;
+        return false;
+    }
+
+    frame->data = data;
+    frame->len = caplen;
+    frame->ts_us = ts_us;
+    r->last_ts_us = ts_us;
+    return true;
+}
+
+static bool pcap_next_classic(pcap_reader_t *r, pcap_frame_t *frame)
+{
+    while (r->off < r->size) {
+        if (r->size - r->off < PCAP_RECORD_HEADER) {
+            r->truncated = true;
+            return false;
+        }
+
+        const uint8_t *p = r->base + r->off;
+        uint32_t ts_sec = rd32(r, p);
+        uint32_t ts_frac = rd32(r, p + 4);
+        uint32_t caplen = rd32(r, p + 8);
+
+        if (r->size - r->off - PCAP_RECORD_HEADER < caplen) {
+            r->truncated = true;
+            return false;
+        }
+        r->off += PCAP_RECORD_HEADER + caplen;
+
+        uint64_t ts_us = (uint64_t)ts_sec * 1000000u + (r->nanosecond ? ts_frac / 1000 : ts_frac);
+        if (pcap_deliver(r, r->linktype, p + PCAP_RECORD_HEADER, caplen, ts_us, frame)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void pcapng_parse_idb(pcap_reader_t *r, const uint8_t *p, uint32_t len)
+{
+    if (r->n_ifaces >= PCAP_READER_MAX_IFACES || len < 20) {
+        r->n_ifaces++;
+        return;
+    }
+
+    uint32_t i = r->n_ifaces++;
+    r->if_linktype[i] = rd16(r, p + 8);
+    r->if_tsresol[i] = 6;
+
+    // Opções: código u16, tamanho u16, valor alinhado em 4 bytes
+    uint32_t opt = 16;
+    while (opt + 4 <= len - 4) {
+        uint16_t code = rd16(r, p + opt);
+        uint16_t olen = rd16(r, p + opt + 2);
+        if (code == 0 || opt + 4 + olen > len - 4) {
+            break;
+        }
+        if (code == PCAPNG_OPT_TSRESOL && olen >= 1) {
+            r->if_tsresol[i] = p[opt + 4];
+        }
+        opt += 4 + ((olen + 3u) & ~3u);
+    }
+}
+
+static bool pcap_next_pcapng(pcap_reader_t *r, pcap_frame_t *frame)
+{
+    while (r->off < r->size) {
+        if (r->size - r->off < 12) {
+            r->truncated = true;
+            return false;
+        }
+
+        const uint8_t *p = r->base + r->off;
+        uint32_t type = rd32(r, p);
+
+        if (type == PCAPNG_SHB || type == __builtin_bswap32(PCAPNG_SHB)) {
+            // Nova seção: a ordem de bytes vem do byte-order magic e as interfaces recomeçam
+            uint32_t bom;
+            memcpy(&bom, p + 8, sizeof(bom));
+            if (bom != PCAPNG_BOM && bom != __builtin_bswap32(PCAPNG_BOM)) {
+                r->truncated = true;
+                return false;
+            }
+            r->swapped = (bom != PCAPNG_BOM);
+            r->n_ifaces = 0;
+        }
+
+        uint32_t len = rd32(r, p + 4);
+        if (len < 12 || (len & 3) || len > r->size - r->off) {
+            r->truncated = true;
+            return false;
+        }
+        r->off += len;
+
+        if (type == PCAPNG_IDB) {
+            pcapng_parse_idb(r, p, len);
+        } else if (type == PCAPNG_EPB && len >= 32) {
+            uint32_t iface = rd32(r, p + 8);
+            uint64_t ts = ((uint64_t)rd32(r, p + 12) << 32) | rd32(r, p + 16);
+            uint32_t caplen = rd32(r, p + 20);
+
+            if (caplen > len - 32 || iface >= r->n_ifaces || iface >= PCAP_READER_MAX_IFACES) {
+                r->skipped++;
+                continue;
+            }
+            if (pcap_deliver(r, r->if_linktype[iface], p + 28, caplen,
+                             pcapng_ts_to_us(ts, r->if_tsresol[iface]), frame)) {
+                return true;
+            }
+        } else if (type == PCAPNG_SPB && len >= 16) {
+            // Simple Packet Block: interface 0 e sem timestamp (herda o anterior)
+            uint32_t caplen = rd32(r, p + 8);
+            if (caplen > len - 16) {
+                caplen = len - 16;
+            }
+            if (r->n_ifaces == 0) {
+                r->skipped++;
+                continue;
+            }
+            if (pcap_deliver(r, r->if_linktype[0], p + 12, caplen, r->last_ts_us, frame)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int pcap_reader_open(pcap_reader_t *reader, const char *path)
+{
+    /*
+    @brief Mapeia o arquivo e identifica o formato (.pcap em µs/ns ou .pcapng).
+    @return 0 em sucesso, -1 em erro (mensagem em stderr)
+    */
+    memset(reader, 0, sizeof(*reader));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < PCAP_FILE_HEADER) {
+        fprintf(stderr, "%s: arquivo vazio ou ilegível\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "%s: mmap: %s\n", path, strerror(errno));
+        return -1;
+    }
+    // Leitura estritamente sequencial: deixa o kernel antecipar as páginas
+    madvise(base, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    reader->base = base;
+    reader->size = (size_t)st.st_size;
+
+    uint32_t magic;
+    memcpy(&magic, reader->base, sizeof(magic));
+
+    if (magic == PCAPNG_SHB) {
+        reader->pcapng = true;
+        reader->first = 0;
+    } else if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS ||
+               magic == __builtin_bswap32(PCAP_MAGIC_US) || magic == __builtin_bswap32(PCAP_MAGIC_NS)) {
+        reader->swapped = (magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS);
+        reader->nanosecond = (rd32(reader, reader->base) == PCAP_MAGIC_NS);
+        reader->linktype = (uint16_t)rd32(reader, reader->base + 20);
+        reader->first = PCAP_FILE_HEADER;
+        if (reader->linktype != LINKTYPE_IEEE802_11 && reader->linktype != LINKTYPE_IEEE802_11_RADIOTAP) {
+            fprintf(stderr, "%s: link type %u não suportado (esperado 105 ou 127)\n", path, reader->linktype);
+            pcap_reader_close(reader);
+            return -1;
+        }
+    } else {
+        fprintf(stderr, "%s: formato desconhecido (magic 0x%08x)\n", path, magic);
+        pcap_reader_close(reader);
+        return -1;
+    }
+
+    reader->off = reader->first;
+    return 0;
+}
+
+bool pcap_reader_next(pcap_reader_t *reader, pcap_frame_t *frame)
+{
+    return reader->pcapng ? pcap_next_pcapng(reader, frame) : pcap_next_classic(reader, frame);
+}
+
+void pcap_reader_rewind(pcap_reader_t *reader)
+{
+    reader->off = reader->first;
+    reader->n_ifaces = 0;
+    reader->skipped = 0;
+    reader->truncated = false;
+    reader->last_ts_us = 0;
+}
+
+void pcap_reader_close(pcap_reader_t *reader)
+{
+    if (reader->base != NULL) {
+        munmap((void *)reader->base, reader->size);
+    }
+    memset(reader, 0, sizeof(*reader));
+}
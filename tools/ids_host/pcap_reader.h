@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Leitor de capturas .pcap e .pcapng sem cópia: o arquivo é mapeado com mmap
+ * e cada quadro devolvido aponta direto para o mapeamento (válido até
+ * pcap_reader_close). Link types aceitos: 105 (IEEE 802.11) e 127 (802.11 +
+ * radiotap, o formato de tools/pcap/pcap_receiver.py); o cabeçalho radiotap é
+ * pulado e o quadro começa no Frame Control.
+ */
+
+#define PCAP_READER_MAX_IFACES 8
+
+typedef struct {
+    const uint8_t *data;    // quadro 802.11
+    uint32_t len;           // bytes capturados do quadro
+    uint64_t ts_us;         // timestamp em µs
+} pcap_frame_t;
+
+typedef struct {
+    const uint8_t *base;
+    size_t size;
+    size_t off;
+    size_t first;           // primeiro registro (após os cabeçalhos de arquivo)
+    bool pcapng;
+    bool swapped;           // ordem de bytes do arquivo diferente da do host
+    uint64_t last_ts_us;
+
+    // .pcap: um único link type e resolução
+    uint16_t linktype;
+    bool nanosecond;
+
+    // .pcapng: link type e resolução por interface (na seção corrente)
+    uint32_t n_ifaces;
+    uint16_t if_linktype[PCAP_READER_MAX_IFACES];
+    uint8_t if_tsresol[PCAP_READER_MAX_IFACES];
+
+    uint64_t skipped;       // registros de link type não suportado ou sem espaço para o radiotap
+    bool truncated;         // o arquivo terminou no meio de um registro
+} pcap_reader_t;
+
+// 0 em sucesso; -1 com a mensagem de erro já impressa em stderr
+int pcap_reader_open(pcap_reader_t *reader, const char *path);
+
+// Próximo quadro 802.11; false no fim do arquivo
+bool pcap_reader_next(pcap_reader_t *reader, pcap_frame_t *frame);
+
+// Volta ao primeiro registro (passadas repetidas do benchmark)
+void pcap_reader_rewind(pcap_reader_t *reader);
+
+void pcap_reader_close(pcap_reader_t *reader);
@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+Receptor do stream de captura do AP (components/pcap_stream) -> arquivo .pcapng.
+
+O AP envia pela UART de captura chunks com Enhanced Packet Blocks prontos:
+
+    magic A5 5A 50 43 | seq u16 | len u16 | dropped u32 | EPBs | crc32 u32   (little endian)
+
+Este script escreve o Section Header Block e o Interface Description Block
+(LINKTYPE_IEEE802_11_RADIOTAP), valida cada chunk (CRC-32 IEEE, igual ao
+esp_rom_crc32_le(0, ...)), copia os EPBs para o arquivo e contabiliza perdas:
+chunks corrompidos, saltos de sequência e quadros descartados no próprio AP.
+
+    python3 tools/pcap/pcap_receiver.py /dev/ttyUSB1 -o incidente.pcapng
+    python3 tools/pcap/pcap_receiver.py --input dump.bin -o incidente.pcapng   # stream gravado em arquivo
+"""
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+CHUNK_MAGIC = b"\xA5\x5A\x50\x43"
+CHUNK_HEADER = struct.Struct("<4sHHI")
+MAX_CHUNK_LEN = 4096
+LINKTYPE_IEEE802_11_RADIOTAP = 127
+SNAPLEN = 256 + 15
+
+
+def pcapng_header():
+    shb_body = struct.pack("<IHHq", 0x1A2B3C4D, 1, 0, -1)
+    shb = struct.pack("<II", 0x0A0D0D0A, 12 + len(shb_body)) + shb_body + struct.pack("<I", 12 + len(shb_body))
+    # if_tsresol = 6 (microssegundos, padrão) explícito
+    opts = struct.pack("<HHB3x", 9, 1, 6) + struct.pack("<HH", 0, 0)
+    idb_body = struct.pack("<HHI", LINKTYPE_IEEE802_11_RADIOTAP, 0, SNAPLEN) + opts
+    idb = struct.pack("<II", 1, 12 + len(idb_body)) + idb_body + struct.pack("<I", 12 + len(idb_body))
+    return shb + idb
+
+
+class ChunkParser:
+    def __init__(self, out):
+        self.out = out
+        self.buf = bytearray()
+        self.expected_seq = None
+        self.chunks = 0
+        self.frames = 0
+        self.bad_crc = 0
+        self.lost_chunks = 0
+        self.resync_bytes = 0
+        self.device_dropped = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(CHUNK_MAGIC)
+            if start < 0:
+                # Guarda só o suficiente para um magic partido entre leituras
+                keep = len(CHUNK_MAGIC) - 1
+                self.resync_bytes += max(0, len(self.buf) - keep)
+                del self.buf[:-keep or None]
+                return
+            if start > 0:
+                self.resync_bytes += start
+                del self.buf[:start]
+            if len(self.buf) < CHUNK_HEADER.size:
+                return
+            _, seq, length, dropped = CHUNK_HEADER.unpack_from(self.buf)
+            if length > MAX_CHUNK_LEN:
+                # Falso magic dentro de dados: pula um byte e procura de novo
+                del self.buf[:1]
+                self.resync_bytes += 1
+                continue
+            total = CHUNK_HEADER.size + length + 4
+            if len(self.buf) < total:
+                return
+            body = bytes(self.buf[:CHUNK_HEADER.size + length])
+            (crc,) = struct.unpack_from("<I", self.buf, CHUNK_HEADER.size + length)
+            if zlib.crc32(body) != crc:
+                self.bad_crc += 1
+                del self.buf[:1]
+                continue
+            del self.buf[:total]
+            self.accept(seq, dropped, body[CHUNK_HEADER.size:])
+
+    def accept(self, seq, dropped, blocks):
+        if self.expected_seq is not None and seq != self.expected_seq:
+            self.lost_chunks += (seq - self.expected_seq) & 0xFFFF
+        self.expected_seq = (seq + 1) & 0xFFFF
+        self.device_dropped = dropped
+        self.chunks += 1
+        self.frames += count_blocks(blocks)
+        self.out.write(blocks)
+
+    def summary(self):
+        return (f"chunks={self.chunks} quadros={self.frames} descartados_no_ap={self.device_dropped} "
+                f"chunks_perdidos={self.lost_chunks} crc_invalido={self.bad_crc} bytes_ressinc={self.resync_bytes}")
+
+
+def count_blocks(blocks):
+    count, offset = 0, 0
+    while offset + 8 <= len(blocks):
+        (block_len,) = struct.unpack_from("<I", blocks, offset + 4)
+        if block_len < 12:
+            break
+        count += 1
+        offset += block_len
+    return count
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?", help="porta serial da UART de captura")
+    parser.add_argument("-b", "--baud", type=int, default=2000000)
+    parser.add_argument("-o", "--output", required=True, help="arquivo .pcapng de saída")
+    parser.add_argument("--input", help="lê o stream de um arquivo em vez da serial")
+    parser.add_argument("--duration", type=float, default=0, help="segundos de captura (0 = até Ctrl+C)")
+    args = parser.parse_args()
+
+    if not args.port and not args.input:
+        parser.error("informe a porta serial ou --input")
+
+    with open(args.output, "wb") as out:
+        out.write(pcapng_header())
+        chunk_parser = ChunkParser(out)
+
+        if args.input:
+            with open(args.input, "rb") as f:
+                chunk_parser.feed(f.read())
+            print(chunk_parser.summary())
+            return
+
+        import serial  # pyserial, já instalado no ambiente do ESP-IDF
+
+        ser = serial.Serial(args.port, args.baud, timeout=0.2)
+        start = last_report = time.time()
+        try:
+            while not args.duration or time.time() - start < args.duration:
+                data = ser.read(8192)
+                if data:
+                    chunk_parser.feed(data)
+                if time.time() - last_report >= 5:
+                    print(chunk_parser.summary(), flush=True)
+                    out.flush()
+                    last_report = time.time()
+        except KeyboardInterrupt:
+            pass
+        finally:
+            ser.close()
+        print(chunk_parser.summary())
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+Simboliza as amostras do profiler do AP (AP/main/profiler.c) e gera pilhas
+dobradas ("folded stacks") para flame graphs.
+
+O AP exporta em GET /profile uma amostra por linha:
+
+    <núcleo> <task> <pc> [<retorno> ...]      (PC interrompido primeiro)
+
+Os endereços são resolvidos de uma vez com o addr2line da toolchain contra o
+ELF do build, e cada amostra vira "task;chamador;...;função 1" (raiz primeiro),
+somando as pilhas iguais. A saída serve direto para o flamegraph.pl ou para o
+speedscope:
+
+    curl -s "http://192.168.4.1/profile?start=2000"; sleep 2.5
+    curl -s http://192.168.4.1/profile > amostras.txt
+    python3 tools/profiler/fold_stacks.py AP/build/AP.elf amostras.txt > ap.folded
+    flamegraph.pl ap.folded > ap.svg
+"""
+import argparse
+import collections
+import subprocess
+import sys
+
+
+def parse_samples(lines):
+    # Devolve (núcleo, task, [pc, retorno, ...]) por amostra; cabeçalhos '#' vão para stderr
+    samples = []
+    for line in lines:
+        line = line.strip()
+        if not line:
+            continue
+        if line.startswith("#"):
+            print(line, file=sys.stderr)
+            continue
+        fields = line.split()
+        if len(fields) < 3:
+            continue
+        try:
+            pcs = [int(f, 16) for f in fields[2:]]
+        except ValueError:
+            continue
+        samples.append((fields[0], fields[1], pcs))
+    return samples
+
+
+def symbolize(addr2line, elf, addresses):
+    # Uma chamada só do addr2line para todos os endereços distintos (-f: função, -C: demangle)
+    addresses = sorted(addresses)
+    if not addresses:
+        return {}
+    query = "\n".join("0x%08x" % a for a in addresses) + "\n"
+    try:
+        out = subprocess.run([addr2line, "-f", "-C", "-e", elf], input=query, capture_output=True,
+                             text=True, check=True).stdout.splitlines()
+    except FileNotFoundError:
+        sys.exit("addr2line nao encontrado: %s (use --addr2line ou o ambiente do ESP-IDF)" % addr2line)
+
+    names = {}
+    for i, addr in enumerate(addresses):
+        func = out[2 * i] if 2 * i < len(out) else "??"
+        names[addr] = func if func != "??" else "0x%08x" % addr
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="ELF do build do AP (build/AP.elf)")
+    parser.add_argument("samples", nargs="?", help="saída de GET /profile (padrão: stdin)")
+    parser.add_argument("--addr2line", default="xtensa-esp32-elf-addr2line")
+    parser.add_argument("--per-core", action="store_true", help="separa as pilhas por núcleo (cpu0;task;...)")
+    parser.add_argument("--no-task", action="store_true", help="não usa a task como raiz da pilha")
+    args = parser.parse_args()
+
+    if args.samples:
+        with open(args.samples) as f:
+            samples = parse_samples(f)
+    else:
+        samples = parse_samples(sys.stdin)
+
+    names = symbolize(args.addr2line, args.elf, {pc for _, _, pcs in samples for pc in pcs})
+
+    folded = collections.Counter()
+    for core, task, pcs in samples:
+        frames = [names[pc] for pc in reversed(pcs)]
+        if not args.no_task:
+            frames.insert(0, task)
+        if args.per_core:
+            frames.insert(0, "cpu" + core)
+        folded[";".join(frames)] += 1
+
+    for stack, count in folded.most_common():
+        print("%s %d" % (stack, count))
+    print("%d amostras, %d pilhas distintas" % (len(samples), len(folded)), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()